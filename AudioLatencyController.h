@@ -0,0 +1,104 @@
+//
+//  AudioLatencyController.h
+//  Plum
+//
+
+#pragma once
+
+#include <algorithm>
+
+#include "core/clowncommon/clowncommon.h"
+
+// Decides how quickly the audio device should consume queued audio, and how much audio should be queued at all.
+// It is updated once per emulated frame with the measured queue level, and has no dependencies on the audio backend,
+// so that it can be driven by a simulated consumer clock.
+//
+// The consumption ratio comes from a PI controller acting on the difference between the (smoothed) queue level and the
+// target, clamped to +/-0.5% so that the pitch change is inaudible. The integral term absorbs any constant mismatch
+// between the emulated and host audio clocks, leaving the proportional term to deal with jitter.
+//
+// The target starts out generous and is shrunk in small steps for as long as the host keeps up, down to a floor of
+// roughly two emulated frames. Only genuine underruns grow it again.
+class AudioLatencyController
+{
+public:
+    static constexpr double MAXIMUM_RATIO_DEVIATION = 0.005;
+
+private:
+    cc_u32f minimum_target_frames;
+    cc_u32f maximum_target_frames;
+    cc_u32f updates_per_shrink;
+    double integral_updates;
+
+    cc_u32f target_frames;
+    double smoothed_queued_frames;
+    double integral = 0.0;
+    double ratio = 1.0;
+    cc_u32f updates_since_underrun = 0;
+    cc_u32f last_total_underruns = 0;
+    bool first_update = true;
+
+    void SetTargetFrames(const cc_u32f frames)
+    {
+        target_frames = std::clamp(frames, minimum_target_frames, maximum_target_frames);
+    }
+
+public:
+    // 'updates_per_second' is the emulated framerate.
+    AudioLatencyController(const cc_u32f initial_target_frames, const cc_u32f minimum_target_frames, const cc_u32f maximum_target_frames, const cc_u32f updates_per_second)
+        : minimum_target_frames(minimum_target_frames)
+        , maximum_target_frames(std::max(minimum_target_frames, maximum_target_frames))
+        , updates_per_shrink(updates_per_second * 2) // Two seconds without an underrun.
+        , integral_updates(updates_per_second * 60.0)
+        , smoothed_queued_frames(initial_target_frames)
+    {
+        SetTargetFrames(initial_target_frames);
+    }
+
+    // 'total_underruns' is a running count from the consumer; only changes to it matter.
+    // Returns the ratio at which the consumer should play audio back, where values above 1 drain the queue.
+    double Update(const cc_u32f queued_frames, const cc_u32f total_underruns)
+    {
+        // The queue level jumps by a whole device period each time the consumer runs, so smooth it out
+        // to stop the ratio from dithering.
+        smoothed_queued_frames += (queued_frames - smoothed_queued_frames) * 0.1;
+
+        if (!first_update && total_underruns != last_total_underruns)
+        {
+            // Grow by half, but only once per update no matter how many underruns there were,
+            // as a stall (such as the emulator being paused) produces a long burst of them.
+            SetTargetFrames(target_frames + target_frames / 2);
+            updates_since_underrun = 0;
+        }
+        else if (++updates_since_underrun >= updates_per_shrink)
+        {
+            SetTargetFrames(target_frames - target_frames / 16);
+            updates_since_underrun = 0;
+        }
+
+        first_update = false;
+        last_total_underruns = total_underruns;
+
+        // Normalise the error so that the gains do not depend on the sample rate or the target.
+        const double error = (smoothed_queued_frames - target_frames) / target_frames;
+
+        // A full target's worth of error saturates the proportional term. At 0.5%, draining that much takes
+        // in the region of ten seconds, so the integral term is made several times slower than that to avoid
+        // overshooting.
+        const double proportional = error * MAXIMUM_RATIO_DEVIATION;
+        integral = std::clamp(integral + error * (MAXIMUM_RATIO_DEVIATION / integral_updates), -MAXIMUM_RATIO_DEVIATION, MAXIMUM_RATIO_DEVIATION);
+
+        ratio = 1.0 + std::clamp(proportional + integral, -MAXIMUM_RATIO_DEVIATION, MAXIMUM_RATIO_DEVIATION);
+        return ratio;
+    }
+
+    // When the queue is this far beyond anything the controller would ask for (after a stall, for instance),
+    // the ratio alone would take minutes to drain it, so the caller should discard audio instead.
+    bool ShouldDrop(const cc_u32f queued_frames) const
+    {
+        return queued_frames >= maximum_target_frames * 2;
+    }
+
+    cc_u32f GetTargetFrames() const { return target_frames; }
+    double GetRatio() const { return ratio; }
+};
@@ -0,0 +1,270 @@
+//
+//  AudioLatencyControllerChecker.cpp
+//  Plum
+//
+
+// Drives an 'AudioLatencyController' offline, against a simulated audio device whose clock is skewed against the
+// emulator's and whose callbacks (like the emulator's frames) arrive with scheduling jitter. The controller is set up
+// exactly as 'AudioOutput' sets it up, and each scenario checks one of the things that it promises to do.
+// Build it with something like:
+//
+//     g++ -std=c++17 -O2 -ICore/include AudioLatencyControllerChecker.cpp -o audio-latency-controller-checker
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "AudioLatencyController.h"
+
+namespace
+{
+    constexpr cc_u32f SAMPLE_RATE = 48000;
+    constexpr cc_u32f FRAMERATE = 60;
+    constexpr cc_u32f FRAMES_PER_UPDATE = SAMPLE_RATE / FRAMERATE;
+    constexpr cc_u32f DEVICE_PERIOD = 512; // What 'BufferSizeFromSampleRate' gives for 48kHz.
+    constexpr double RATIO_TOLERANCE = 1e-9;
+
+    // Matches 'CreateLatencyController' in AudioOutput.mm.
+    AudioLatencyController CreateLatencyController()
+    {
+        return AudioLatencyController(
+            std::max<cc_u32f>(DEVICE_PERIOD * 2, SAMPLE_RATE / 20),
+            SAMPLE_RATE / FRAMERATE * 2 + DEVICE_PERIOD,
+            SAMPLE_RATE / 8,
+            FRAMERATE
+        );
+    }
+
+    class Random
+    {
+    private:
+        cc_u32f state = 1;
+
+    public:
+        // Uniform in [0, 1).
+        double Next()
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            state &= 0xFFFFFFFF;
+            return state / 4294967296.0;
+        }
+    };
+
+    struct Scenario
+    {
+        const char *name;
+        double seconds;
+        double skew;   // How much faster than nominal the device's clock runs.
+        double jitter; // The most that any frame or device callback is late by, in seconds.
+
+        // A stretch of time during which one side does nothing at all.
+        double stall_start = 0.0;
+        double stall_length = 0.0;
+        bool device_stalls = false; // Otherwise, the emulator does.
+    };
+
+    struct Result
+    {
+        double largest_deviation = 0.0;   // The furthest that the ratio ever strayed from 1.
+        double last_underrun_time = -1.0; // -1 if there were none.
+        cc_u32f total_underruns = 0;
+        cc_u32f largest_queue = 0;
+        cc_u32f final_target = 0;
+        double mean_ratio = 0.0;          // Over the last tenth of the run.
+
+        // The update that first saw the underruns caused by the stall.
+        cc_u32f stall_underruns = 0;
+        cc_u32f target_before_stall = 0;
+        cc_u32f target_after_stall = 0;
+    };
+
+    Result Run(const Scenario &scenario)
+    {
+        AudioLatencyController controller = CreateLatencyController();
+        Random random;
+        Result result;
+
+        const double update_interval = 1.0 / FRAMERATE;
+        const double device_interval = DEVICE_PERIOD / (SAMPLE_RATE * (1.0 + scenario.skew));
+        const double stall_end = scenario.stall_start + scenario.stall_length;
+
+        // Moves on to the next frame or callback, skipping over any that would fall within this side's stall.
+        const auto Advance = [&](cc_u32f &index, const double interval, const bool is_device)
+        {
+            ++index;
+
+            if (is_device == scenario.device_stalls && index * interval >= scenario.stall_start && index * interval < stall_end)
+                index = static_cast<cc_u32f>(std::ceil(stall_end / interval));
+
+            return index * interval + random.Next() * scenario.jitter;
+        };
+
+        double queued_frames = 0.0;
+        double ratio = 1.0;
+        double ratio_total = 0.0;
+        cc_u32f ratio_count = 0;
+        bool stall_seen = false;
+
+        cc_u32f update = 0, callback = 0;
+        double next_update = 0.0, next_callback = device_interval;
+
+        while (std::min(next_update, next_callback) < scenario.seconds)
+        {
+            if (next_update <= next_callback)
+            {
+                // An emulated frame: exactly what 'AudioOutput::OutputFrame' does.
+                const cc_u32f underruns_before = result.total_underruns;
+                const cc_u32f target_before = controller.GetTargetFrames();
+
+                ratio = controller.Update(static_cast<cc_u32f>(queued_frames), result.total_underruns);
+
+                if (!controller.ShouldDrop(static_cast<cc_u32f>(queued_frames)))
+                    queued_frames += FRAMES_PER_UPDATE;
+
+                if (!stall_seen && scenario.stall_length != 0.0 && next_update >= stall_end)
+                {
+                    stall_seen = true;
+                    result.stall_underruns = underruns_before;
+                    result.target_before_stall = target_before;
+                    result.target_after_stall = controller.GetTargetFrames();
+                }
+
+                result.largest_deviation = std::max(result.largest_deviation, std::fabs(ratio - 1.0));
+                result.largest_queue = std::max(result.largest_queue, static_cast<cc_u32f>(queued_frames));
+
+                if (next_update >= scenario.seconds * 0.9)
+                {
+                    ratio_total += ratio;
+                    ++ratio_count;
+                }
+
+                next_update = Advance(update, update_interval, false);
+            }
+            else
+            {
+                // A device callback, which plays a period's worth of audio at the current ratio.
+                const double frames_wanted = DEVICE_PERIOD * ratio;
+
+                if (queued_frames < frames_wanted)
+                {
+                    queued_frames = 0.0;
+                    ++result.total_underruns;
+                    result.last_underrun_time = next_callback;
+                }
+                else
+                {
+                    queued_frames -= frames_wanted;
+                }
+
+                next_callback = Advance(callback, device_interval, true);
+            }
+        }
+
+        result.final_target = controller.GetTargetFrames();
+        result.mean_ratio = ratio_count == 0 ? 1.0 : ratio_total / ratio_count;
+        return result;
+    }
+
+    bool all_passed = true;
+
+    void Check(const char* const scenario, const char* const description, const bool passed)
+    {
+        std::printf("  %s: %s\n", passed ? "pass" : "FAIL", description);
+
+        if (!passed)
+        {
+            std::fprintf(stderr, "Scenario '%s' failed: %s\n", scenario, description);
+            all_passed = false;
+        }
+    }
+
+    void Print(const Scenario &scenario, const Result &result)
+    {
+        std::printf("%s (%.0fs, skew %+.2f%%, jitter %.0fms):\n", scenario.name, scenario.seconds, scenario.skew * 100.0, scenario.jitter * 1000.0);
+        std::printf("  largest ratio deviation %.4f%%, mean ratio %.5f, %lu underruns (last at %.2fs), largest queue %lu, final target %lu\n",
+            result.largest_deviation * 100.0, result.mean_ratio, static_cast<unsigned long>(result.total_underruns), result.last_underrun_time,
+            static_cast<unsigned long>(result.largest_queue), static_cast<unsigned long>(result.final_target));
+    }
+}
+
+int main()
+{
+    const AudioLatencyController reference = CreateLatencyController();
+    const cc_u32f initial_target = reference.GetTargetFrames();
+    const cc_u32f minimum_target = SAMPLE_RATE / FRAMERATE * 2 + DEVICE_PERIOD;
+    const cc_u32f maximum_target = SAMPLE_RATE / 8;
+
+    // With a skewed clock, the ratio has to settle on whatever cancels the skew, and the target has to shrink all the way.
+    for (const double skew : {0.004, -0.004})
+    {
+        const Scenario scenario = {skew > 0.0 ? "Fast device" : "Slow device", 300.0, skew, 0.004};
+        const Result result = Run(scenario);
+
+        Print(scenario, result);
+        Check(scenario.name, "the ratio stays within +/-0.5%", result.largest_deviation <= AudioLatencyController::MAXIMUM_RATIO_DEVIATION + RATIO_TOLERANCE);
+        Check(scenario.name, "the ratio cancels the skew", std::fabs(result.mean_ratio * (1.0 + skew) - 1.0) < 0.0005);
+        Check(scenario.name, "the target shrinks to its minimum", result.final_target == minimum_target && minimum_target < initial_target);
+        Check(scenario.name, "there are no underruns once settled", result.last_underrun_time < 30.0);
+    }
+
+    // Heavy jitter may cost some underruns, but those must grow the target rather than keep happening.
+    {
+        const Scenario scenario = {"Heavy jitter", 300.0, 0.002, 0.020};
+        const Result result = Run(scenario);
+
+        Print(scenario, result);
+        Check(scenario.name, "the ratio stays within +/-0.5%", result.largest_deviation <= AudioLatencyController::MAXIMUM_RATIO_DEVIATION + RATIO_TOLERANCE);
+        Check(scenario.name, "underruns stop once the target has grown", result.last_underrun_time < 150.0);
+        Check(scenario.name, "the target stays within its bounds", result.final_target >= minimum_target && result.final_target <= maximum_target);
+    }
+
+    // A skew beyond what the ratio is allowed to correct must not push the ratio past its clamp.
+    {
+        const Scenario scenario = {"Excessive skew", 120.0, 0.02, 0.004};
+        const Result result = Run(scenario);
+
+        Print(scenario, result);
+        Check(scenario.name, "the ratio stays within +/-0.5%", result.largest_deviation <= AudioLatencyController::MAXIMUM_RATIO_DEVIATION + RATIO_TOLERANCE);
+        Check(scenario.name, "the target never passes its maximum", result.final_target <= maximum_target);
+    }
+
+    // Pausing the emulator starves the device, producing a long burst of underruns that the controller sees all at once.
+    {
+        Scenario scenario = {"Emulator stall", 240.0, 0.001, 0.004};
+        scenario.stall_start = 120.0;
+        scenario.stall_length = 0.5;
+
+        const Result result = Run(scenario);
+
+        Print(scenario, result);
+        std::printf("  the stall caused %lu underruns, and the target went from %lu to %lu\n", static_cast<unsigned long>(result.stall_underruns),
+            static_cast<unsigned long>(result.target_before_stall), static_cast<unsigned long>(result.target_after_stall));
+        Check(scenario.name, "the stall causes a burst of underruns", result.stall_underruns > 10);
+        Check(scenario.name, "the burst grows the target by half, once",
+            result.target_after_stall == std::min(result.target_before_stall + result.target_before_stall / 2, maximum_target));
+        Check(scenario.name, "there are no underruns after the stall", result.last_underrun_time < scenario.stall_start + scenario.stall_length + 1.0);
+        Check(scenario.name, "the target shrinks back to its minimum", result.final_target == minimum_target);
+    }
+
+    // Stalling the device instead floods the queue, which must be capped by dropping audio rather than left to the ratio.
+    {
+        Scenario scenario = {"Device stall", 240.0, 0.001, 0.004};
+        scenario.stall_start = 120.0;
+        scenario.stall_length = 1.0;
+        scenario.device_stalls = true;
+
+        const Result result = Run(scenario);
+
+        Print(scenario, result);
+        Check(scenario.name, "the queue is capped at twice the maximum target", result.largest_queue < maximum_target * 2 + FRAMES_PER_UPDATE);
+        Check(scenario.name, "the ratio stays within +/-0.5%", result.largest_deviation <= AudioLatencyController::MAXIMUM_RATIO_DEVIATION + RATIO_TOLERANCE);
+        Check(scenario.name, "the target shrinks back to its minimum", result.final_target == minimum_target);
+    }
+
+    std::puts(all_passed ? "All scenarios passed." : "Some scenarios failed.");
+
+    return all_passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -9,6 +9,7 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstddef>
 #include <numeric>
 
@@ -16,6 +17,10 @@
 
 #include "common/mixer.h"
 
+#include "AudioLatencyController.h"
+#include "AudioRingBuffer.h"
+#include "WorkerThread.h"
+
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_main.h>
 
@@ -25,18 +30,29 @@ private:
     const cc_u8f channels;
     const std::size_t SIZE_OF_FRAME = channels * sizeof(cc_s16l);
 
+    // Sits between the emulation thread and SDL's audio thread, so that queuing audio never takes SDL's stream lock.
+    AudioRingBuffer ring;
     SDL_AudioStream* stream;
 
+    // Setting the frequency ratio takes SDL's stream lock, so the emulation thread only publishes it here,
+    // and the stream callback (which already holds the lock) applies it whenever it has changed.
+    std::atomic<float> playback_speed{1.0f};
+    float applied_playback_speed = 1.0f;
+
+    static void SDLCALL StreamCallback(void *user_data, SDL_AudioStream *stream, int additional_amount, int total_amount);
+
 public:
     AudioDevice(cc_u8f channels, cc_u32f sample_rate);
     AudioDevice(const AudioDevice&) = delete;
     AudioDevice& operator=(const AudioDevice&) = delete;
+    ~AudioDevice();
 
     void QueueFrames(const cc_s16l *buffer, cc_u32f total_frames);
     cc_u32f GetTotalQueuedFrames();
+    AudioRingBuffer::Telemetry GetTelemetry() const { return ring.GetTelemetry(); }
     void SetPlaybackSpeed(const cc_u32f numerator, const cc_u32f denominator)
     {
-        SDL_SetAudioStreamFrequencyRatio(stream, static_cast<float>(numerator) / denominator);
+        playback_speed.store(static_cast<float>(numerator) / denominator, std::memory_order_relaxed);
     }
 };
 
@@ -49,8 +65,21 @@ private:
     bool pal_mode = false;
     std::array<cc_u32f, 0x10> rolling_average_buffer = {0};
     cc_u8f rolling_average_buffer_index = 0;
+    bool band_limited_psg = false;
+    AudioLatencyController latency_controller;
+
+    Mixer mixer = Mixer(pal_mode, MIXER_DEFAULT_OUTPUT_SAMPLE_RATE);
+    std::array<cc_s16l, MIXER_MAXIMUM_AUDIO_FRAMES_PER_FRAME * MIXER_CHANNEL_COUNT> mixer_output_buffer;
+
+    // When the PSG is deferred, the emulator logs each frame's PSG writes instead of synthesising them, and the log is
+    // replayed on 'psg_thread' while the following frame is emulated. The other sources are held back a frame to match.
+    ClownMDEmu *deferred_psg_emulator = nullptr;
+    std::array<ClownMDEmu_PSGLog, 2> psg_logs;
+    ClownMDEmu_PSGLog *pending_psg_log = nullptr;
+    WorkerThread psg_thread;
 
-    Mixer mixer = Mixer(pal_mode);
+    void OutputFrame();
+    void FlushDeferredPSG();
 
 public:
     AudioOutput();
@@ -58,13 +87,20 @@ public:
     void MixerEnd();
     cc_s16l* MixerAllocateFMSamples(std::size_t total_frames);
     cc_s16l* MixerAllocatePSGSamples(std::size_t total_frames);
+    void MixerGeneratePSGSamples(const ClownMDEmu *clownmdemu, std::size_t total_frames, void (*generate_psg_audio)(const ClownMDEmu *clownmdemu, cc_s16l *sample_buffer, std::size_t total_frames));
     cc_s16l* MixerAllocatePCMSamples(std::size_t total_frames);
     cc_s16l* MixerAllocateCDDASamples(std::size_t total_frames);
     cc_u32f GetAverageFrames() const;
-    cc_u32f GetTargetFrames() const { return std::max<cc_u32f>(total_buffer_frames * 2, MIXER_OUTPUT_SAMPLE_RATE / 20); } // 50ms
+    cc_u32f GetTargetFrames() const { return latency_controller.GetTargetFrames(); }
     cc_u32f GetTotalBufferFrames() const { return total_buffer_frames; }
-    cc_u32f GetSampleRate() const { return MIXER_OUTPUT_SAMPLE_RATE; }
+    cc_u32f GetSampleRate() const { return mixer.GetOutputSampleRate(); }
 
     void SetPALMode(bool enabled);
     bool GetPALMode() const { return pal_mode; }
+    void SetBandLimitedPSG(bool enabled);
+    bool GetBandLimitedPSG() const { return band_limited_psg; }
+    // Must only be changed between frames. 'clownmdemu' has its 'psg_log' managed for as long as this is enabled.
+    void SetDeferredPSG(ClownMDEmu *clownmdemu, bool enabled);
+    bool GetDeferredPSG() const { return deferred_psg_emulator != nullptr; }
+    AudioRingBuffer::Telemetry GetTelemetry() const { return device.GetTelemetry(); }
 };
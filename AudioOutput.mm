@@ -9,6 +9,7 @@
 
 AudioDevice::AudioDevice(const cc_u8f channels, const cc_u32f sample_rate)
     : channels(channels)
+    , ring(channels, sample_rate / 4) // 250ms, which is far more than the rate control ever lets accumulate.
 {
     SDL_SetMainReady();
     SDL_InitSubSystem(SDL_INIT_AUDIO);
@@ -20,7 +21,7 @@ AudioDevice::AudioDevice(const cc_u8f channels, const cc_u32f sample_rate)
 
     // Create audio stream.
     auto deviceID = SDL_OpenAudioDevice(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &spec);
-    stream = SDL_OpenAudioDeviceStream(deviceID, &spec, nullptr, nullptr);
+    stream = SDL_OpenAudioDeviceStream(deviceID, &spec, StreamCallback, this);
 
     if (stream == nullptr)
     {
@@ -34,14 +35,50 @@ AudioDevice::AudioDevice(const cc_u8f channels, const cc_u32f sample_rate)
     }
 }
 
+AudioDevice::~AudioDevice()
+{
+    // This stops the callback before the ring is destroyed.
+    SDL_DestroyAudioStream(stream);
+}
+
+void SDLCALL AudioDevice::StreamCallback(void* const user_data, SDL_AudioStream* const stream, const int additional_amount, const int total_amount)
+{
+    // Runs on SDL's audio thread whenever the device wants more audio.
+    AudioDevice &device = *static_cast<AudioDevice*>(user_data);
+
+    const float playback_speed = device.playback_speed.load(std::memory_order_relaxed);
+
+    if (playback_speed != device.applied_playback_speed)
+    {
+        SDL_SetAudioStreamFrequencyRatio(stream, playback_speed);
+        device.applied_playback_speed = playback_speed;
+    }
+
+    const std::size_t downstream_frames = static_cast<std::size_t>(total_amount - additional_amount) / device.SIZE_OF_FRAME;
+    std::size_t frames_remaining = static_cast<std::size_t>(additional_amount) / device.SIZE_OF_FRAME;
+
+    std::array<cc_s16l, 0x400 * MIXER_CHANNEL_COUNT> buffer;
+    const std::size_t buffer_frames = buffer.size() / device.channels;
+
+    while (frames_remaining != 0)
+    {
+        const std::size_t frames_to_do = std::min(frames_remaining, buffer_frames);
+
+        device.ring.Pop(buffer.data(), frames_to_do, downstream_frames);
+        SDL_PutAudioStreamData(stream, buffer.data(), static_cast<int>(frames_to_do * device.SIZE_OF_FRAME));
+
+        frames_remaining -= frames_to_do;
+    }
+}
+
 void AudioDevice::QueueFrames(const cc_s16l *buffer, cc_u32f total_frames)
 {
-    SDL_PutAudioStreamData(stream, buffer, static_cast<int>(total_frames * SIZE_OF_FRAME));
+    ring.Push(buffer, total_frames);
 }
 
 cc_u32f AudioDevice::GetTotalQueuedFrames()
 {
-    return SDL_GetAudioStreamQueued(stream) / SIZE_OF_FRAME;
+    return static_cast<cc_u32f>(ring.GetFillFrames());
 }
 
 
@@ -63,39 +100,79 @@ static constexpr cc_u32f BufferSizeFromSampleRate(const cc_u32f sample_rate)
     return samples;
 }
 
+static AudioLatencyController CreateLatencyController(const cc_u32f sample_rate, const cc_u32f total_buffer_frames, const bool pal_mode)
+{
+    const cc_u32f framerate = pal_mode ? 50 : 60;
+
+    // Start at 50ms, and let the controller work down to two frames of audio on top of the device's own buffer.
+    return AudioLatencyController(
+        std::max<cc_u32f>(total_buffer_frames * 2, sample_rate / 20),
+        sample_rate / framerate * 2 + total_buffer_frames,
+        sample_rate / 8,
+        framerate
+    );
+}
+
 AudioOutput::AudioOutput()
-    : device(MIXER_CHANNEL_COUNT, MIXER_OUTPUT_SAMPLE_RATE)
-    , total_buffer_frames(BufferSizeFromSampleRate(MIXER_OUTPUT_SAMPLE_RATE))
+    : device(MIXER_CHANNEL_COUNT, MIXER_DEFAULT_OUTPUT_SAMPLE_RATE)
+    , total_buffer_frames(BufferSizeFromSampleRate(MIXER_DEFAULT_OUTPUT_SAMPLE_RATE))
+    , latency_controller(CreateLatencyController(MIXER_DEFAULT_OUTPUT_SAMPLE_RATE, total_buffer_frames, pal_mode))
 {}
 
 void AudioOutput::MixerBegin()
 {
     mixer.Begin();
+
+    if (deferred_psg_emulator != nullptr)
+    {
+        // Everything that the other sources have produced so far belongs to the previous frame, whose PSG audio is
+        // only now being synthesised.
+        mixer.EndSourceFrame(MIXER_SOURCE_FM);
+        mixer.EndSourceFrame(MIXER_SOURCE_PCM);
+        mixer.EndSourceFrame(MIXER_SOURCE_CDDA);
+
+        if (pending_psg_log != nullptr)
+        {
+            const ClownMDEmu* const clownmdemu = deferred_psg_emulator;
+            const ClownMDEmu_PSGLog* const log = pending_psg_log;
+
+            psg_thread.Run([clownmdemu, log]() { ClownMDEmu_GeneratePSGAudioFromLog(clownmdemu, log); });
+        }
+
+        // Log into whichever buffer is not being replayed.
+        deferred_psg_emulator->psg_log = pending_psg_log == &psg_logs[0] ? &psg_logs[1] : &psg_logs[0];
+    }
 }
 
 void AudioOutput::MixerEnd()
 {
-    const cc_u32f target_frames = GetTargetFrames();
+    if (deferred_psg_emulator != nullptr)
+    {
+        psg_thread.Wait();
+        pending_psg_log = deferred_psg_emulator->psg_log;
+    }
+
+    OutputFrame();
+}
+
+void AudioOutput::OutputFrame()
+{
     const cc_u32f queued_frames = device.GetTotalQueuedFrames();
 
     rolling_average_buffer[rolling_average_buffer_index] = queued_frames;
     rolling_average_buffer_index = (rolling_average_buffer_index + 1) % rolling_average_buffer.size();
 
-    // If there is too much audio, just drop it because the dynamic rate control will be unable to handle it.
-    if (queued_frames < target_frames * 2)
-    {
-        mixer.End(
-            [&](const cc_s16l* const audio_samples, const std::size_t total_frames)
-            {
-                device.QueueFrames(audio_samples, total_frames);
-            }
-        );
-
-        // Hans-Kristian Arntzen's Dynamic Rate Control formula.
-        // https://github.com/libretro/docs/blob/master/archive/ratecontrol.pdf
-        const cc_u32f divisor = target_frames * 0x100; // The number here is the inverse of the formula's 'd' value.
-        device.SetPlaybackSpeed(queued_frames - target_frames + divisor, divisor);
-    }
+    // Dynamic rate control, in the spirit of Hans-Kristian Arntzen's formula, but with an integral term and a moving target.
+    // https://github.com/libretro/docs/blob/master/archive/ratecontrol.pdf
+    const double ratio = latency_controller.Update(queued_frames, device.GetTelemetry().underruns);
+    device.SetPlaybackSpeed(static_cast<cc_u32f>(ratio * 0x10000 + 0.5), 0x10000);
+
+    // The mixer must always be ended, as that is what lets it discard the frame.
+    const std::size_t total_frames = mixer.End(mixer_output_buffer.data());
+
+    // If there is far too much audio, just drop it because the dynamic rate control will be unable to handle it.
+    if (!latency_controller.ShouldDrop(queued_frames))
+        device.QueueFrames(mixer_output_buffer.data(), total_frames);
 }
 
 cc_s16l* AudioOutput::MixerAllocateFMSamples(const std::size_t total_frames)
@@ -108,6 +185,11 @@ cc_s16l* AudioOutput::MixerAllocatePSGSamples(const std::size_t total_frames)
     return mixer.AllocatePSGSamples(total_frames);
 }
 
+void AudioOutput::MixerGeneratePSGSamples(const ClownMDEmu* const clownmdemu, const std::size_t total_frames, void (* const generate_psg_audio)(const ClownMDEmu *clownmdemu, cc_s16l *sample_buffer, std::size_t total_frames))
+{
+    mixer.GeneratePSGSamples(clownmdemu, total_frames, generate_psg_audio);
+}
+
 cc_s16l* AudioOutput::MixerAllocatePCMSamples(const std::size_t total_frames)
 {
     return mixer.AllocatePCMSamples(total_frames);
@@ -123,8 +205,42 @@ cc_u32f AudioOutput::GetAverageFrames() const
     return std::accumulate(rolling_average_buffer.cbegin(), rolling_average_buffer.cend(), cc_u32f(0)) / rolling_average_buffer.size();
 }
 
+void AudioOutput::FlushDeferredPSG()
+{
+    if (pending_psg_log == nullptr)
+        return;
+
+    // Output the frame that is still waiting on its PSG audio, so that the PSG is left up to date and nothing is held over.
+    mixer.Begin();
+    ClownMDEmu_GeneratePSGAudioFromLog(deferred_psg_emulator, pending_psg_log);
+    pending_psg_log = nullptr;
+    OutputFrame();
+}
+
+void AudioOutput::SetDeferredPSG(ClownMDEmu* const clownmdemu, const bool enabled)
+{
+    if (enabled == GetDeferredPSG())
+        return;
+
+    FlushDeferredPSG();
+
+    clownmdemu->psg_log = nullptr;
+    deferred_psg_emulator = enabled ? clownmdemu : nullptr;
+}
+
 void AudioOutput::SetPALMode(const bool enabled)
 {
+    FlushDeferredPSG();
+
     pal_mode = enabled;
     mixer.SetPALMode(pal_mode);
+    latency_controller = CreateLatencyController(GetSampleRate(), total_buffer_frames, pal_mode);
+}
+
+void AudioOutput::SetBandLimitedPSG(const bool enabled)
+{
+    FlushDeferredPSG();
+
+    band_limited_psg = enabled;
+    mixer.SetPSGBandLimited(band_limited_psg);
 }
@@ -0,0 +1,147 @@
+//
+//  AudioRingBuffer.h
+//  Plum
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+
+#include "core/clowncommon/clowncommon.h"
+
+// A single-producer/single-consumer ring of interleaved audio frames.
+// The emulation thread pushes into it and the audio device's callback pops from it, without either side taking a lock.
+// Each index is only ever written by one side, so acquire/release ordering on the indices is all that is needed.
+class AudioRingBuffer
+{
+public:
+    struct Telemetry
+    {
+        cc_u32f underruns;        // Pops that could not be fully satisfied.
+        cc_u32f overruns;         // Pushes that could not be fully satisfied.
+        cc_u32f dropped_frames;   // Frames lost to overruns.
+        cc_u32f fill_frames;      // Frames currently waiting in the ring.
+        cc_u32f latency_frames;   // Frames between the producer and the speaker, as of the last pop.
+    };
+
+private:
+    const cc_u8f channels;
+    const std::size_t capacity; // In frames. Always a power of two.
+    const std::unique_ptr<cc_s16l[]> buffer;
+
+    // Free-running frame counters; the difference between them is the fill level.
+    alignas(64) std::atomic<std::size_t> write_index{0};
+    alignas(64) std::atomic<std::size_t> read_index{0};
+
+    alignas(64) std::atomic<cc_u32f> underruns{0};
+    std::atomic<cc_u32f> overruns{0};
+    std::atomic<cc_u32f> dropped_frames{0};
+    std::atomic<cc_u32f> latency_frames{0};
+
+    static std::size_t RoundUpToPowerOfTwo(const std::size_t value)
+    {
+        std::size_t result = 1;
+        while (result < value)
+            result *= 2;
+        return result;
+    }
+
+    // Copies frames between the ring and a linear buffer, splitting the copy where the ring wraps.
+    template<typename Copy>
+    void Transfer(const std::size_t position, const std::size_t total_frames, const Copy &copy) const
+    {
+        const std::size_t start = position & (capacity - 1);
+        const std::size_t first_frames = std::min(total_frames, capacity - start);
+
+        copy(start, 0, first_frames);
+        copy(0, first_frames, total_frames - first_frames);
+    }
+
+public:
+    AudioRingBuffer(const cc_u8f channels, const std::size_t minimum_capacity)
+        : channels(channels)
+        , capacity(RoundUpToPowerOfTwo(minimum_capacity))
+        , buffer(new cc_s16l[capacity * channels])
+    {}
+    AudioRingBuffer(const AudioRingBuffer&) = delete;
+    AudioRingBuffer& operator=(const AudioRingBuffer&) = delete;
+
+    // Producer side. Returns the number of frames that fit; the rest are dropped and counted as an overrun.
+    std::size_t Push(const cc_s16l* const frames, const std::size_t total_frames)
+    {
+        const std::size_t write = write_index.load(std::memory_order_relaxed);
+        const std::size_t read = read_index.load(std::memory_order_acquire);
+        const std::size_t frames_to_write = std::min(total_frames, capacity - (write - read));
+
+        Transfer(write, frames_to_write,
+            [&](const std::size_t ring_frame, const std::size_t linear_frame, const std::size_t count)
+            {
+                std::memcpy(&buffer[ring_frame * channels], &frames[linear_frame * channels], count * channels * sizeof(cc_s16l));
+            }
+        );
+
+        write_index.store(write + frames_to_write, std::memory_order_release);
+
+        if (frames_to_write != total_frames)
+        {
+            overruns.fetch_add(1, std::memory_order_relaxed);
+            dropped_frames.fetch_add(total_frames - frames_to_write, std::memory_order_relaxed);
+        }
+
+        return frames_to_write;
+    }
+
+    // Consumer side. Always produces 'total_frames' frames, padding with silence and counting an underrun if the ring runs dry.
+    // 'downstream_frames' is how much audio is already queued after the ring, and is only used for the latency telemetry.
+    std::size_t Pop(cc_s16l* const frames, const std::size_t total_frames, const std::size_t downstream_frames = 0)
+    {
+        const std::size_t read = read_index.load(std::memory_order_relaxed);
+        const std::size_t write = write_index.load(std::memory_order_acquire);
+        const std::size_t frames_to_read = std::min(total_frames, write - read);
+
+        Transfer(read, frames_to_read,
+            [&](const std::size_t ring_frame, const std::size_t linear_frame, const std::size_t count)
+            {
+                std::memcpy(&frames[linear_frame * channels], &buffer[ring_frame * channels], count * channels * sizeof(cc_s16l));
+            }
+        );
+
+        read_index.store(read + frames_to_read, std::memory_order_release);
+
+        if (frames_to_read != total_frames)
+        {
+            std::memset(&frames[frames_to_read * channels], 0, (total_frames - frames_to_read) * channels * sizeof(cc_s16l));
+            underruns.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        latency_frames.store(static_cast<cc_u32f>(write - read - frames_to_read + total_frames + downstream_frames), std::memory_order_relaxed);
+
+        return frames_to_read;
+    }
+
+    // Safe to call from either side.
+    std::size_t GetFillFrames() const
+    {
+        // Load the read index first, so that the write index can never appear to be behind it.
+        const std::size_t read = read_index.load(std::memory_order_acquire);
+        const std::size_t write = write_index.load(std::memory_order_acquire);
+        return write - read;
+    }
+
+    std::size_t GetCapacity() const { return capacity; }
+
+    Telemetry GetTelemetry() const
+    {
+        Telemetry telemetry;
+        telemetry.underruns = underruns.load(std::memory_order_relaxed);
+        telemetry.overruns = overruns.load(std::memory_order_relaxed);
+        telemetry.dropped_frames = dropped_frames.load(std::memory_order_relaxed);
+        telemetry.fill_frames = static_cast<cc_u32f>(GetFillFrames());
+        telemetry.latency_frames = latency_frames.load(std::memory_order_relaxed);
+        return telemetry;
+    }
+};
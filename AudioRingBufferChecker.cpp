@@ -0,0 +1,133 @@
+//
+//  AudioRingBufferChecker.cpp
+//  Plum
+//
+
+// Pushes a known sequence of frames through an 'AudioRingBuffer' from one thread while another pops it,
+// in the same way as the emulation thread and SDL's audio thread. Every frame must come out exactly once,
+// in order, with its channels intact. Build it with something like:
+//
+//     g++ -std=c++17 -O2 -pthread -ICore/include AudioRingBufferChecker.cpp -o audio-ring-buffer-checker
+//
+// It is worth building with '-fsanitize=thread' too, which should report no races.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "AudioRingBuffer.h"
+
+namespace
+{
+    constexpr cc_u8f CHANNELS = 2;
+
+    // A small, fast generator, so that each side can vary its chunk sizes without sharing any state.
+    class Random
+    {
+    private:
+        cc_u32f state;
+
+    public:
+        explicit Random(const cc_u32f seed) : state(seed) {}
+
+        std::size_t Next(const std::size_t maximum)
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            state &= 0xFFFFFFFF;
+            return 1 + state % maximum;
+        }
+    };
+
+    // Each frame holds its own index, split across the channels, so that the consumer can check it.
+    void MakeFrame(cc_s16l* const frame, const std::size_t index)
+    {
+        frame[0] = static_cast<cc_s16l>(index & 0x7FFF);
+        frame[1] = static_cast<cc_s16l>((index >> 15) & 0x7FFF);
+    }
+}
+
+int main(const int argc, char** const argv)
+{
+    const std::size_t total_frames = argc >= 2 ? std::strtoul(argv[1], nullptr, 0) : 20000000;
+    const std::size_t capacity = argc >= 3 ? std::strtoul(argv[2], nullptr, 0) : 1024;
+
+    if (total_frames == 0 || capacity == 0)
+    {
+        std::fprintf(stderr, "Usage: %s [frames] [ring-capacity]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    AudioRingBuffer ring(CHANNELS, capacity);
+    std::atomic<bool> failed{false};
+    std::size_t frames_received = 0;
+
+    const auto starting_time = std::chrono::steady_clock::now();
+
+    std::thread producer([&]()
+    {
+        Random random(1);
+        std::vector<cc_s16l> chunk(ring.GetCapacity() * CHANNELS);
+        std::size_t frames_sent = 0;
+
+        while (frames_sent != total_frames && !failed)
+        {
+            const std::size_t frames_to_send = std::min(random.Next(ring.GetCapacity()), total_frames - frames_sent);
+
+            for (std::size_t i = 0; i < frames_to_send; ++i)
+                MakeFrame(&chunk[i * CHANNELS], frames_sent + i);
+
+            // Unlike the emulator, which just lets the overrun be dropped, resend whatever did not fit.
+            const std::size_t frames_pushed = ring.Push(chunk.data(), frames_to_send);
+            frames_sent += frames_pushed;
+
+            if (frames_pushed != frames_to_send)
+                std::this_thread::yield();
+        }
+    });
+
+    std::thread consumer([&]()
+    {
+        Random random(2);
+        std::vector<cc_s16l> chunk(ring.GetCapacity() * CHANNELS);
+        cc_s16l expected[CHANNELS];
+
+        while (frames_received != total_frames && !failed)
+        {
+            const std::size_t frames_popped = ring.Pop(chunk.data(), random.Next(ring.GetCapacity()));
+
+            for (std::size_t i = 0; i < frames_popped; ++i)
+            {
+                MakeFrame(expected, frames_received);
+
+                if (chunk[i * CHANNELS + 0] != expected[0] || chunk[i * CHANNELS + 1] != expected[1])
+                {
+                    std::fprintf(stderr, "Frame %zu was lost, repeated, or torn.\n", frames_received);
+                    failed = true;
+                    break;
+                }
+
+                ++frames_received;
+            }
+
+            if (frames_popped == 0)
+                std::this_thread::yield();
+        }
+    });
+
+    producer.join();
+    consumer.join();
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - starting_time).count();
+    const AudioRingBuffer::Telemetry telemetry = ring.GetTelemetry();
+
+    std::printf("Moved %zu of %zu frames through a %zu-frame ring in %.3f seconds, with %lu underruns, %lu overruns, and %lu frames left over.\n",
+        frames_received, total_frames, ring.GetCapacity(), seconds,
+        static_cast<unsigned long>(telemetry.underruns), static_cast<unsigned long>(telemetry.overruns), static_cast<unsigned long>(telemetry.fill_frames));
+
+    return !failed && frames_received == total_frames && telemetry.fill_frames == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,307 @@
+//
+//  CDAudioStream.h
+//  Plum
+//
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "common/cd-reader.h"
+
+// Decodes CD-DA on a worker thread, into a ring of frames that runs ahead of the emulated play position,
+// so that 'cd_audio_read' only has to copy frames rather than decode, resample, and seek on the emulation thread.
+// Once the current track is far enough ahead, the worker also decodes the start of the next track on a second reader,
+// so that a game moving on to it does not have to wait for its file to be opened.
+// The worker's readers produce exactly what a reader on the emulation thread would, as CDReader's output does not
+// depend on how its reads are split up, and a primed reader simply carries on from where its priming stopped.
+class CDAudioStream
+{
+public:
+    struct Statistics
+    {
+        cc_u32f stalls;           // Reads that had to wait for the worker.
+        cc_u32f speculative_hits; // Tracks that started from a primed reader.
+    };
+
+private:
+    static constexpr cc_u32f RING_FRAMES = 0x8000;  // A little under three quarters of a second.
+    static constexpr cc_u32f CHUNK_FRAMES = 0x400;
+    static constexpr cc_u32f PRIMED_FRAMES = 0x2000; // Must fit in the ring.
+
+    std::mutex mutex;
+    std::condition_variable condition;
+
+    std::vector<cc_s16l> ring = std::vector<cc_s16l>(RING_FRAMES * 2);
+    std::size_t read_index = 0, write_index = 0; // Free-running frame counters.
+    cc_u32f generation = 0;                       // Bumped by every 'Play', so that stale frames can be discarded.
+    bool play_pending = false;
+    CDReader_TrackIndex play_track = 0;
+    CDReader_PlaybackSetting play_setting = CDREADER_PLAYBACK_ALL;
+    bool playing = false;
+    bool ended = false;
+    bool priming_wanted = false;
+    CDReader_TrackIndex priming_track = 0;
+    bool open = false;
+    bool quitting = false;
+    Statistics statistics{};
+
+    // Only the worker touches these while it is running.
+    CDReader_State readers[2];
+    CDReader_State *active_reader = &readers[0];
+    CDReader_State *primed_reader = &readers[1]; // Swapped rather than copied, as ClownCD's decoders point into it.
+    bool primed = false;
+    CDReader_TrackIndex primed_track = 0;
+    std::vector<cc_s16l> primed_frames = std::vector<cc_s16l>(PRIMED_FRAMES * 2);
+    std::vector<cc_s16l> chunk = std::vector<cc_s16l>(CHUNK_FRAMES * 2);
+
+    std::thread thread;
+
+    std::size_t GetFreeFrames() const
+    {
+        return RING_FRAMES - (write_index - read_index);
+    }
+
+    void Push(const cc_s16l* const frames, const std::size_t total_frames)
+    {
+        for (std::size_t i = 0; i < total_frames; ++i, ++write_index)
+        {
+            const std::size_t position = write_index % RING_FRAMES;
+            ring[position * 2 + 0] = frames[i * 2 + 0];
+            ring[position * 2 + 1] = frames[i * 2 + 1];
+        }
+    }
+
+    void StartTrack(std::unique_lock<std::mutex> &lock)
+    {
+        const cc_u32f request_generation = generation;
+        const CDReader_TrackIndex track = play_track;
+        const CDReader_PlaybackSetting setting = play_setting;
+        play_pending = false;
+
+        const bool use_primed_reader = primed && primed_track == track;
+        bool success = true;
+
+        lock.unlock();
+
+        if (use_primed_reader)
+        {
+            std::swap(active_reader, primed_reader);
+            active_reader->playback_setting = setting;
+            primed = false;
+        }
+        else
+        {
+            success = CDReader_PlayAudio(active_reader, track, setting);
+        }
+
+        lock.lock();
+
+        if (request_generation != generation)
+            return;
+
+        ended = !success;
+
+        if (use_primed_reader)
+        {
+            Push(primed_frames.data(), PRIMED_FRAMES);
+            ++statistics.speculative_hits;
+        }
+
+        if (!primed || primed_track != track + 1)
+        {
+            priming_wanted = true;
+            priming_track = track + 1;
+        }
+
+        condition.notify_all();
+    }
+
+    void Decode(std::unique_lock<std::mutex> &lock)
+    {
+        const cc_u32f request_generation = generation;
+
+        lock.unlock();
+        const cc_u32f frames_read = CDReader_ReadAudio(active_reader, chunk.data(), CHUNK_FRAMES);
+        lock.lock();
+
+        if (request_generation != generation)
+            return;
+
+        Push(chunk.data(), frames_read);
+
+        // A short read means that playback has stopped, just as it would for the emulator.
+        if (frames_read != CHUNK_FRAMES)
+            ended = true;
+
+        condition.notify_all();
+    }
+
+    void Prime(std::unique_lock<std::mutex> &lock)
+    {
+        const CDReader_TrackIndex track = priming_track;
+        priming_wanted = false;
+
+        lock.unlock();
+
+        // The playback setting only matters at the end of the track, which priming never reaches:
+        // a track that is too short to be primed in full is just left to be opened normally.
+        primed = CDReader_PlayAudio(primed_reader, track, CDREADER_PLAYBACK_ONCE)
+            && CDReader_ReadAudio(primed_reader, primed_frames.data(), PRIMED_FRAMES) == PRIMED_FRAMES;
+        primed_track = track;
+
+        lock.lock();
+    }
+
+    bool CanDecode() const
+    {
+        return playing && !ended && GetFreeFrames() >= CHUNK_FRAMES;
+    }
+
+    void Loop()
+    {
+        std::unique_lock lock(mutex);
+
+        for (;;)
+        {
+            condition.wait(lock, [this]() { return quitting || play_pending || CanDecode() || priming_wanted; });
+
+            // Keeping the current track fed always comes before priming the next one.
+            if (quitting)
+                return;
+            else if (play_pending)
+                StartTrack(lock);
+            else if (CanDecode())
+                Decode(lock);
+            else
+                Prime(lock);
+        }
+    }
+
+public:
+    CDAudioStream()
+    {
+        for (auto &reader : readers)
+            CDReader_Initialise(&reader);
+    }
+    CDAudioStream(const CDAudioStream&) = delete;
+    CDAudioStream& operator=(const CDAudioStream&) = delete;
+
+    ~CDAudioStream()
+    {
+        Close();
+
+        for (auto &reader : readers)
+            CDReader_Deinitialise(&reader);
+    }
+
+    // 'open_reader' opens one of the worker's CDReaders on the same disc as the emulator's. It is called twice.
+    void Open(const std::function<void(CDReader_State *reader)> &open_reader)
+    {
+        Close();
+
+        for (auto &reader : readers)
+            open_reader(&reader);
+
+        open = true;
+        quitting = false;
+        thread = std::thread([this]() { Loop(); });
+    }
+
+    void Close()
+    {
+        if (!open)
+            return;
+
+        {
+            std::lock_guard lock(mutex);
+            quitting = true;
+        }
+
+        condition.notify_all();
+        thread.join();
+
+        for (auto &reader : readers)
+            CDReader_Close(&reader);
+
+        read_index = write_index = 0;
+        play_pending = playing = ended = priming_wanted = primed = false;
+        open = false;
+        statistics = {};
+    }
+
+    bool IsOpen() const { return open; }
+
+    // For the emulator's 'cd_track_seeked' callback. The track is started asynchronously, and the emulator ignores
+    // the result anyway, so this always succeeds; a track that cannot be played simply produces no audio.
+    cc_bool Play(const CDReader_TrackIndex track, const CDReader_PlaybackSetting setting)
+    {
+        std::lock_guard lock(mutex);
+
+        ++generation;
+        read_index = write_index = 0;
+        play_pending = true;
+        play_track = track;
+        play_setting = setting;
+        playing = true;
+        ended = false;
+        condition.notify_all();
+
+        return cc_true;
+    }
+
+    // For the emulator's 'cd_audio_read' callback.
+    cc_u32f Read(cc_s16l* const frames, const cc_u32f total_frames)
+    {
+        std::unique_lock lock(mutex);
+
+        cc_u32f frames_done = 0;
+        bool stalled = false;
+
+        while (frames_done != total_frames)
+        {
+            const std::size_t frames_available = write_index - read_index;
+
+            if (frames_available != 0)
+            {
+                const std::size_t frames_to_do = std::min<std::size_t>(frames_available, total_frames - frames_done);
+
+                for (std::size_t i = 0; i < frames_to_do; ++i, ++read_index, ++frames_done)
+                {
+                    const std::size_t position = read_index % RING_FRAMES;
+                    frames[frames_done * 2 + 0] = ring[position * 2 + 0];
+                    frames[frames_done * 2 + 1] = ring[position * 2 + 1];
+                }
+
+                condition.notify_all();
+            }
+            else if (!playing || (ended && !play_pending))
+            {
+                break;
+            }
+            else
+            {
+                if (!stalled)
+                    ++statistics.stalls;
+
+                stalled = true;
+                condition.wait(lock, [this]() { return write_index != read_index || (ended && !play_pending); });
+            }
+        }
+
+        return frames_done;
+    }
+
+    Statistics GetStatistics()
+    {
+        std::lock_guard lock(mutex);
+        return statistics;
+    }
+};
@@ -0,0 +1,245 @@
+//
+//  CDSectorCache.h
+//  Plum
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "common/cd-reader.h"
+
+// Serves the CDC's sector reads from memory, while a worker thread reads ahead of the emulated drive head.
+// The emulator still receives each sector at the moment it asks for it, and a sector's contents do not depend on
+// whether it was prefetched, so emulation stays deterministic: a sector that has not arrived yet just blocks the
+// emulation thread until it has.
+// The worker reads through a CDReader of its own, so that it never contends with CD-DA playback on the emulation thread's.
+class CDSectorCache
+{
+public:
+    static constexpr std::size_t WORDS_PER_SECTOR = CDREADER_SECTOR_SIZE / 2;
+
+    struct Statistics
+    {
+        cc_u32f hits;   // Reads that found the sector already cached.
+        cc_u32f misses; // Reads of sectors that the worker had not even started on.
+        cc_u32f stalls; // Reads that had to wait for the worker, including every miss.
+    };
+
+private:
+    using Words = std::array<cc_u16l, WORDS_PER_SECTOR>;
+
+    struct Sector
+    {
+        Words words;
+        std::list<CDReader_SectorIndex>::iterator lru_position;
+    };
+
+    const std::size_t capacity;
+    const std::size_t read_ahead;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::unordered_map<CDReader_SectorIndex, Sector> sectors;
+    std::list<CDReader_SectorIndex> lru; // Most recently used first.
+    CDReader_SectorIndex head = 0;       // The sector that the emulator will read next.
+    CDReader_SectorIndex fetching_sector = 0;
+    bool fetching = false;
+    bool seeked = false;
+    bool open = false;
+    bool quitting = false;
+    Statistics statistics{};
+
+    // Only the worker touches these while it is running.
+    CDReader_State reader;
+    CDReader_SectorIndex reader_position = 0;
+    bool reader_positioned = false;
+
+    std::thread thread;
+
+    void Touch(Sector &sector, const CDReader_SectorIndex index)
+    {
+        lru.erase(sector.lru_position);
+        lru.push_front(index);
+        sector.lru_position = lru.begin();
+    }
+
+    void Insert(const CDReader_SectorIndex index, const Words &words)
+    {
+        // Nothing newer than the read-ahead window is ever inserted, so as long as the capacity exceeds it,
+        // the sector under the head is never what gets evicted.
+        if (sectors.size() >= capacity)
+        {
+            sectors.erase(lru.back());
+            lru.pop_back();
+        }
+
+        lru.push_front(index);
+        sectors[index] = Sector{words, lru.begin()};
+    }
+
+    bool FindSectorToFetch(CDReader_SectorIndex &index) const
+    {
+        // Nothing is fetched until the emulator has said where the head is, as there is nothing to read before then.
+        if (!seeked)
+            return false;
+
+        for (std::size_t i = 0; i < read_ahead; ++i)
+        {
+            if (!sectors.contains(head + i))
+            {
+                index = head + i;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void Loop()
+    {
+        std::unique_lock lock(mutex);
+
+        for (;;)
+        {
+            CDReader_SectorIndex index;
+            condition.wait(lock, [&]() { return quitting || FindSectorToFetch(index); });
+
+            if (quitting)
+                return;
+
+            fetching = true;
+            fetching_sector = index;
+            lock.unlock();
+
+            Words words;
+
+            if (!reader_positioned || reader_position != index)
+                CDReader_SeekToSector(&reader, index);
+
+            // A failed read leaves the reader somewhere unknown, so seek again next time.
+            reader_positioned = CDReader_ReadSector(&reader, words.data());
+            reader_position = index + 1;
+
+            lock.lock();
+            Insert(index, words);
+            fetching = false;
+            condition.notify_all();
+        }
+    }
+
+public:
+    // 'capacity' must be greater than 'read_ahead', so that the sector being waited on is never evicted.
+    CDSectorCache(const std::size_t capacity = 256, const std::size_t read_ahead = 32)
+        : capacity(std::max(capacity, read_ahead + 1))
+        , read_ahead(read_ahead)
+    {
+        CDReader_Initialise(&reader);
+    }
+    CDSectorCache(const CDSectorCache&) = delete;
+    CDSectorCache& operator=(const CDSectorCache&) = delete;
+
+    ~CDSectorCache()
+    {
+        Close();
+        CDReader_Deinitialise(&reader);
+    }
+
+    // 'open_reader' opens the worker's own CDReader on the same disc as the emulator's.
+    void Open(const std::function<void(CDReader_State *reader)> &open_reader)
+    {
+        Close();
+
+        open_reader(&reader);
+        reader_positioned = false;
+
+        open = true;
+        quitting = false;
+        thread = std::thread([this]() { Loop(); });
+    }
+
+    void Close()
+    {
+        if (!open)
+            return;
+
+        {
+            std::lock_guard lock(mutex);
+            quitting = true;
+        }
+
+        condition.notify_all();
+        thread.join();
+
+        CDReader_Close(&reader);
+
+        sectors.clear();
+        lru.clear();
+        head = 0;
+        seeked = false;
+        open = false;
+        statistics = {};
+    }
+
+    bool IsOpen() const { return open; }
+
+    // For the emulator's 'cd_seeked' callback.
+    void Seek(const CDReader_SectorIndex index)
+    {
+        std::lock_guard lock(mutex);
+        head = index;
+        seeked = true;
+        condition.notify_all();
+    }
+
+    // For the emulator's 'cd_sector_read' callback. Reads the sector under the head, and advances the head.
+    void Read(cc_u16l* const buffer)
+    {
+        std::unique_lock lock(mutex);
+
+        // A reader that has not been seeked has no track to read from, so mimic that.
+        if (!open || !seeked)
+        {
+            std::fill(buffer, buffer + WORDS_PER_SECTOR, 0);
+            return;
+        }
+
+        const CDReader_SectorIndex index = head;
+        auto sector = sectors.find(index);
+
+        if (sector != sectors.end())
+        {
+            ++statistics.hits;
+        }
+        else
+        {
+            ++statistics.stalls;
+
+            if (!fetching || fetching_sector != index)
+                ++statistics.misses;
+
+            // The head's sector is always the first in the read-ahead window, so the worker gets to it next.
+            condition.wait(lock, [&]() { return (sector = sectors.find(index)) != sectors.end(); });
+        }
+
+        std::copy(sector->second.words.begin(), sector->second.words.end(), buffer);
+        Touch(sector->second, index);
+
+        ++head;
+        condition.notify_all();
+    }
+
+    Statistics GetStatistics()
+    {
+        std::lock_guard lock(mutex);
+        return statistics;
+    }
+};
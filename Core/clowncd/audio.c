@@ -2,47 +2,73 @@
 
 #include <assert.h>
 
+/* Discs may be opened on several threads at once, so the table below has to be computed exactly once. */
+#if defined(__unix__) || defined(__APPLE__)
+#define CLOWNCD_AUDIO_PTHREAD_ONCE
+#include <pthread.h>
+#endif
+
 #define CLOWNCD_AUDIO_SAMPLE_RATE 44100
 #define CLOWNCD_AUDIO_TOTAL_CHANNELS 2
 
 /* TODO: Move this to a user-provided buffer, in case the user doesn't want to always keep this allocated? */
 static ClownResampler_Precomputed clowncd_precomputed;
+
+#if defined(CLOWNCD_AUDIO_PTHREAD_ONCE)
+static pthread_once_t clowncd_precomputed_once = PTHREAD_ONCE_INIT;
+
+static void ClownCD_AudioPrecompute(void)
+{
+	ClownResampler_Precompute(&clowncd_precomputed);
+}
+#else
+/* Elsewhere, there is no portable way to do that, so discs must only be opened on one thread at a time. */
 static cc_bool clowncd_precomputed_done;
+#endif
+
+static void ClownCD_AudioResetResampler(ClownCD_Audio* const audio)
+{
+	/* Resample to the native CD sample rate. */
+	ClownResampler_HighLevel_Init(&audio->resampler, audio->metadata.total_channels, audio->metadata.sample_rate, CLOWNCD_AUDIO_SAMPLE_RATE, CLOWNCD_AUDIO_SAMPLE_RATE);
+}
 
 cc_bool ClownCD_AudioOpen(ClownCD_Audio* const audio, ClownCD_File* const file)
 {
-	ClownCD_AudioMetadata metadata;
+	ClownCD_AudioMetadata* const metadata = &audio->metadata;
 
 	audio->format = CLOWNCD_AUDIO_INVALID;
 
 #ifdef CLOWNCD_LIBSNDFILE
-	if (ClownCD_libSndFileOpen(&audio->formats.libsndfile, file, &metadata))
+	if (ClownCD_libSndFileOpen(&audio->formats.libsndfile, file, metadata))
 		audio->format = CLOWNCD_AUDIO_LIBSNDFILE;
 	else
 #else
-	if (ClownCD_FLACOpen(&audio->formats.flac, file, &metadata))
+	if (ClownCD_FLACOpen(&audio->formats.flac, file, metadata))
 		audio->format = CLOWNCD_AUDIO_FLAC;
-	else if (ClownCD_MP3Open(&audio->formats.mp3, file, &metadata))
+	else if (ClownCD_MP3Open(&audio->formats.mp3, file, metadata))
 		audio->format = CLOWNCD_AUDIO_MP3;
-	else if (ClownCD_VorbisOpen(&audio->formats.vorbis, file, &metadata))
+	else if (ClownCD_VorbisOpen(&audio->formats.vorbis, file, metadata))
 		audio->format = CLOWNCD_AUDIO_VORBIS;
-	else if (ClownCD_WAVOpen(&audio->formats.wav, file, &metadata))
+	else if (ClownCD_WAVOpen(&audio->formats.wav, file, metadata))
 		audio->format = CLOWNCD_AUDIO_WAV;
 #endif
 
 	/* Verify that the audio is in a supported format. */
 	/* TODO: Support mono audio! */
-	if (audio->format == CLOWNCD_AUDIO_INVALID || (metadata.total_channels != 1 && metadata.total_channels != 2))
+	if (audio->format == CLOWNCD_AUDIO_INVALID || (metadata->total_channels != 1 && metadata->total_channels != 2))
 		return cc_false;
 
+#if defined(CLOWNCD_AUDIO_PTHREAD_ONCE)
+	pthread_once(&clowncd_precomputed_once, ClownCD_AudioPrecompute);
+#else
 	if (!clowncd_precomputed_done)
 	{
 		clowncd_precomputed_done = cc_true;
 		ClownResampler_Precompute(&clowncd_precomputed);
 	}
+#endif
 
-	/* Resample to the native CD sample rate. */
-	ClownResampler_HighLevel_Init(&audio->resampler, metadata.total_channels, metadata.sample_rate, CLOWNCD_AUDIO_SAMPLE_RATE, CLOWNCD_AUDIO_SAMPLE_RATE);
+	ClownCD_AudioResetResampler(audio);
 
 	return cc_true;
 }
@@ -88,30 +114,44 @@ cc_bool ClownCD_AudioSeek(ClownCD_Audio* const audio, const size_t frame)
 	const size_t corrected_frame_lower = (audio->resampler.low_level.increment * (frame % CLOWNRESAMPLER_FIXED_POINT_FRACTIONAL_SIZE)) / CLOWNRESAMPLER_FIXED_POINT_FRACTIONAL_SIZE;
 	const size_t corrected_frame = corrected_frame_upper + corrected_frame_lower;
 
+	cc_bool success;
+
 	switch (audio->format)
 	{
 		case CLOWNCD_AUDIO_INVALID:
 			return cc_false;
 #ifdef CLOWNCD_LIBSNDFILE
 		case CLOWNCD_AUDIO_LIBSNDFILE:
-			return ClownCD_libSndFileSeek(&audio->formats.libsndfile, corrected_frame);
+			success = ClownCD_libSndFileSeek(&audio->formats.libsndfile, corrected_frame);
+			break;
 #else
 		case CLOWNCD_AUDIO_FLAC:
-			return ClownCD_FLACSeek(&audio->formats.flac, corrected_frame);
+			success = ClownCD_FLACSeek(&audio->formats.flac, corrected_frame);
+			break;
 
 		case CLOWNCD_AUDIO_MP3:
-			return ClownCD_MP3Seek(&audio->formats.mp3, corrected_frame);
+			success = ClownCD_MP3Seek(&audio->formats.mp3, corrected_frame);
+			break;
 
 		case CLOWNCD_AUDIO_VORBIS:
-			return ClownCD_VorbisSeek(&audio->formats.vorbis, corrected_frame);
+			success = ClownCD_VorbisSeek(&audio->formats.vorbis, corrected_frame);
+			break;
 
 		case CLOWNCD_AUDIO_WAV:
-			return ClownCD_WAVSeek(&audio->formats.wav, corrected_frame);
+			success = ClownCD_WAVSeek(&audio->formats.wav, corrected_frame);
+			break;
 #endif
 		default:
 			assert(cc_false);
 			return cc_false;
 	}
+
+	/* Discard whatever the resampler had buffered from before the seek, so that what comes after it
+	   depends only on where the seek went, and not on how much had been read beforehand. */
+	if (success)
+		ClownCD_AudioResetResampler(audio);
+
+	return success;
 }
 
 typedef struct ClownCD_ResamplerCallbackData
@@ -3,55 +3,292 @@
 #include <assert.h>
 #include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define STB_VORBIS_NO_STDIO
-#define STB_VORBIS_NO_PUSHDATA_API
 #define STB_VORBIS_MAX_CHANNELS 2
 #define STB_VORBIS_NO_COMMENTS
 #include "clowncd/audio/libraries/stb_vorbis.c"
 
 #include "clowncd/utilities.h"
 
-static cc_bool ClownCD_VorbisFileToMemory(ClownCD_File* const file, void** const out_buffer, size_t* const out_size)
+/* An Ogg page is at most 65307 bytes, so this is enough for most packets; the buffer grows for any that are larger. */
+#define CLOWNCD_VORBIS_INITIAL_INPUT_BUFFER_SIZE 0x10000
+#define CLOWNCD_VORBIS_MAXIMUM_INPUT_BUFFER_SIZE 0x100000
+
+#define CLOWNCD_VORBIS_PAGE_HEADER_SIZE 27
+
+static cc_bool ClownCD_VorbisSeekInput(ClownCD_Vorbis* const vorbis, const unsigned long position)
+{
+	vorbis->input_start = vorbis->input_end = 0;
+	vorbis->end_of_file = ClownCD_FileSeek(vorbis->file, position, CLOWNCD_SEEK_SET) != 0;
+
+	return !vorbis->end_of_file;
+}
+
+static cc_bool ClownCD_VorbisRefillInput(ClownCD_Vorbis* const vorbis)
+{
+	size_t bytes_read;
+
+	/* Discard the data that has been used, to make room for more. */
+	memmove(vorbis->input_buffer, vorbis->input_buffer + vorbis->input_start, vorbis->input_end - vorbis->input_start);
+	vorbis->input_end -= vorbis->input_start;
+	vorbis->input_start = 0;
+
+	/* If the buffer is still full, then it is too small to hold the data that stb_vorbis needs. */
+	if (vorbis->input_end == vorbis->input_buffer_size)
+	{
+		const size_t new_size = vorbis->input_buffer_size * 2;
+		unsigned char *new_buffer;
+
+		if (new_size > CLOWNCD_VORBIS_MAXIMUM_INPUT_BUFFER_SIZE)
+			return cc_false;
+
+		new_buffer = (unsigned char*)realloc(vorbis->input_buffer, new_size);
+
+		if (new_buffer == NULL)
+			return cc_false;
+
+		vorbis->input_buffer = new_buffer;
+		vorbis->input_buffer_size = new_size;
+	}
+
+	if (vorbis->end_of_file)
+		return cc_false;
+
+	bytes_read = ClownCD_FileRead(vorbis->input_buffer + vorbis->input_end, 1, vorbis->input_buffer_size - vorbis->input_end, vorbis->file);
+	vorbis->input_end += bytes_read;
+
+	if (bytes_read == 0)
+		vorbis->end_of_file = cc_true;
+
+	return bytes_read != 0;
+}
+
+static void ClownCD_VorbisDiscardOutput(ClownCD_Vorbis* const vorbis)
 {
-	if (out_buffer != NULL && out_size != NULL)
+	vorbis->output_total_frames = vorbis->output_frames_done = 0;
+}
+
+/* (Re)starts decoding from the beginning of the file. */
+static cc_bool ClownCD_VorbisStart(ClownCD_Vorbis* const vorbis)
+{
+	if (vorbis->instance != NULL)
 	{
-		const size_t size = ClownCD_FileSize(file);
+		stb_vorbis_close(vorbis->instance);
+		vorbis->instance = NULL;
+	}
+
+	ClownCD_VorbisDiscardOutput(vorbis);
+	vorbis->current_frame = 0;
+
+	if (!ClownCD_VorbisSeekInput(vorbis, 0))
+		return cc_false;
+
+	/* Keep reading until the buffer holds all of the headers. */
+	for (;;)
+	{
+		int bytes_used, error;
+
+		vorbis->instance = stb_vorbis_open_pushdata(vorbis->input_buffer, (int)vorbis->input_end, &bytes_used, &error, NULL);
 
-		if (size != CLOWNCD_SIZE_INVALID)
+		if (vorbis->instance != NULL)
 		{
-			void* const buffer = malloc(size);
+			vorbis->input_start = bytes_used;
+			return cc_true;
+		}
+
+		if (error != VORBIS_need_more_data || !ClownCD_VorbisRefillInput(vorbis))
+			return cc_false;
+	}
+}
 
-			if (buffer != NULL)
+/* Decodes frames until one produces some output. */
+static cc_bool ClownCD_VorbisDecodeFrame(ClownCD_Vorbis* const vorbis)
+{
+	for (;;)
+	{
+		int total_frames;
+		const int bytes_used = stb_vorbis_decode_frame_pushdata(vorbis->instance, vorbis->input_buffer + vorbis->input_start, (int)(vorbis->input_end - vorbis->input_start), NULL, &vorbis->output, &total_frames);
+
+		if (bytes_used == 0)
+		{
+			/* stb_vorbis needs more data to finish the packet. */
+			if (!ClownCD_VorbisRefillInput(vorbis))
+				return cc_false;
+		}
+		else
+		{
+			vorbis->input_start += bytes_used;
+
+			if (total_frames != 0)
 			{
-				if (ClownCD_FileSeek(file, 0, CLOWNCD_SEEK_SET) == 0)
-				{
-					if (ClownCD_FileRead(buffer, size, 1, file) == 1)
-					{
-						*out_buffer = buffer;
-						*out_size = size;
+				vorbis->output_total_frames = total_frames;
+				vorbis->output_frames_done = 0;
+				return cc_true;
+			}
+		}
+	}
+}
+
+/* Decodes (and discards) frames until the given one is next. */
+static cc_bool ClownCD_VorbisSkipTo(ClownCD_Vorbis* const vorbis, const size_t frame)
+{
+	while (vorbis->current_frame != frame)
+	{
+		size_t frames_to_do;
+
+		if (vorbis->output_frames_done == vorbis->output_total_frames)
+			if (!ClownCD_VorbisDecodeFrame(vorbis))
+				return cc_false;
+
+		frames_to_do = CC_MIN(vorbis->output_total_frames - vorbis->output_frames_done, frame - vorbis->current_frame);
+
+		vorbis->output_frames_done += frames_to_do;
+		vorbis->current_frame += frames_to_do;
+	}
+
+	return cc_true;
+}
+
+/* Finds every page that decoding can be resumed from, by reading just the page headers. */
+static cc_bool ClownCD_VorbisBuildPages(ClownCD_Vorbis* const vorbis)
+{
+	/* The decoder is still reading from here, so it must be returned to afterwards. */
+	const long original_position = ClownCD_FileTell(vorbis->file);
 
-						return cc_true;
-					}
+	cc_bool success = cc_true;
+	unsigned long position = 0;
+	size_t capacity = 0;
+
+	for (;;)
+	{
+		unsigned char header[CLOWNCD_VORBIS_PAGE_HEADER_SIZE], segments[0xFF];
+		unsigned int total_segments, i;
+		unsigned long body_size, frame;
+		cc_bool has_frame;
+
+		if (ClownCD_FileSeek(vorbis->file, position, CLOWNCD_SEEK_SET) != 0)
+			break;
+
+		if (ClownCD_FileRead(header, sizeof(header), 1, vorbis->file) != 1 || memcmp(header, "OggS", 4) != 0)
+			break;
+
+		total_segments = header[26];
+
+		if (ClownCD_FileRead(segments, 1, total_segments, vorbis->file) != total_segments)
+			break;
+
+		body_size = 0;
+
+		for (i = 0; i < total_segments; ++i)
+			body_size += segments[i];
+
+		/* A granule position of -1 means that no packet ends on this page.
+		   Frame numbers are kept to 32 bits, like stb_vorbis does. */
+		frame = ClownCD_ReadUintMemory(&header[6], 4, cc_false);
+		has_frame = frame != 0xFFFFFFFF || ClownCD_ReadUintMemory(&header[10], 4, cc_false) != 0xFFFFFFFF;
+
+		/* stb_vorbis cannot tell where it is after resuming from a page whose last packet continues onto the next,
+		   and the header pages (the only ones at frame 0) are not audio. */
+		if (has_frame && frame != 0 && total_segments != 0 && segments[total_segments - 1] != 0xFF)
+		{
+			if (vorbis->total_pages == capacity)
+			{
+				const size_t new_capacity = capacity == 0 ? 0x100 : capacity * 2;
+				ClownCD_VorbisPage* const new_pages = (ClownCD_VorbisPage*)realloc(vorbis->pages, new_capacity * sizeof(*vorbis->pages));
+
+				if (new_pages == NULL)
+				{
+					free(vorbis->pages);
+					vorbis->pages = NULL;
+					vorbis->total_pages = 0;
+					success = cc_false;
+					break;
 				}
 
-				free(buffer);
+				vorbis->pages = new_pages;
+				capacity = new_capacity;
 			}
+
+			vorbis->pages[vorbis->total_pages].position = position;
+			vorbis->pages[vorbis->total_pages].frame = frame;
+			++vorbis->total_pages;
 		}
+
+		position += CLOWNCD_VORBIS_PAGE_HEADER_SIZE + total_segments + body_size;
 	}
 
-	return cc_false;
+	if (original_position < 0 || ClownCD_FileSeek(vorbis->file, original_position, CLOWNCD_SEEK_SET) != 0)
+		vorbis->end_of_file = cc_true;
+
+	return success;
 }
 
-cc_bool ClownCD_VorbisOpen(ClownCD_Vorbis* const vorbis, ClownCD_File* const file, ClownCD_AudioMetadata* const metadata)
+/* Returns the last page that decoding can be resumed from while still producing the given frame, or NULL if there is none. */
+static const ClownCD_VorbisPage* ClownCD_VorbisFindPage(const ClownCD_Vorbis* const vorbis, const size_t frame)
 {
-	size_t size;
+	/* After resuming, stb_vorbis decodes one packet without outputting it, to prime the overlap,
+	   so leave enough room for that packet. */
+	const size_t priming_frames = vorbis->instance->blocksize_1 / 2;
 
-	if (ClownCD_VorbisFileToMemory(file, &vorbis->file_buffer, &size))
+	size_t low = 0, high = vorbis->total_pages;
+
+	if (frame < priming_frames)
+		return NULL;
+
+	/* Binary search for the first page that is too late. */
+	while (low != high)
 	{
-		vorbis->instance = stb_vorbis_open_memory((const unsigned char*)vorbis->file_buffer, size, NULL, NULL);
+		const size_t middle = low + (high - low) / 2;
 
-		if (vorbis->instance != NULL)
+		if (vorbis->pages[middle].frame <= frame - priming_frames)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	return low == 0 ? NULL : &vorbis->pages[low - 1];
+}
+
+static cc_bool ClownCD_VorbisResume(ClownCD_Vorbis* const vorbis, const ClownCD_VorbisPage* const page, const size_t frame)
+{
+	int end_frame;
+
+	if (!ClownCD_VorbisSeekInput(vorbis, page->position))
+		return cc_false;
+
+	/* stb_vorbis skips the page that it resynchronises on, and carries on from the one after,
+	   knowing that it starts at the page's frame. */
+	stb_vorbis_flush_pushdata(vorbis->instance);
+	ClownCD_VorbisDiscardOutput(vorbis);
+
+	if (!ClownCD_VorbisDecodeFrame(vorbis))
+		return cc_false;
+
+	end_frame = stb_vorbis_get_sample_offset(vorbis->instance);
+
+	if (end_frame < 0 || (size_t)end_frame - vorbis->output_total_frames > frame)
+		return cc_false;
+
+	vorbis->current_frame = (size_t)end_frame - vorbis->output_total_frames;
+
+	return cc_true;
+}
+
+cc_bool ClownCD_VorbisOpen(ClownCD_Vorbis* const vorbis, ClownCD_File* const file, ClownCD_AudioMetadata* const metadata)
+{
+	vorbis->file = file;
+	vorbis->instance = NULL;
+	vorbis->input_buffer_size = CLOWNCD_VORBIS_INITIAL_INPUT_BUFFER_SIZE;
+	vorbis->input_buffer = (unsigned char*)malloc(vorbis->input_buffer_size);
+	vorbis->pages = NULL;
+	vorbis->total_pages = 0;
+	vorbis->pages_built = cc_false;
+
+	if (vorbis->input_buffer != NULL)
+	{
+		if (ClownCD_VorbisStart(vorbis))
 		{
 			const stb_vorbis_info vorbis_info = stb_vorbis_get_info(vorbis->instance);
 
@@ -61,7 +298,10 @@ cc_bool ClownCD_VorbisOpen(ClownCD_Vorbis* const vorbis, ClownCD_File* const fil
 			return cc_true;
 		}
 
-		free(vorbis->file_buffer);
+		if (vorbis->instance != NULL)
+			stb_vorbis_close(vorbis->instance);
+
+		free(vorbis->input_buffer);
 	}
 
 	return cc_false;
@@ -70,15 +310,60 @@ cc_bool ClownCD_VorbisOpen(ClownCD_Vorbis* const vorbis, ClownCD_File* const fil
 void ClownCD_VorbisClose(ClownCD_Vorbis* const vorbis)
 {
 	stb_vorbis_close(vorbis->instance);
-	free(vorbis->file_buffer);
+	free(vorbis->input_buffer);
+	free(vorbis->pages);
 }
 
 cc_bool ClownCD_VorbisSeek(ClownCD_Vorbis* const vorbis, const size_t frame)
 {
-	return stb_vorbis_seek_frame(vorbis->instance, frame) != 0;
+	const ClownCD_VorbisPage *page;
+
+	/* Opening a track always seeks to its start, so make that free. */
+	if (frame == vorbis->current_frame)
+		return cc_true;
+
+	if (!vorbis->pages_built)
+	{
+		/* Without a seek table, seeking still works, just by decoding from the start. */
+		ClownCD_VorbisBuildPages(vorbis);
+		vorbis->pages_built = cc_true;
+	}
+
+	page = ClownCD_VorbisFindPage(vorbis, frame);
+
+	/* If the frame is not far ahead, then it is cheaper to just decode up to it. */
+	if (frame > vorbis->current_frame && (page == NULL || page->frame <= vorbis->current_frame))
+		return ClownCD_VorbisSkipTo(vorbis, frame);
+
+	if (page == NULL || !ClownCD_VorbisResume(vorbis, page, frame))
+		if (!ClownCD_VorbisStart(vorbis))
+			return cc_false;
+
+	return ClownCD_VorbisSkipTo(vorbis, frame);
 }
 
 size_t ClownCD_VorbisRead(ClownCD_Vorbis* const vorbis, short* const buffer, const size_t total_frames)
 {
-	return stb_vorbis_get_samples_short_interleaved(vorbis->instance, vorbis->instance->channels, buffer, total_frames * vorbis->instance->channels);
+	const int total_channels = vorbis->instance->channels;
+
+	size_t frames_done = 0;
+
+	while (frames_done != total_frames)
+	{
+		size_t frames_to_do;
+
+		if (vorbis->output_frames_done == vorbis->output_total_frames)
+			if (!ClownCD_VorbisDecodeFrame(vorbis))
+				break;
+
+		frames_to_do = CC_MIN(vorbis->output_total_frames - vorbis->output_frames_done, total_frames - frames_done);
+
+		convert_channels_short_interleaved(total_channels, &buffer[frames_done * total_channels], total_channels, vorbis->output, (int)vorbis->output_frames_done, (int)frames_to_do);
+
+		vorbis->output_frames_done += frames_to_do;
+		vorbis->current_frame += frames_to_do;
+		frames_done += frames_to_do;
+	}
+
+	return frames_done;
 }
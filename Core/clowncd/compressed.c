@@ -0,0 +1,1020 @@
+#include "clowncd/compressed.h"
+
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CLOWNCD_COMPRESSED_SECTOR_SIZE 2352
+#define CLOWNCD_COMPRESSED_HEADER_TRACKS_OFFSET 10
+#define CLOWNCD_COMPRESSED_MAP_HEADER_SIZE 12
+#define CLOWNCD_COMPRESSED_MAP_ENTRY_SIZE 13
+/* Enough to keep the data track and an audio track going at the same time, even when both straddle hunks. */
+#define CLOWNCD_COMPRESSED_CACHED_HUNKS 4
+
+/* LZ matches are addressed with 16-bit offsets, so hunks cannot be any larger than this. */
+#define CLOWNCD_COMPRESSED_MAXIMUM_HUNK_SIZE 0xFFFF
+#define CLOWNCD_COMPRESSED_LZ_MINIMUM_MATCH 4
+#define CLOWNCD_COMPRESSED_LZ_HASH_BITS 12
+#define CLOWNCD_COMPRESSED_LZ_SEARCH_DEPTH 32
+
+/* Audio is coded per channel, with a fixed polynomial predictor and Rice-coded residuals, like FLAC's 'FIXED' subframes. */
+#define CLOWNCD_COMPRESSED_AUDIO_MAXIMUM_ORDER 3
+#define CLOWNCD_COMPRESSED_AUDIO_PARTITION_FRAMES (CLOWNCD_COMPRESSED_SECTOR_SIZE / 4)
+#define CLOWNCD_COMPRESSED_AUDIO_MAXIMUM_RICE_PARAMETER 23
+/* A quotient this long is replaced by the residual's raw bits, so that an outlier cannot blow up the output. */
+#define CLOWNCD_COMPRESSED_AUDIO_ESCAPE_QUOTIENT 32
+#define CLOWNCD_COMPRESSED_AUDIO_ESCAPE_BITS 24
+
+typedef enum ClownCD_CompressedCodec
+{
+	CLOWNCD_COMPRESSED_CODEC_STORED,
+	CLOWNCD_COMPRESSED_CODEC_LZ,
+	CLOWNCD_COMPRESSED_CODEC_AUDIO
+} ClownCD_CompressedCodec;
+
+typedef struct ClownCD_CompressedHunk
+{
+	unsigned long offset, size, crc;
+	ClownCD_CompressedCodec codec;
+} ClownCD_CompressedHunk;
+
+typedef struct ClownCD_CompressedCachedHunk
+{
+	unsigned char *data;
+	unsigned long hunk;
+	unsigned long last_used;
+	cc_bool valid;
+} ClownCD_CompressedCachedHunk;
+
+typedef struct ClownCD_CompressedFile
+{
+	ClownCD_File file;
+	unsigned char *header;
+	size_t header_size;
+	size_t payload_size, hunk_size, total_hunks;
+	ClownCD_CompressedHunk *hunks;
+	unsigned char *compressed_buffer;
+	ClownCD_CompressedCachedHunk cache[CLOWNCD_COMPRESSED_CACHED_HUNKS];
+	unsigned long clock;
+	size_t position;
+} ClownCD_CompressedFile;
+
+/********
+* CRC-32 *
+********/
+
+static unsigned long ClownCD_CompressedCRC(const unsigned char* const buffer, const size_t size)
+{
+	/* A nibble-wide table is small enough to not need generating at runtime. */
+	static const unsigned long table[0x10] = {
+		0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+		0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+	};
+
+	unsigned long crc = 0xFFFFFFFF;
+	size_t i;
+
+	for (i = 0; i < size; ++i)
+	{
+		crc ^= buffer[i];
+		crc = (crc >> 4) ^ table[crc & 0xF];
+		crc = (crc >> 4) ^ table[crc & 0xF];
+	}
+
+	return ~crc & 0xFFFFFFFF;
+}
+
+/************
+* Bitstreams *
+************/
+
+typedef struct ClownCD_CompressedBitstream
+{
+	unsigned char *data;
+	size_t total_bits, position;
+} ClownCD_CompressedBitstream;
+
+static void ClownCD_CompressedBitstreamInitialise(ClownCD_CompressedBitstream* const bitstream, unsigned char* const data, const size_t size)
+{
+	bitstream->data = data;
+	bitstream->total_bits = size * 8;
+	bitstream->position = 0;
+}
+
+static cc_bool ClownCD_CompressedBitstreamWrite(ClownCD_CompressedBitstream* const bitstream, const unsigned long value, unsigned int total_bits)
+{
+	if (total_bits > bitstream->total_bits - bitstream->position)
+		return cc_false;
+
+	while (total_bits != 0)
+	{
+		const unsigned int bit_in_byte = bitstream->position % 8;
+		const unsigned int bits_free = 8 - bit_in_byte;
+		const unsigned int bits_to_do = CC_MIN(bits_free, total_bits);
+		const unsigned int bits = (value >> (total_bits - bits_to_do)) & ((1u << bits_to_do) - 1);
+		unsigned char* const byte = &bitstream->data[bitstream->position / 8];
+
+		if (bit_in_byte == 0)
+			*byte = 0;
+
+		*byte |= bits << (bits_free - bits_to_do);
+
+		bitstream->position += bits_to_do;
+		total_bits -= bits_to_do;
+	}
+
+	return cc_true;
+}
+
+static cc_bool ClownCD_CompressedBitstreamRead(ClownCD_CompressedBitstream* const bitstream, unsigned int total_bits, unsigned long* const value)
+{
+	unsigned long result = 0;
+
+	if (total_bits > bitstream->total_bits - bitstream->position)
+		return cc_false;
+
+	while (total_bits != 0)
+	{
+		const unsigned int bit_in_byte = bitstream->position % 8;
+		const unsigned int bits_available = 8 - bit_in_byte;
+		const unsigned int bits_to_do = CC_MIN(bits_available, total_bits);
+		const unsigned int byte = bitstream->data[bitstream->position / 8];
+
+		result = (result << bits_to_do) | ((byte >> (bits_available - bits_to_do)) & ((1u << bits_to_do) - 1));
+
+		bitstream->position += bits_to_do;
+		total_bits -= bits_to_do;
+	}
+
+	*value = result;
+	return cc_true;
+}
+
+static size_t ClownCD_CompressedBitstreamGetSize(const ClownCD_CompressedBitstream* const bitstream)
+{
+	return CC_DIVIDE_CEILING(bitstream->position, 8);
+}
+
+/****
+* LZ *
+****/
+
+/* The format is a series of sequences, each made of a token byte, literal bytes, and a match:
+   the token's upper nibble is the number of literals and its lower nibble is the match length minus the minimum,
+   with 15 meaning that the count continues in the following bytes, which are summed until one is not 255.
+   The literals are followed by the match's 16-bit big-endian offset, and then the match's length bytes, if any.
+   The final sequence has no match, and ends exactly at the end of the hunk. */
+
+static cc_bool ClownCD_CompressedLZWriteLength(unsigned char* const output, const size_t output_size, size_t* const output_position, size_t length)
+{
+	for (;;)
+	{
+		const unsigned int byte = CC_MIN(length, 0xFF);
+
+		if (*output_position == output_size)
+			return cc_false;
+
+		output[(*output_position)++] = byte;
+		length -= byte;
+
+		if (byte != 0xFF)
+			return cc_true;
+	}
+}
+
+static cc_bool ClownCD_CompressedLZWriteSequence(unsigned char* const output, const size_t output_size, size_t* const output_position, const unsigned char* const literals, const size_t total_literals, const size_t match_offset, const size_t match_length)
+{
+	const size_t match_length_code = match_length == 0 ? 0 : match_length - CLOWNCD_COMPRESSED_LZ_MINIMUM_MATCH;
+	const unsigned int literals_nibble = CC_MIN(total_literals, 0xF);
+	const unsigned int match_nibble = CC_MIN(match_length_code, 0xF);
+
+	if (*output_position == output_size)
+		return cc_false;
+
+	output[(*output_position)++] = (literals_nibble << 4) | match_nibble;
+
+	if (literals_nibble == 0xF && !ClownCD_CompressedLZWriteLength(output, output_size, output_position, total_literals - 0xF))
+		return cc_false;
+
+	if (total_literals > output_size - *output_position)
+		return cc_false;
+
+	memcpy(&output[*output_position], literals, total_literals);
+	*output_position += total_literals;
+
+	if (match_length != 0)
+	{
+		if (output_size - *output_position < 2)
+			return cc_false;
+
+		ClownCD_WriteU16BEMemory(&output[*output_position], match_offset);
+		*output_position += 2;
+
+		if (match_nibble == 0xF && !ClownCD_CompressedLZWriteLength(output, output_size, output_position, match_length_code - 0xF))
+			return cc_false;
+	}
+
+	return cc_true;
+}
+
+static size_t ClownCD_CompressedLZHash(const unsigned char* const bytes)
+{
+	const unsigned long value = ClownCD_ReadU32BEMemory(bytes);
+	return ((value * 2654435761UL) & 0xFFFFFFFF) >> (32 - CLOWNCD_COMPRESSED_LZ_HASH_BITS);
+}
+
+/* Returns the compressed size, or 0 if the output did not fit. */
+static size_t ClownCD_CompressedLZCompress(unsigned char* const output, const size_t output_size, const unsigned char* const input, const size_t input_size, size_t* const chain)
+{
+	size_t heads[1 << CLOWNCD_COMPRESSED_LZ_HASH_BITS];
+	size_t output_position = 0;
+	size_t literals_start = 0;
+	size_t position = 0;
+	size_t i;
+
+	/* 'input_size' doubles as 'no entry'. */
+	for (i = 0; i < CC_COUNT_OF(heads); ++i)
+		heads[i] = input_size;
+
+	while (position + CLOWNCD_COMPRESSED_LZ_MINIMUM_MATCH <= input_size)
+	{
+		const size_t hash = ClownCD_CompressedLZHash(&input[position]);
+		size_t best_length = 0, best_offset = 0;
+		size_t candidate = heads[hash];
+		unsigned int depth;
+
+		for (depth = 0; depth < CLOWNCD_COMPRESSED_LZ_SEARCH_DEPTH && candidate != input_size; ++depth)
+		{
+			size_t length = 0;
+
+			while (position + length < input_size && input[candidate + length] == input[position + length])
+				++length;
+
+			if (length > best_length)
+			{
+				best_length = length;
+				best_offset = position - candidate;
+			}
+
+			candidate = chain[candidate];
+		}
+
+		chain[position] = heads[hash];
+		heads[hash] = position;
+
+		if (best_length < CLOWNCD_COMPRESSED_LZ_MINIMUM_MATCH)
+		{
+			++position;
+		}
+		else
+		{
+			const size_t match_end = position + best_length;
+
+			if (!ClownCD_CompressedLZWriteSequence(output, output_size, &output_position, &input[literals_start], position - literals_start, best_offset, best_length))
+				return 0;
+
+			/* Index the positions inside of the match too, so that later matches can refer to them. */
+			for (++position; position < match_end; ++position)
+			{
+				if (position + CLOWNCD_COMPRESSED_LZ_MINIMUM_MATCH <= input_size)
+				{
+					const size_t inner_hash = ClownCD_CompressedLZHash(&input[position]);
+
+					chain[position] = heads[inner_hash];
+					heads[inner_hash] = position;
+				}
+			}
+
+			literals_start = position;
+		}
+	}
+
+	if (!ClownCD_CompressedLZWriteSequence(output, output_size, &output_position, &input[literals_start], input_size - literals_start, 0, 0))
+		return 0;
+
+	return output_position;
+}
+
+static cc_bool ClownCD_CompressedLZReadLength(const unsigned char* const input, const size_t input_size, size_t* const input_position, size_t* const length)
+{
+	for (;;)
+	{
+		unsigned int byte;
+
+		if (*input_position == input_size)
+			return cc_false;
+
+		byte = input[(*input_position)++];
+		*length += byte;
+
+		if (byte != 0xFF)
+			return cc_true;
+	}
+}
+
+static cc_bool ClownCD_CompressedLZDecompress(unsigned char* const output, const size_t output_size, const unsigned char* const input, const size_t input_size)
+{
+	size_t input_position = 0;
+	size_t output_position = 0;
+
+	for (;;)
+	{
+		unsigned int token;
+		size_t total_literals, match_offset, match_length;
+
+		if (input_position == input_size)
+			return cc_false;
+
+		token = input[input_position++];
+		total_literals = token >> 4;
+
+		if (total_literals == 0xF && !ClownCD_CompressedLZReadLength(input, input_size, &input_position, &total_literals))
+			return cc_false;
+
+		if (total_literals > input_size - input_position || total_literals > output_size - output_position)
+			return cc_false;
+
+		memcpy(&output[output_position], &input[input_position], total_literals);
+		input_position += total_literals;
+		output_position += total_literals;
+
+		if (output_position == output_size)
+			return input_position == input_size;
+
+		if (input_size - input_position < 2)
+			return cc_false;
+
+		match_offset = ClownCD_ReadU16BEMemory(&input[input_position]);
+		input_position += 2;
+
+		match_length = token & 0xF;
+
+		if (match_length == 0xF && !ClownCD_CompressedLZReadLength(input, input_size, &input_position, &match_length))
+			return cc_false;
+
+		match_length += CLOWNCD_COMPRESSED_LZ_MINIMUM_MATCH;
+
+		if (match_offset == 0 || match_offset > output_position || match_length > output_size - output_position)
+			return cc_false;
+
+		/* Matches may overlap themselves, so this must be done a byte at a time. */
+		for (; match_length != 0; --match_length, ++output_position)
+			output[output_position] = output[output_position - match_offset];
+	}
+}
+
+/*******
+* Audio *
+*******/
+
+/* Each channel has a 2-bit predictor order, then that many verbatim 16-bit warm-up samples, then one partition per
+   sector's worth of frames. Each partition has a 5-bit Rice parameter, followed by a Rice code for each residual. */
+
+static long ClownCD_CompressedAudioGetSample(const unsigned char* const samples, const size_t frame, const unsigned int channel)
+{
+	return ClownCD_ReadSintMemory(&samples[(frame * 2 + channel) * 2], 2, cc_false);
+}
+
+static long ClownCD_CompressedAudioPredict(const unsigned char* const samples, const size_t frame, const unsigned int channel, const unsigned int order)
+{
+	switch (order)
+	{
+		default:
+			assert(cc_false);
+			/* Fallthrough */
+		case 0:
+			return 0;
+
+		case 1:
+			return ClownCD_CompressedAudioGetSample(samples, frame - 1, channel);
+
+		case 2:
+			return 2 * ClownCD_CompressedAudioGetSample(samples, frame - 1, channel) - ClownCD_CompressedAudioGetSample(samples, frame - 2, channel);
+
+		case 3:
+			return 3 * ClownCD_CompressedAudioGetSample(samples, frame - 1, channel) - 3 * ClownCD_CompressedAudioGetSample(samples, frame - 2, channel) + ClownCD_CompressedAudioGetSample(samples, frame - 3, channel);
+	}
+}
+
+static unsigned long ClownCD_CompressedAudioZigZag(const long residual)
+{
+	return residual < 0 ? (unsigned long)-(residual + 1) * 2 + 1 : (unsigned long)residual * 2;
+}
+
+static long ClownCD_CompressedAudioUnZigZag(const unsigned long value)
+{
+	return value % 2 != 0 ? -(long)(value / 2) - 1 : (long)(value / 2);
+}
+
+static unsigned int ClownCD_CompressedAudioChooseOrder(const unsigned char* const samples, const size_t total_frames, const unsigned int channel)
+{
+	unsigned long best_cost = ULONG_MAX;
+	unsigned int best_order = 0;
+	unsigned int order;
+
+	for (order = 0; order <= CLOWNCD_COMPRESSED_AUDIO_MAXIMUM_ORDER; ++order)
+	{
+		unsigned long cost = 0;
+		size_t frame;
+
+		for (frame = CLOWNCD_COMPRESSED_AUDIO_MAXIMUM_ORDER; frame < total_frames; ++frame)
+			cost += ClownCD_CompressedAudioZigZag(ClownCD_CompressedAudioGetSample(samples, frame, channel) - ClownCD_CompressedAudioPredict(samples, frame, channel, order));
+
+		if (cost < best_cost)
+		{
+			best_cost = cost;
+			best_order = order;
+		}
+	}
+
+	return best_order;
+}
+
+static cc_bool ClownCD_CompressedAudioWriteResidual(ClownCD_CompressedBitstream* const bitstream, const unsigned long value, const unsigned int rice_parameter)
+{
+	const unsigned long quotient = value >> rice_parameter;
+
+	if (quotient >= CLOWNCD_COMPRESSED_AUDIO_ESCAPE_QUOTIENT)
+		return ClownCD_CompressedBitstreamWrite(bitstream, 0, CLOWNCD_COMPRESSED_AUDIO_ESCAPE_QUOTIENT)
+			&& ClownCD_CompressedBitstreamWrite(bitstream, value, CLOWNCD_COMPRESSED_AUDIO_ESCAPE_BITS);
+	else
+		return ClownCD_CompressedBitstreamWrite(bitstream, 1, quotient + 1)
+			&& ClownCD_CompressedBitstreamWrite(bitstream, value, rice_parameter);
+}
+
+static cc_bool ClownCD_CompressedAudioReadResidual(ClownCD_CompressedBitstream* const bitstream, const unsigned int rice_parameter, unsigned long* const value)
+{
+	unsigned long quotient, bit, remainder;
+
+	for (quotient = 0; quotient < CLOWNCD_COMPRESSED_AUDIO_ESCAPE_QUOTIENT; ++quotient)
+	{
+		if (!ClownCD_CompressedBitstreamRead(bitstream, 1, &bit))
+			return cc_false;
+
+		if (bit != 0)
+		{
+			if (!ClownCD_CompressedBitstreamRead(bitstream, rice_parameter, &remainder))
+				return cc_false;
+
+			*value = quotient << rice_parameter | remainder;
+			return cc_true;
+		}
+	}
+
+	return ClownCD_CompressedBitstreamRead(bitstream, CLOWNCD_COMPRESSED_AUDIO_ESCAPE_BITS, value);
+}
+
+/* Returns the compressed size, or 0 if the output did not fit. */
+static size_t ClownCD_CompressedAudioCompress(unsigned char* const output, const size_t output_size, const unsigned char* const input, const size_t input_size)
+{
+	const size_t total_frames = input_size / 4;
+
+	ClownCD_CompressedBitstream bitstream;
+	unsigned int channel;
+
+	if (input_size % 4 != 0 || total_frames < CLOWNCD_COMPRESSED_AUDIO_MAXIMUM_ORDER)
+		return 0;
+
+	ClownCD_CompressedBitstreamInitialise(&bitstream, output, output_size);
+
+	for (channel = 0; channel < 2; ++channel)
+	{
+		const unsigned int order = ClownCD_CompressedAudioChooseOrder(input, total_frames, channel);
+
+		size_t partition_start, frame;
+
+		if (!ClownCD_CompressedBitstreamWrite(&bitstream, order, 2))
+			return 0;
+
+		for (frame = 0; frame < order; ++frame)
+			if (!ClownCD_CompressedBitstreamWrite(&bitstream, ClownCD_CompressedAudioGetSample(input, frame, channel) & 0xFFFF, 16))
+				return 0;
+
+		for (partition_start = 0; partition_start < total_frames; partition_start += CLOWNCD_COMPRESSED_AUDIO_PARTITION_FRAMES)
+		{
+			const size_t partition_end = CC_MIN(partition_start + CLOWNCD_COMPRESSED_AUDIO_PARTITION_FRAMES, total_frames);
+			const size_t first_frame = CC_MAX(partition_start, order);
+
+			unsigned long sum = 0;
+			unsigned int rice_parameter = 0;
+
+			for (frame = first_frame; frame < partition_end; ++frame)
+				sum += ClownCD_CompressedAudioZigZag(ClownCD_CompressedAudioGetSample(input, frame, channel) - ClownCD_CompressedAudioPredict(input, frame, channel, order));
+
+			/* The best parameter is roughly the logarithm of the mean. */
+			while (rice_parameter < CLOWNCD_COMPRESSED_AUDIO_MAXIMUM_RICE_PARAMETER && ((unsigned long)(partition_end - first_frame) << (rice_parameter + 1)) < sum)
+				++rice_parameter;
+
+			if (!ClownCD_CompressedBitstreamWrite(&bitstream, rice_parameter, 5))
+				return 0;
+
+			for (frame = first_frame; frame < partition_end; ++frame)
+			{
+				const long residual = ClownCD_CompressedAudioGetSample(input, frame, channel) - ClownCD_CompressedAudioPredict(input, frame, channel, order);
+
+				if (!ClownCD_CompressedAudioWriteResidual(&bitstream, ClownCD_CompressedAudioZigZag(residual), rice_parameter))
+					return 0;
+			}
+		}
+	}
+
+	return ClownCD_CompressedBitstreamGetSize(&bitstream);
+}
+
+static cc_bool ClownCD_CompressedAudioDecompress(unsigned char* const output, const size_t output_size, unsigned char* const input, const size_t input_size)
+{
+	const size_t total_frames = output_size / 4;
+
+	ClownCD_CompressedBitstream bitstream;
+	unsigned int channel;
+
+	if (output_size % 4 != 0 || total_frames < CLOWNCD_COMPRESSED_AUDIO_MAXIMUM_ORDER)
+		return cc_false;
+
+	ClownCD_CompressedBitstreamInitialise(&bitstream, input, input_size);
+
+	for (channel = 0; channel < 2; ++channel)
+	{
+		unsigned long order, value;
+		size_t partition_start, frame;
+
+		if (!ClownCD_CompressedBitstreamRead(&bitstream, 2, &order))
+			return cc_false;
+
+		for (frame = 0; frame < order; ++frame)
+		{
+			if (!ClownCD_CompressedBitstreamRead(&bitstream, 16, &value))
+				return cc_false;
+
+			ClownCD_WriteU16LEMemory(&output[(frame * 2 + channel) * 2], value);
+		}
+
+		for (partition_start = 0; partition_start < total_frames; partition_start += CLOWNCD_COMPRESSED_AUDIO_PARTITION_FRAMES)
+		{
+			const size_t partition_end = CC_MIN(partition_start + CLOWNCD_COMPRESSED_AUDIO_PARTITION_FRAMES, total_frames);
+			unsigned long rice_parameter;
+
+			if (!ClownCD_CompressedBitstreamRead(&bitstream, 5, &rice_parameter) || rice_parameter > CLOWNCD_COMPRESSED_AUDIO_MAXIMUM_RICE_PARAMETER)
+				return cc_false;
+
+			for (frame = CC_MAX(partition_start, order); frame < partition_end; ++frame)
+			{
+				long sample;
+
+				if (!ClownCD_CompressedAudioReadResidual(&bitstream, rice_parameter, &value))
+					return cc_false;
+
+				sample = ClownCD_CompressedAudioPredict(output, frame, channel, order) + ClownCD_CompressedAudioUnZigZag(value);
+
+				if (sample < -0x8000 || sample > 0x7FFF)
+					return cc_false;
+
+				ClownCD_WriteU16LEMemory(&output[(frame * 2 + channel) * 2], sample & 0xFFFF);
+			}
+		}
+	}
+
+	return cc_true;
+}
+
+/*************
+* Decompressor *
+*************/
+
+static size_t ClownCD_CompressedFileGetHunkSize(const ClownCD_CompressedFile* const file, const size_t hunk)
+{
+	const size_t hunk_start = hunk * file->hunk_size;
+	const size_t bytes_remaining = file->payload_size - hunk_start;
+
+	return CC_MIN(bytes_remaining, file->hunk_size);
+}
+
+static cc_bool ClownCD_CompressedFileDecompress(ClownCD_CompressedFile* const file, const size_t hunk_index, unsigned char* const output)
+{
+	const ClownCD_CompressedHunk* const hunk = &file->hunks[hunk_index];
+	const size_t output_size = ClownCD_CompressedFileGetHunkSize(file, hunk_index);
+	/* Stored hunks can be read straight into place. */
+	unsigned char* const input = hunk->codec == CLOWNCD_COMPRESSED_CODEC_STORED ? output : file->compressed_buffer;
+
+	if (ClownCD_FileSeek(&file->file, hunk->offset, CLOWNCD_SEEK_SET) != 0)
+		return cc_false;
+
+	if (ClownCD_FileRead(input, 1, hunk->size, &file->file) != hunk->size)
+		return cc_false;
+
+	switch (hunk->codec)
+	{
+		case CLOWNCD_COMPRESSED_CODEC_STORED:
+			if (hunk->size != output_size)
+				return cc_false;
+			break;
+
+		case CLOWNCD_COMPRESSED_CODEC_LZ:
+			if (!ClownCD_CompressedLZDecompress(output, output_size, input, hunk->size))
+				return cc_false;
+			break;
+
+		case CLOWNCD_COMPRESSED_CODEC_AUDIO:
+			if (!ClownCD_CompressedAudioDecompress(output, output_size, input, hunk->size))
+				return cc_false;
+			break;
+
+		default:
+			return cc_false;
+	}
+
+	return ClownCD_CompressedCRC(output, output_size) == hunk->crc;
+}
+
+static const unsigned char* ClownCD_CompressedFileGetHunk(ClownCD_CompressedFile* const file, const size_t hunk)
+{
+	ClownCD_CompressedCachedHunk *slot = &file->cache[0];
+	size_t i;
+
+	for (i = 0; i < CC_COUNT_OF(file->cache); ++i)
+	{
+		ClownCD_CompressedCachedHunk* const cached_hunk = &file->cache[i];
+
+		if (cached_hunk->valid && cached_hunk->hunk == hunk)
+		{
+			cached_hunk->last_used = ++file->clock;
+			return cached_hunk->data;
+		}
+
+		/* Otherwise, replace whichever hunk has gone unused the longest. */
+		if (!cached_hunk->valid || (slot->valid && cached_hunk->last_used < slot->last_used))
+			slot = cached_hunk;
+	}
+
+	slot->valid = ClownCD_CompressedFileDecompress(file, hunk, slot->data);
+
+	if (!slot->valid)
+		return NULL;
+
+	slot->hunk = hunk;
+	slot->last_used = ++file->clock;
+	return slot->data;
+}
+
+static void ClownCD_CompressedFileFree(ClownCD_CompressedFile* const file)
+{
+	free(file->header);
+	free(file->hunks);
+	free(file->compressed_buffer);
+	free(file->cache[0].data);
+	free(file);
+}
+
+static cc_bool ClownCD_CompressedFileLoad(ClownCD_CompressedFile* const file)
+{
+	unsigned char map_header[CLOWNCD_COMPRESSED_MAP_HEADER_SIZE];
+	unsigned char *map;
+	size_t i;
+
+	if (ClownCD_FileSeek(&file->file, CLOWNCD_COMPRESSED_HEADER_TRACKS_OFFSET, CLOWNCD_SEEK_SET) != 0)
+		return cc_false;
+
+	/* The header and track table are the same as a version 0 image's, so they are passed through untouched. */
+	file->header_size = CLOWNCD_COMPRESSED_HEADER_TRACKS_OFFSET + 2 + ClownCD_ReadU16BE(&file->file) * 10;
+	file->header = (unsigned char*)malloc(file->header_size);
+
+	if (file->header == NULL)
+		return cc_false;
+
+	if (ClownCD_FileSeek(&file->file, 0, CLOWNCD_SEEK_SET) != 0 || ClownCD_FileRead(file->header, file->header_size, 1, &file->file) != 1)
+		return cc_false;
+
+	if (ClownCD_FileRead(map_header, sizeof(map_header), 1, &file->file) != 1)
+		return cc_false;
+
+	file->payload_size = ClownCD_ReadU32BEMemory(&map_header[0]);
+	file->hunk_size = ClownCD_ReadU32BEMemory(&map_header[4]);
+	file->total_hunks = ClownCD_ReadU32BEMemory(&map_header[8]);
+
+	if (file->hunk_size == 0 || file->hunk_size > CLOWNCD_COMPRESSED_MAXIMUM_HUNK_SIZE || file->total_hunks != CC_DIVIDE_CEILING(file->payload_size, file->hunk_size))
+		return cc_false;
+
+	file->hunks = (ClownCD_CompressedHunk*)malloc(CC_MAX(1, file->total_hunks) * sizeof(ClownCD_CompressedHunk));
+	file->compressed_buffer = (unsigned char*)malloc(file->hunk_size);
+	file->cache[0].data = (unsigned char*)malloc(file->hunk_size * CC_COUNT_OF(file->cache));
+	map = (unsigned char*)malloc(CC_MAX(1, file->total_hunks) * CLOWNCD_COMPRESSED_MAP_ENTRY_SIZE);
+
+	if (file->hunks == NULL || file->compressed_buffer == NULL || file->cache[0].data == NULL || map == NULL)
+	{
+		free(map);
+		return cc_false;
+	}
+
+	if (ClownCD_FileRead(map, CLOWNCD_COMPRESSED_MAP_ENTRY_SIZE, file->total_hunks, &file->file) != file->total_hunks)
+	{
+		free(map);
+		return cc_false;
+	}
+
+	for (i = 0; i < file->total_hunks; ++i)
+	{
+		const unsigned char* const entry = &map[i * CLOWNCD_COMPRESSED_MAP_ENTRY_SIZE];
+		ClownCD_CompressedHunk* const hunk = &file->hunks[i];
+
+		hunk->offset = ClownCD_ReadU32BEMemory(&entry[0]);
+		hunk->size = ClownCD_ReadU32BEMemory(&entry[4]);
+		hunk->crc = ClownCD_ReadU32BEMemory(&entry[8]);
+		hunk->codec = (ClownCD_CompressedCodec)entry[12];
+
+		/* Compressed hunks are never larger than uncompressed ones, so this keeps 'compressed_buffer' big enough. */
+		if (hunk->size > file->hunk_size)
+		{
+			free(map);
+			return cc_false;
+		}
+	}
+
+	free(map);
+
+	for (i = 0; i < CC_COUNT_OF(file->cache); ++i)
+	{
+		file->cache[i].data = file->cache[0].data + i * file->hunk_size;
+		file->cache[i].hunk = 0;
+		file->cache[i].last_used = 0;
+		file->cache[i].valid = cc_false;
+	}
+
+	return cc_true;
+}
+
+static const ClownCD_FileCallbacks* ClownCD_GetCompressedFileCallbacks(void);
+
+static void* ClownCD_FileOpenCompressed(const char* const filename, const ClownCD_FileMode mode)
+{
+	ClownCD_File file;
+
+	if (mode != CLOWNCD_RB)
+		return NULL;
+
+	file = ClownCD_FileOpen(filename, mode, NULL);
+
+	if (!ClownCD_CompressedFileOpen(&file))
+		return NULL;
+
+	return file.stream;
+}
+
+static int ClownCD_FileCloseCompressed(void* const stream)
+{
+	ClownCD_CompressedFile* const file = (ClownCD_CompressedFile*)stream;
+	const int result = ClownCD_FileClose(&file->file);
+
+	ClownCD_CompressedFileFree(file);
+	return result;
+}
+
+static size_t ClownCD_FileReadCompressed(void* const buffer, const size_t size, const size_t count, void* const stream)
+{
+	ClownCD_CompressedFile* const file = (ClownCD_CompressedFile*)stream;
+	unsigned char* const bytes = (unsigned char*)buffer;
+	const size_t bytes_wanted = size * count;
+	const size_t total_size = file->header_size + file->payload_size;
+
+	size_t bytes_done = 0;
+
+	if (size == 0)
+		return 0;
+
+	while (bytes_done != bytes_wanted && file->position < total_size)
+	{
+		const unsigned char *source;
+		size_t bytes_available;
+
+		if (file->position < file->header_size)
+		{
+			source = &file->header[file->position];
+			bytes_available = file->header_size - file->position;
+		}
+		else
+		{
+			const size_t payload_position = file->position - file->header_size;
+			const size_t hunk = payload_position / file->hunk_size;
+			const size_t position_in_hunk = payload_position % file->hunk_size;
+			const unsigned char* const hunk_data = ClownCD_CompressedFileGetHunk(file, hunk);
+
+			/* A hunk that cannot be decompressed, or which fails its CRC, ends the read early, like a read error would. */
+			if (hunk_data == NULL)
+				break;
+
+			source = &hunk_data[position_in_hunk];
+			bytes_available = ClownCD_CompressedFileGetHunkSize(file, hunk) - position_in_hunk;
+		}
+
+		{
+			const size_t bytes_remaining = bytes_wanted - bytes_done;
+			const size_t bytes_to_do = CC_MIN(bytes_remaining, bytes_available);
+
+			memcpy(&bytes[bytes_done], source, bytes_to_do);
+			bytes_done += bytes_to_do;
+			file->position += bytes_to_do;
+		}
+	}
+
+	return bytes_done / size;
+}
+
+static size_t ClownCD_FileWriteCompressed(const void* const buffer, const size_t size, const size_t count, void* const stream)
+{
+	(void)buffer;
+	(void)size;
+	(void)count;
+	(void)stream;
+
+	return 0;
+}
+
+static long ClownCD_FileTellCompressed(void* const stream)
+{
+	ClownCD_CompressedFile* const file = (ClownCD_CompressedFile*)stream;
+
+	if (file->position > LONG_MAX)
+		return -1L;
+	else
+		return (long)file->position;
+}
+
+static int ClownCD_FileSeekCompressed(void* const stream, const long position, const ClownCD_FileOrigin origin)
+{
+	ClownCD_CompressedFile* const file = (ClownCD_CompressedFile*)stream;
+	size_t base;
+
+	switch (origin)
+	{
+		case CLOWNCD_SEEK_SET:
+			base = 0;
+			break;
+
+		case CLOWNCD_SEEK_CUR:
+			base = file->position;
+			break;
+
+		case CLOWNCD_SEEK_END:
+			base = file->header_size + file->payload_size;
+			break;
+
+		default:
+			return 1;
+	}
+
+	/* As with 'fseek', seeking past the end is allowed, but seeking before the start is not. */
+	if (position < 0 && (unsigned long)-(position + 1) >= base)
+		return 1;
+
+	file->position = position < 0 ? base - (size_t)-(position + 1) - 1 : base + (size_t)position;
+
+	return 0;
+}
+
+static const ClownCD_FileCallbacks* ClownCD_GetCompressedFileCallbacks(void)
+{
+	static const ClownCD_FileCallbacks compressed_callbacks = {
+		ClownCD_FileOpenCompressed,
+		ClownCD_FileCloseCompressed,
+		ClownCD_FileReadCompressed,
+		ClownCD_FileWriteCompressed,
+		ClownCD_FileTellCompressed,
+		ClownCD_FileSeekCompressed
+	};
+
+	return &compressed_callbacks;
+}
+
+cc_bool ClownCD_CompressedFileOpen(ClownCD_File* const file)
+{
+	ClownCD_CompressedFile* const compressed_file = (ClownCD_CompressedFile*)calloc(1, sizeof(ClownCD_CompressedFile));
+
+	if (compressed_file != NULL)
+	{
+		compressed_file->file = *file;
+
+		if (ClownCD_CompressedFileLoad(compressed_file))
+		{
+			*file = ClownCD_FileOpenAlreadyOpen(compressed_file, ClownCD_GetCompressedFileCallbacks());
+			return cc_true;
+		}
+
+		ClownCD_CompressedFileFree(compressed_file);
+	}
+
+	ClownCD_FileClose(file);
+	return cc_false;
+}
+
+/***********
+* Compressor *
+***********/
+
+cc_bool ClownCD_CompressedWrite(ClownCD_File* const output, ClownCD_File* const input, const size_t hunk_sectors)
+{
+	const size_t hunk_size = hunk_sectors * CLOWNCD_COMPRESSED_SECTOR_SIZE;
+	const long input_start = ClownCD_FileTell(input);
+	const size_t input_end = ClownCD_FileSize(input);
+	const long map_start = ClownCD_FileTell(output);
+
+	cc_bool success = cc_false;
+	size_t payload_size, total_hunks;
+	unsigned char *buffers, *hunk_buffer, *lz_buffer, *audio_buffer;
+	size_t *lz_chain;
+	ClownCD_CompressedHunk *hunks;
+
+	if (hunk_size == 0 || hunk_size > CLOWNCD_COMPRESSED_MAXIMUM_HUNK_SIZE || input_start == -1L || input_end == CLOWNCD_SIZE_INVALID || (size_t)input_start > input_end || map_start == -1L)
+		return cc_false;
+
+	payload_size = input_end - (size_t)input_start;
+	total_hunks = CC_DIVIDE_CEILING(payload_size, hunk_size);
+
+	if (payload_size > 0xFFFFFFFF)
+		return cc_false;
+
+	buffers = (unsigned char*)malloc(hunk_size * 3);
+	lz_chain = (size_t*)malloc(hunk_size * sizeof(size_t));
+	hunks = (ClownCD_CompressedHunk*)malloc(CC_MAX(1, total_hunks) * sizeof(ClownCD_CompressedHunk));
+
+	if (buffers != NULL && lz_chain != NULL && hunks != NULL)
+	{
+		size_t i;
+
+		hunk_buffer = buffers;
+		lz_buffer = buffers + hunk_size;
+		audio_buffer = buffers + hunk_size * 2;
+
+		/* Skip the map for now: it is filled-in once the hunks' sizes are known. */
+		if (ClownCD_FileSeek(output, map_start + CLOWNCD_COMPRESSED_MAP_HEADER_SIZE + total_hunks * CLOWNCD_COMPRESSED_MAP_ENTRY_SIZE, CLOWNCD_SEEK_SET) == 0)
+		{
+			for (i = 0; i < total_hunks; ++i)
+			{
+				const size_t bytes_remaining = payload_size - i * hunk_size;
+				const size_t size = CC_MIN(bytes_remaining, hunk_size);
+				const long offset = ClownCD_FileTell(output);
+				ClownCD_CompressedHunk* const hunk = &hunks[i];
+
+				size_t lz_size, audio_size;
+				const unsigned char *data;
+
+				if (offset == -1L || (unsigned long)offset > 0xFFFFFFFF)
+					break;
+
+				if (ClownCD_FileRead(hunk_buffer, 1, size, input) != size)
+					break;
+
+				/* Use whichever codec does best, storing the hunk as-is if neither of them helps. */
+				lz_size = ClownCD_CompressedLZCompress(lz_buffer, size - 1, hunk_buffer, size, lz_chain);
+				audio_size = ClownCD_CompressedAudioCompress(audio_buffer, size - 1, hunk_buffer, size);
+
+				hunk->offset = offset;
+				hunk->crc = ClownCD_CompressedCRC(hunk_buffer, size);
+
+				if (audio_size != 0 && (lz_size == 0 || audio_size < lz_size))
+				{
+					hunk->codec = CLOWNCD_COMPRESSED_CODEC_AUDIO;
+					hunk->size = audio_size;
+					data = audio_buffer;
+				}
+				else if (lz_size != 0)
+				{
+					hunk->codec = CLOWNCD_COMPRESSED_CODEC_LZ;
+					hunk->size = lz_size;
+					data = lz_buffer;
+				}
+				else
+				{
+					hunk->codec = CLOWNCD_COMPRESSED_CODEC_STORED;
+					hunk->size = size;
+					data = hunk_buffer;
+				}
+
+				if (ClownCD_FileWrite(data, 1, hunk->size, output) != hunk->size)
+					break;
+			}
+
+			if (i == total_hunks && ClownCD_FileSeek(output, map_start, CLOWNCD_SEEK_SET) == 0)
+			{
+				ClownCD_WriteU32BE(output, payload_size);
+				ClownCD_WriteU32BE(output, hunk_size);
+				ClownCD_WriteU32BE(output, total_hunks);
+
+				for (i = 0; i < total_hunks; ++i)
+				{
+					ClownCD_WriteU32BE(output, hunks[i].offset);
+					ClownCD_WriteU32BE(output, hunks[i].size);
+					ClownCD_WriteU32BE(output, hunks[i].crc);
+					ClownCD_WriteU8(output, hunks[i].codec);
+				}
+
+				success = ClownCD_FileSeek(output, 0, CLOWNCD_SEEK_END) == 0;
+			}
+		}
+	}
+
+	free(buffers);
+	free(lz_chain);
+	free(hunks);
+
+	return success;
+}
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "clowncd/compressed.h"
 #include "clowncd/cue.h"
 #include "clowncd/file-io.h"
 #include "clowncd/utilities.h"
@@ -64,13 +65,17 @@ static void Callback(void* const user_data, const char* const filename, const Cl
 
 int main(const int argc, char** const argv)
 {
-	if (argc < 3)
+	/* With '--compress', the sector data is compressed and written after the header, producing a self-contained image. */
+	const cc_bool compress = argc >= 2 && strcmp(argv[1], "--compress") == 0;
+	char** const arguments = compress ? &argv[1] : &argv[0];
+
+	if (argc - (compress ? 1 : 0) < 3)
 	{
-		fprintf(stderr, "Usage: %s input-filename output-filename\n", argv[0]);
+		fprintf(stderr, "Usage: %s [--compress] input-filename output-filename\n", argv[0]);
 	}
 	else
 	{
-		const char* const cue_filename = argv[1];
+		const char* const cue_filename = arguments[1];
 		ClownCD_File cue_file = ClownCD_FileOpen(cue_filename, CLOWNCD_RB, NULL);
 
 		if (!ClownCD_FileIsOpen(&cue_file))
@@ -79,7 +84,7 @@ int main(const int argc, char** const argv)
 		}
 		else
 		{
-			ClownCD_File header_file = ClownCD_FileOpen(argv[2], CLOWNCD_WB, NULL);
+			ClownCD_File header_file = ClownCD_FileOpen(arguments[2], CLOWNCD_WB, NULL);
 
 			if (!ClownCD_FileIsOpen(&header_file))
 			{
@@ -97,7 +102,7 @@ int main(const int argc, char** const argv)
 				state.track_filename = NULL;
 
 				ClownCD_FileWrite(identifier, sizeof(identifier), 1, &header_file); /* Identifier. */
-				ClownCD_WriteU16BE(&header_file, 0); /* Version. */
+				ClownCD_WriteU16BE(&header_file, compress ? CLOWNCD_COMPRESSED_VERSION : 0); /* Version. */
 				ClownCD_WriteU16BE(&header_file, 0); /* Total tracks (will be filled-in later). */
 
 				for (i = 0; ; ++i)
@@ -107,6 +112,31 @@ int main(const int argc, char** const argv)
 				ClownCD_FileSeek(&header_file, 8 + 2, CLOWNCD_SEEK_SET);
 				ClownCD_WriteU16BE(&header_file, i); /* Total tracks. */
 
+				if (compress)
+				{
+					char* const track_path = state.track_filename == NULL ? NULL : ClownCD_GetFullFilePath(cue_filename, state.track_filename);
+					ClownCD_File track_file = track_path == NULL ? ClownCD_FileOpenBlank() : ClownCD_FileOpen(track_path, CLOWNCD_RB, NULL);
+
+					if (!ClownCD_FileIsOpen(&track_file))
+					{
+						fputs("Could not open track file.\n", stderr);
+					}
+					else
+					{
+						/* The hunk map goes right after the track table. */
+						ClownCD_FileSeek(&header_file, 8 + 2 + 2 + i * 10, CLOWNCD_SEEK_SET);
+
+						if (!ClownCD_CompressedWrite(&header_file, &track_file, CLOWNCD_COMPRESSED_DEFAULT_HUNK_SECTORS))
+							fputs("Could not compress track file.\n", stderr);
+
+						ClownCD_FileClose(&track_file);
+					}
+
+					free(track_path);
+				}
+
+				free(state.track_filename);
+
 				ClownCD_FileClose(&header_file);
 			}
 
@@ -80,47 +80,57 @@ static ClownCD_CueTrackType ClownCD_CueTrackTypeFromString(const char* const str
 		return CLOWNCD_CUE_TRACK_INVALID;
 }
 
-static size_t ClownCD_CueGetLineLength(ClownCD_File* const file)
+static char* ClownCD_CueReadLine(ClownCD_File* const file)
 {
+	/* The line is read in chunks, and then the file is rewound to just after the line's terminator. */
+	const size_t chunk_size = 0x100;
 	const long line_file_position = ClownCD_FileTell(file);
+
+	char *line = NULL;
 	size_t line_length = 0;
+	cc_bool line_ended = cc_false;
 
-	for (;;)
+	while (!line_ended)
 	{
-		const unsigned long character = ClownCD_ReadU8(file);
+		char* const new_line = (char*)realloc(line, line_length + chunk_size + 1);
+		size_t bytes_read, i;
 
-		if (file->eof)
-			break;
+		if (new_line == NULL)
+		{
+			free(line);
+			return NULL;
+		}
 
-		++line_length;
+		line = new_line;
+		bytes_read = ClownCD_FileRead(&line[line_length], 1, chunk_size, file);
 
-		if (character == '\r' || character == '\n')
-			break;
-	}
+		for (i = 0; i < bytes_read; ++i)
+		{
+			const char character = line[line_length + i];
 
-	ClownCD_FileSeek(file, line_file_position, CLOWNCD_SEEK_SET);
+			if (character == '\r' || character == '\n')
+			{
+				line_ended = cc_true;
+				++i;
+				break;
+			}
+		}
 
-	return line_length;
-}
+		line_length += i;
 
-static char* ClownCD_CueReadLine(ClownCD_File* const file)
-{
-	const size_t line_length = ClownCD_CueGetLineLength(file);
-	char *line = (char*)malloc(line_length + 1);
+		if (bytes_read != chunk_size)
+			break;
+	}
 
-	if (line != NULL)
+	if (line_length == 0)
 	{
-		if (ClownCD_FileRead(line, line_length, 1, file) != 1)
-		{
-			free(line);
-			line = NULL;
-		}
-		else
-		{
-			line[line_length] = '\0';
-		}
+		free(line);
+		return NULL;
 	}
 
+	line[line_length] = '\0';
+	ClownCD_FileSeek(file, line_file_position + (long)line_length, CLOWNCD_SEEK_SET);
+
 	return line;
 }
 
@@ -340,3 +350,196 @@ unsigned long ClownCD_CueGetTrackIndexEndingSector(ClownCD_File* const file, con
 
 	return state.ending_sector;
 }
+
+typedef struct ClownCD_CueSheetLoad_State
+{
+	ClownCD_CueSheet *sheet;
+	size_t track_indices_capacity;
+	cc_bool out_of_memory;
+} ClownCD_CueSheetLoad_State;
+
+static size_t ClownCD_CueSheetAddFile(ClownCD_CueSheetLoad_State* const state, const char* const filename, const ClownCD_CueFileType file_type)
+{
+	ClownCD_CueSheet* const sheet = state->sheet;
+	ClownCD_CueSheetFile *new_files;
+	char *filename_copy;
+
+	/* A file is usually followed by all of its indices, so it is most likely to be the last one. */
+	size_t i = sheet->total_files;
+
+	while (i-- != 0)
+		if (strcmp(sheet->files[i].filename, filename) == 0)
+			return i;
+
+	new_files = (ClownCD_CueSheetFile*)realloc(sheet->files, (sheet->total_files + 1) * sizeof(ClownCD_CueSheetFile));
+
+	if (new_files == NULL)
+		return CLOWNCD_SIZE_INVALID;
+
+	sheet->files = new_files;
+
+	filename_copy = (char*)malloc(strlen(filename) + 1);
+
+	if (filename_copy == NULL)
+		return CLOWNCD_SIZE_INVALID;
+
+	strcpy(filename_copy, filename);
+
+	sheet->files[sheet->total_files].filename = filename_copy;
+	sheet->files[sheet->total_files].type = file_type;
+
+	return sheet->total_files++;
+}
+
+static void ClownCD_CueSheetLoad_Callback(void* const user_data, const char* const filename, const ClownCD_CueFileType file_type, const unsigned int track, const ClownCD_CueTrackType track_type, const unsigned int index, const unsigned long sector)
+{
+	ClownCD_CueSheetLoad_State* const state = (ClownCD_CueSheetLoad_State*)user_data;
+	ClownCD_CueSheet* const sheet = state->sheet;
+	ClownCD_CueSheetTrackIndex *track_index;
+	size_t file;
+
+	if (state->out_of_memory)
+		return;
+
+	file = ClownCD_CueSheetAddFile(state, filename, file_type);
+
+	if (file == CLOWNCD_SIZE_INVALID)
+	{
+		state->out_of_memory = cc_true;
+		return;
+	}
+
+	if (sheet->total_track_indices == state->track_indices_capacity)
+	{
+		const size_t new_capacity = state->track_indices_capacity == 0 ? 8 : state->track_indices_capacity * 2;
+		ClownCD_CueSheetTrackIndex* const new_track_indices = (ClownCD_CueSheetTrackIndex*)realloc(sheet->track_indices, new_capacity * sizeof(ClownCD_CueSheetTrackIndex));
+
+		if (new_track_indices == NULL)
+		{
+			state->out_of_memory = cc_true;
+			return;
+		}
+
+		sheet->track_indices = new_track_indices;
+		state->track_indices_capacity = new_capacity;
+	}
+
+	track_index = &sheet->track_indices[sheet->total_track_indices++];
+	track_index->file = file;
+	track_index->track = track;
+	track_index->index = index;
+	track_index->type = track_type;
+	track_index->starting_sector = sector;
+	track_index->ending_sector = 0xFFFFFFFF;
+}
+
+void ClownCD_CueSheetInitialise(ClownCD_CueSheet* const sheet)
+{
+	size_t i;
+
+	sheet->files = NULL;
+	sheet->total_files = 0;
+	sheet->track_indices = NULL;
+	sheet->total_track_indices = 0;
+
+	for (i = 0; i < CC_COUNT_OF(sheet->first_track_index); ++i)
+		sheet->first_track_index[i] = 0;
+}
+
+cc_bool ClownCD_CueSheetLoad(ClownCD_CueSheet* const sheet, ClownCD_File* const file)
+{
+	ClownCD_CueSheetLoad_State state;
+	ClownCD_CueSheetTrackIndex *sorted_track_indices;
+	size_t i, j;
+
+	ClownCD_CueSheetInitialise(sheet);
+
+	state.sheet = sheet;
+	state.track_indices_capacity = 0;
+	state.out_of_memory = cc_false;
+
+	if (!ClownCD_CueParse(file, ClownCD_CueSheetLoad_Callback, &state) || state.out_of_memory)
+	{
+		ClownCD_CueSheetFree(sheet);
+		return cc_false;
+	}
+
+	/* An index ends where the next one in the same file begins. This matches 'ClownCD_CueGetTrackIndexEndingSector'. */
+	for (i = 0; i < sheet->total_track_indices; ++i)
+	{
+		ClownCD_CueSheetTrackIndex* const track_index = &sheet->track_indices[i];
+
+		for (j = 0; j < sheet->total_track_indices; ++j)
+		{
+			const ClownCD_CueSheetTrackIndex* const other = &sheet->track_indices[j];
+
+			if (other->file == track_index->file && (other->track != track_index->track || other->index != track_index->index) && other->starting_sector > track_index->starting_sector && other->starting_sector < track_index->ending_sector)
+				track_index->ending_sector = other->starting_sector;
+		}
+	}
+
+	/* Group the indices by track, so that a track's indices can be found without searching. */
+	/* Tracks that cannot exist on a real disc are dropped here, as nothing could ever seek to them. */
+	sorted_track_indices = (ClownCD_CueSheetTrackIndex*)malloc(CC_MAX(1, sheet->total_track_indices) * sizeof(ClownCD_CueSheetTrackIndex));
+
+	if (sorted_track_indices == NULL)
+	{
+		ClownCD_CueSheetFree(sheet);
+		return cc_false;
+	}
+
+	for (i = 0; i < sheet->total_track_indices; ++i)
+		if (sheet->track_indices[i].track < CLOWNCD_CUE_MAXIMUM_TRACKS)
+			++sheet->first_track_index[sheet->track_indices[i].track + 1];
+
+	for (i = 1; i < CC_COUNT_OF(sheet->first_track_index); ++i)
+		sheet->first_track_index[i] += sheet->first_track_index[i - 1];
+
+	for (i = 0; i < sheet->total_track_indices; ++i)
+	{
+		const ClownCD_CueSheetTrackIndex* const track_index = &sheet->track_indices[i];
+
+		/* 'first_track_index' is used as a write cursor here, and is restored below. */
+		if (track_index->track < CLOWNCD_CUE_MAXIMUM_TRACKS)
+			sorted_track_indices[sheet->first_track_index[track_index->track]++] = *track_index;
+	}
+
+	for (i = CC_COUNT_OF(sheet->first_track_index) - 1; i != 0; --i)
+		sheet->first_track_index[i] = sheet->first_track_index[i - 1];
+
+	sheet->first_track_index[0] = 0;
+	sheet->total_track_indices = sheet->first_track_index[CLOWNCD_CUE_MAXIMUM_TRACKS];
+
+	free(sheet->track_indices);
+	sheet->track_indices = sorted_track_indices;
+
+	return cc_true;
+}
+
+void ClownCD_CueSheetFree(ClownCD_CueSheet* const sheet)
+{
+	size_t i;
+
+	for (i = 0; i < sheet->total_files; ++i)
+		free(sheet->files[i].filename);
+
+	free(sheet->files);
+	free(sheet->track_indices);
+
+	ClownCD_CueSheetInitialise(sheet);
+}
+
+const ClownCD_CueSheetTrackIndex* ClownCD_CueSheetFind(const ClownCD_CueSheet* const sheet, const unsigned int track, const unsigned int index)
+{
+	size_t i;
+
+	if (track >= CLOWNCD_CUE_MAXIMUM_TRACKS)
+		return NULL;
+
+	/* Search backwards, so that a repeated index resolves to its last occurrence, as it does when reparsing the sheet. */
+	for (i = sheet->first_track_index[track + 1]; i-- != sheet->first_track_index[track]; )
+		if (sheet->track_indices[i].index == index)
+			return &sheet->track_indices[i];
+
+	return NULL;
+}
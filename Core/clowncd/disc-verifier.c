@@ -0,0 +1,366 @@
+/* Checks the EDC of every sector in a disc's data tracks, spread across several threads.
+   From the root of the repository, build it with:
+
+   cc -std=c99 -O2 -ICore -ICore/include Core/clowncd/disc-verifier.c Core/clowncd/unity.c -pthread -lm -o disc-verifier */
+
+/* For 'clock_gettime'. */
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "clowncd/clowncd.h"
+#include "clowncd/cue.h"
+#include "clowncd/file-io.h"
+#include "clowncd/utilities.h"
+
+/* Sectors are handed out to the threads in batches, so that they rarely have to wait on each other. */
+#define SECTORS_PER_JOB 0x100
+
+typedef struct Range
+{
+	size_t file;
+	unsigned int track;
+	unsigned long starting_sector, ending_sector;
+} Range;
+
+typedef struct BadSector
+{
+	size_t file;
+	unsigned int track;
+	unsigned long sector;
+} BadSector;
+
+typedef struct State
+{
+	const char *cue_filename;
+	const ClownCD_CueSheet *sheet;
+	const Range *ranges;
+	size_t total_ranges;
+
+	/* Everything below is shared between the threads, and guarded by the mutex. */
+	pthread_mutex_t mutex;
+	size_t next_range;
+	unsigned long next_sector;
+	BadSector *bad_sectors;
+	size_t total_bad_sectors, bad_sectors_capacity;
+	cc_bool failed;
+} State;
+
+static char* GetTrackPath(const State* const state, const size_t file)
+{
+	return ClownCD_GetFullFilePath(state->cue_filename, state->sheet->files[file].filename);
+}
+
+static cc_bool TakeJob(State* const state, Range* const job)
+{
+	cc_bool success = cc_false;
+
+	pthread_mutex_lock(&state->mutex);
+
+	while (state->next_range != state->total_ranges)
+	{
+		const Range* const range = &state->ranges[state->next_range];
+
+		if (state->next_sector < range->ending_sector)
+		{
+			*job = *range;
+			job->starting_sector = state->next_sector;
+			job->ending_sector = CC_MIN(state->next_sector + SECTORS_PER_JOB, range->ending_sector);
+
+			state->next_sector = job->ending_sector;
+			success = cc_true;
+			break;
+		}
+
+		if (++state->next_range != state->total_ranges)
+			state->next_sector = state->ranges[state->next_range].starting_sector;
+	}
+
+	pthread_mutex_unlock(&state->mutex);
+
+	return success;
+}
+
+static void AddBadSector(State* const state, const Range* const job, const unsigned long sector)
+{
+	pthread_mutex_lock(&state->mutex);
+
+	if (state->total_bad_sectors == state->bad_sectors_capacity)
+	{
+		const size_t new_capacity = state->bad_sectors_capacity == 0 ? 0x100 : state->bad_sectors_capacity * 2;
+		BadSector* const new_bad_sectors = (BadSector*)realloc(state->bad_sectors, new_capacity * sizeof(*state->bad_sectors));
+
+		if (new_bad_sectors == NULL)
+		{
+			state->failed = cc_true;
+			pthread_mutex_unlock(&state->mutex);
+			return;
+		}
+
+		state->bad_sectors = new_bad_sectors;
+		state->bad_sectors_capacity = new_capacity;
+	}
+
+	state->bad_sectors[state->total_bad_sectors].file = job->file;
+	state->bad_sectors[state->total_bad_sectors].track = job->track;
+	state->bad_sectors[state->total_bad_sectors].sector = sector;
+	++state->total_bad_sectors;
+
+	pthread_mutex_unlock(&state->mutex);
+}
+
+static void Fail(State* const state, const char* const message)
+{
+	pthread_mutex_lock(&state->mutex);
+
+	if (!state->failed)
+		fputs(message, stderr);
+
+	state->failed = cc_true;
+
+	pthread_mutex_unlock(&state->mutex);
+}
+
+static void* Worker(void* const user_data)
+{
+	State* const state = (State*)user_data;
+	unsigned char* const buffer = (unsigned char*)malloc(SECTORS_PER_JOB * CLOWNCD_SECTOR_RAW_SIZE);
+	ClownCD_File file = ClownCD_FileOpenBlank();
+	size_t current_file = (size_t)-1;
+	Range job;
+
+	if (buffer == NULL)
+	{
+		Fail(state, "Could not allocate memory for sector buffer.\n");
+		return NULL;
+	}
+
+	while (TakeJob(state, &job))
+	{
+		const size_t total_sectors = job.ending_sector - job.starting_sector;
+		size_t i;
+
+		/* Each thread has handles of its own, so that they can all read at once. */
+		if (job.file != current_file)
+		{
+			char* const path = GetTrackPath(state, job.file);
+
+			if (ClownCD_FileIsOpen(&file))
+				ClownCD_FileClose(&file);
+
+			file = path == NULL ? ClownCD_FileOpenBlank() : ClownCD_FileOpen(path, CLOWNCD_RB, ClownCD_GetMappedFileCallbacks());
+			current_file = job.file;
+			free(path);
+		}
+
+		if (!ClownCD_FileIsOpen(&file))
+		{
+			Fail(state, "Could not open track file.\n");
+			break;
+		}
+
+		if (ClownCD_FileSeek(&file, job.starting_sector * CLOWNCD_SECTOR_RAW_SIZE, CLOWNCD_SEEK_SET) != 0
+		 || ClownCD_FileRead(buffer, CLOWNCD_SECTOR_RAW_SIZE, total_sectors, &file) != total_sectors)
+		{
+			Fail(state, "Could not read track file.\n");
+			break;
+		}
+
+		for (i = 0; i < total_sectors; ++i)
+			if (!ClownCD_ValidateSectorCRC(&buffer[i * CLOWNCD_SECTOR_RAW_SIZE]))
+				AddBadSector(state, &job, job.starting_sector + i);
+	}
+
+	if (ClownCD_FileIsOpen(&file))
+		ClownCD_FileClose(&file);
+
+	free(buffer);
+
+	return NULL;
+}
+
+static int CompareBadSectors(const void* const a, const void* const b)
+{
+	const BadSector* const bad_sector_a = (const BadSector*)a;
+	const BadSector* const bad_sector_b = (const BadSector*)b;
+
+	if (bad_sector_a->file != bad_sector_b->file)
+		return bad_sector_a->file < bad_sector_b->file ? -1 : 1;
+
+	if (bad_sector_a->sector != bad_sector_b->sector)
+		return bad_sector_a->sector < bad_sector_b->sector ? -1 : 1;
+
+	return 0;
+}
+
+/* Collects the sectors of every data track, clamping open-ended tracks to the end of their file. */
+static Range* GetRanges(const State* const state, size_t* const total_ranges, unsigned long* const total_sectors)
+{
+	const ClownCD_CueSheet* const sheet = state->sheet;
+	Range* const ranges = (Range*)malloc(CC_MAX(1, sheet->total_track_indices) * sizeof(Range));
+	size_t i;
+
+	if (ranges == NULL)
+		return NULL;
+
+	*total_ranges = 0;
+	*total_sectors = 0;
+
+	for (i = 0; i < sheet->total_track_indices; ++i)
+	{
+		const ClownCD_CueSheetTrackIndex* const track_index = &sheet->track_indices[i];
+		unsigned long ending_sector = track_index->ending_sector;
+
+		/* Only MODE1/2352 sectors have an EDC. A repeated index only counts once, like it does for seeking. */
+		if (track_index->type != CLOWNCD_CUE_TRACK_MODE1_2352 || sheet->files[track_index->file].type != CLOWNCD_CUE_FILE_BINARY)
+			continue;
+
+		if (ClownCD_CueSheetFind(sheet, track_index->track, track_index->index) != track_index)
+			continue;
+
+		if (ending_sector == 0xFFFFFFFF)
+		{
+			char* const path = GetTrackPath(state, track_index->file);
+			ClownCD_File file = path == NULL ? ClownCD_FileOpenBlank() : ClownCD_FileOpen(path, CLOWNCD_RB, NULL);
+
+			free(path);
+
+			if (!ClownCD_FileIsOpen(&file))
+			{
+				fputs("Could not open track file.\n", stderr);
+				free(ranges);
+				return NULL;
+			}
+
+			ending_sector = ClownCD_FileSize(&file) / CLOWNCD_SECTOR_RAW_SIZE;
+			ClownCD_FileClose(&file);
+		}
+
+		if (ending_sector <= track_index->starting_sector)
+			continue;
+
+		ranges[*total_ranges].file = track_index->file;
+		ranges[*total_ranges].track = track_index->track;
+		ranges[*total_ranges].starting_sector = track_index->starting_sector;
+		ranges[*total_ranges].ending_sector = ending_sector;
+		++*total_ranges;
+
+		*total_sectors += ending_sector - track_index->starting_sector;
+	}
+
+	return ranges;
+}
+
+static double GetTime(void)
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1000000000.0;
+}
+
+int main(const int argc, char** const argv)
+{
+	const cc_bool threads_given = argc >= 3 && strcmp(argv[1], "-j") == 0;
+	const char* const cue_filename = threads_given ? argv[3] : argv[1];
+	const long total_processors = sysconf(_SC_NPROCESSORS_ONLN);
+	const unsigned int total_threads = threads_given ? (unsigned int)strtoul(argv[2], NULL, 0) : total_processors < 1 ? 1 : (unsigned int)total_processors;
+
+	int exit_code = EXIT_FAILURE;
+
+	if (argc - (threads_given ? 2 : 0) < 2 || total_threads == 0)
+	{
+		fprintf(stderr, "Usage: %s [-j threads] input-filename\n", argv[0]);
+	}
+	else
+	{
+		ClownCD_File cue_file = ClownCD_FileOpen(cue_filename, CLOWNCD_RB, NULL);
+		ClownCD_CueSheet sheet;
+
+		ClownCD_CueSheetInitialise(&sheet);
+
+		if (!ClownCD_FileIsOpen(&cue_file))
+		{
+			fputs("Could not open input file.\n", stderr);
+		}
+		else if (!ClownCD_CueSheetLoad(&sheet, &cue_file))
+		{
+			fputs("Could not parse cue sheet.\n", stderr);
+		}
+		else
+		{
+			pthread_t* const threads = (pthread_t*)malloc(total_threads * sizeof(pthread_t));
+			State state;
+			Range *ranges;
+			unsigned long total_sectors;
+
+			memset(&state, 0, sizeof(state));
+			state.cue_filename = cue_filename;
+			state.sheet = &sheet;
+
+			ranges = GetRanges(&state, &state.total_ranges, &total_sectors);
+
+			if (threads == NULL || ranges == NULL)
+			{
+				fputs("Could not allocate memory.\n", stderr);
+			}
+			else
+			{
+				const double starting_time = GetTime();
+				double seconds;
+				unsigned int threads_started, i;
+
+				state.ranges = ranges;
+				state.next_sector = state.total_ranges == 0 ? 0 : ranges[0].starting_sector;
+				pthread_mutex_init(&state.mutex, NULL);
+
+				for (threads_started = 0; threads_started < total_threads; ++threads_started)
+					if (pthread_create(&threads[threads_started], NULL, Worker, &state) != 0)
+						break;
+
+				/* With no threads, there is nobody to do the work. */
+				if (threads_started == 0)
+					Worker(&state);
+
+				for (i = 0; i < threads_started; ++i)
+					pthread_join(threads[i], NULL);
+
+				seconds = GetTime() - starting_time;
+
+				pthread_mutex_destroy(&state.mutex);
+
+				qsort(state.bad_sectors, state.total_bad_sectors, sizeof(*state.bad_sectors), CompareBadSectors);
+
+				for (i = 0; i < state.total_bad_sectors; ++i)
+				{
+					const BadSector* const bad_sector = &state.bad_sectors[i];
+
+					printf("Bad EDC: track %02u, '%s' sector %lu (%02lu:%02lu:%02lu).\n", bad_sector->track, sheet.files[bad_sector->file].filename, bad_sector->sector,
+						bad_sector->sector / (75 * 60), bad_sector->sector / 75 % 60, bad_sector->sector % 75);
+				}
+
+				printf("Verified %lu data sectors (%.1f MB) with %u thread(s) in %.3f seconds (%.1f MB/s): %lu bad.\n",
+					total_sectors, total_sectors * (double)CLOWNCD_SECTOR_RAW_SIZE / 1000000.0, threads_started == 0 ? 1 : threads_started,
+					seconds, seconds == 0.0 ? 0.0 : total_sectors * (double)CLOWNCD_SECTOR_RAW_SIZE / 1000000.0 / seconds, (unsigned long)state.total_bad_sectors);
+
+				if (!state.failed && state.total_bad_sectors == 0)
+					exit_code = EXIT_SUCCESS;
+			}
+
+			free(state.bad_sectors);
+			free(ranges);
+			free(threads);
+		}
+
+		ClownCD_CueSheetFree(&sheet);
+
+		if (ClownCD_FileIsOpen(&cue_file))
+			ClownCD_FileClose(&cue_file);
+	}
+
+	return exit_code;
+}
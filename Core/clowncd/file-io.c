@@ -1,8 +1,29 @@
+#if !defined(CLOWNCD_NO_MMAP) && (defined(__unix__) || defined(__APPLE__))
+#define CLOWNCD_MMAP
+/* 'posix_madvise' is hidden when compiling as strict ISO C. */
+#if !defined(_POSIX_C_SOURCE) && !defined(__APPLE__)
+#define _POSIX_C_SOURCE 200112L
+#endif
+#endif
+
 #include "clowncd/file-io.h"
 
 #include <assert.h>
 
+#include <limits.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef CLOWNCD_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* How far ahead of the read position the OS is asked to page in a mapped file. 256KiB is a little over 100 sectors. */
+#define CLOWNCD_MAPPED_READ_AHEAD 0x40000
 
 static void* ClownCD_FileOpenStandard(const char* const filename, const ClownCD_FileMode mode)
 {
@@ -70,6 +91,224 @@ static int ClownCD_FileSeekStandard(void* const stream, const long position, con
 	return fseek((FILE*)stream, position, standard_origin);
 }
 
+typedef struct ClownCD_MappedFile
+{
+	FILE *fallback; /* Used instead of the mapping when the file could not be mapped. */
+	const unsigned char *data;
+	size_t size, position;
+	size_t page_size, advised_start, advised_end;
+} ClownCD_MappedFile;
+
+static void ClownCD_MappedFileAdvise(ClownCD_MappedFile* const file)
+{
+#ifdef CLOWNCD_MMAP
+	/* Keep the pages ahead of the read position coming in, topping them up once half of them have been consumed,
+	   or starting afresh if the position has jumped somewhere else. */
+	if (file->position < file->size && (file->position < file->advised_start || file->position + CLOWNCD_MAPPED_READ_AHEAD / 2 >= file->advised_end))
+	{
+		const size_t start = file->position - file->position % file->page_size;
+		const size_t bytes_remaining = file->size - start;
+		const size_t length = CC_MIN(bytes_remaining, CLOWNCD_MAPPED_READ_AHEAD);
+
+		posix_madvise((void*)(file->data + start), length, POSIX_MADV_WILLNEED);
+		file->advised_start = start;
+		file->advised_end = start + length;
+	}
+#else
+	(void)file;
+#endif
+}
+
+static cc_bool ClownCD_MappedFileMap(ClownCD_MappedFile* const file, const char* const filename)
+{
+#ifdef CLOWNCD_MMAP
+	cc_bool success = cc_false;
+	const int descriptor = open(filename, O_RDONLY);
+
+	if (descriptor != -1)
+	{
+		struct stat status;
+
+		/* Empty files cannot be mapped, so leave them to stdio. */
+		if (fstat(descriptor, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0 && (off_t)(size_t)status.st_size == status.st_size)
+		{
+			void* const data = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+			if (data != MAP_FAILED)
+			{
+				const long page_size = sysconf(_SC_PAGESIZE);
+
+				file->data = (const unsigned char*)data;
+				file->size = (size_t)status.st_size;
+				file->page_size = page_size > 0 ? (size_t)page_size : 0x1000;
+
+				/* Discs are mostly streamed from start to finish, so let the OS read ahead aggressively. */
+				posix_madvise(data, file->size, POSIX_MADV_SEQUENTIAL);
+				ClownCD_MappedFileAdvise(file);
+
+				success = cc_true;
+			}
+		}
+
+		/* The mapping outlives the descriptor. */
+		close(descriptor);
+	}
+
+	return success;
+#else
+	(void)file;
+	(void)filename;
+	return cc_false;
+#endif
+}
+
+static void* ClownCD_FileOpenMapped(const char* const filename, const ClownCD_FileMode mode)
+{
+	ClownCD_MappedFile* const file = (ClownCD_MappedFile*)malloc(sizeof(ClownCD_MappedFile));
+
+	if (file == NULL)
+		return NULL;
+
+	file->fallback = NULL;
+	file->data = NULL;
+	file->size = 0;
+	file->position = 0;
+	file->page_size = 0;
+	file->advised_start = 0;
+	file->advised_end = 0;
+
+	if (mode != CLOWNCD_RB || !ClownCD_MappedFileMap(file, filename))
+	{
+		file->fallback = (FILE*)ClownCD_FileOpenStandard(filename, mode);
+
+		if (file->fallback == NULL)
+		{
+			free(file);
+			return NULL;
+		}
+	}
+
+	return file;
+}
+
+static int ClownCD_FileCloseMapped(void* const stream)
+{
+	ClownCD_MappedFile* const file = (ClownCD_MappedFile*)stream;
+	int result = 0;
+
+	if (file->fallback != NULL)
+		result = ClownCD_FileCloseStandard(file->fallback);
+#ifdef CLOWNCD_MMAP
+	else
+		result = munmap((void*)file->data, file->size);
+#endif
+
+	free(file);
+	return result;
+}
+
+static size_t ClownCD_FileReadMapped(void* const buffer, const size_t size, const size_t count, void* const stream)
+{
+	ClownCD_MappedFile* const file = (ClownCD_MappedFile*)stream;
+
+	if (file->fallback != NULL)
+	{
+		return ClownCD_FileReadStandard(buffer, size, count, file->fallback);
+	}
+	else if (size == 0 || file->position >= file->size)
+	{
+		return 0;
+	}
+	else
+	{
+		/* Like 'fread', a partial element is still copied and consumed. */
+		const size_t bytes_available = file->size - file->position;
+		const size_t bytes_wanted = size * count;
+		const size_t bytes_done = CC_MIN(bytes_wanted, bytes_available);
+
+		memcpy(buffer, file->data + file->position, bytes_done);
+		file->position += bytes_done;
+
+		ClownCD_MappedFileAdvise(file);
+
+		return bytes_done / size;
+	}
+}
+
+static size_t ClownCD_FileWriteMapped(const void* const buffer, const size_t size, const size_t count, void* const stream)
+{
+	ClownCD_MappedFile* const file = (ClownCD_MappedFile*)stream;
+
+	/* Mappings are read-only. */
+	if (file->fallback == NULL)
+		return 0;
+
+	return ClownCD_FileWriteStandard(buffer, size, count, file->fallback);
+}
+
+static long ClownCD_FileTellMapped(void* const stream)
+{
+	ClownCD_MappedFile* const file = (ClownCD_MappedFile*)stream;
+
+	if (file->fallback != NULL)
+		return ClownCD_FileTellStandard(file->fallback);
+	else if (file->position > LONG_MAX)
+		return -1L;
+	else
+		return (long)file->position;
+}
+
+static int ClownCD_FileSeekMapped(void* const stream, const long position, const ClownCD_FileOrigin origin)
+{
+	ClownCD_MappedFile* const file = (ClownCD_MappedFile*)stream;
+	size_t base;
+
+	if (file->fallback != NULL)
+		return ClownCD_FileSeekStandard(file->fallback, position, origin);
+
+	switch (origin)
+	{
+		case CLOWNCD_SEEK_SET:
+			base = 0;
+			break;
+
+		case CLOWNCD_SEEK_CUR:
+			base = file->position;
+			break;
+
+		case CLOWNCD_SEEK_END:
+			base = file->size;
+			break;
+
+		default:
+			return 1;
+	}
+
+	/* As with 'fseek', seeking past the end is allowed, but seeking before the start is not. */
+	if (position < 0 && (unsigned long)-(position + 1) >= base)
+		return 1;
+
+	file->position = position < 0 ? base - (size_t)-(position + 1) - 1 : base + (size_t)position;
+
+	ClownCD_MappedFileAdvise(file);
+
+	return 0;
+}
+
+const ClownCD_FileCallbacks* ClownCD_GetMappedFileCallbacks(void)
+{
+	static const ClownCD_FileCallbacks mapped_callbacks = {
+		ClownCD_FileOpenMapped,
+		ClownCD_FileCloseMapped,
+		ClownCD_FileReadMapped,
+		ClownCD_FileWriteMapped,
+		ClownCD_FileTellMapped,
+		ClownCD_FileSeekMapped
+	};
+
+	return &mapped_callbacks;
+}
+
 ClownCD_File ClownCD_FileOpenBlank(void)
 {
 	ClownCD_File file;
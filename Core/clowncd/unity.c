@@ -1,8 +1,10 @@
+/* This must come first, as it defines '_POSIX_C_SOURCE', which has to be seen before any system header. */
+#include "clowncd/file-io.c"
 #include "clowncd/audio.c"
 #include "clowncd/clowncd.c"
+#include "clowncd/compressed.c"
 #include "clowncd/cue.c"
 #include "clowncd/error.c"
-#include "clowncd/file-io.c"
 #include "clowncd/utilities.c"
 #include "clowncd/audio/flac.c"
 #include "clowncd/audio/mp3.c"
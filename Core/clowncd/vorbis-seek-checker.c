@@ -0,0 +1,164 @@
+/* Decodes an Ogg Vorbis file from start to end, and then checks that seeking lands on exactly the same samples.
+   Each check opens the file afresh, reads some frames, seeks, and then compares everything up to the end of the file.
+   From the root of the repository, build it with:
+
+   cc -std=c99 -O2 -ICore -ICore/include Core/clowncd/vorbis-seek-checker.c Core/clowncd/unity.c -pthread -lm -o vorbis-seek-checker */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "clowncd/audio/vorbis.h"
+#include "clowncd/file-io.h"
+
+typedef struct Check
+{
+	const char *description;
+	double frames_read_first; /* Fractions of the file's length. */
+	double seek_target;
+} Check;
+
+static const Check checks[] = {
+	/* Building the seek table must not lose the decoder's place in the file. */
+	{"a short forward seek right after opening", -1000, -1500},
+	{"a seek right after opening", 0, -1500},
+	{"a forward seek further than a page", -1000, 0.5},
+	{"a backward seek", 0.5, 0.25},
+	{"a backward seek to the start", 0.5, 0},
+	{"a seek to the current frame", 0.25, 0.25},
+	{"a seek to near the end", 0.1, 0.99}
+};
+
+static size_t ReadAll(ClownCD_Vorbis* const vorbis, short* const buffer, const size_t total_channels, const size_t maximum_frames)
+{
+	size_t frames_done = 0;
+
+	while (frames_done != maximum_frames)
+	{
+		const size_t frames_read = ClownCD_VorbisRead(vorbis, &buffer[frames_done * total_channels], CC_MIN(0x1000, maximum_frames - frames_done));
+
+		if (frames_read == 0)
+			break;
+
+		frames_done += frames_read;
+	}
+
+	return frames_done;
+}
+
+/* Negative positions are absolute frame numbers, so that the checks near the start do not depend on the file's length. */
+static size_t ToFrame(const double position, const size_t total_frames)
+{
+	return position < 0 ? CC_MIN((size_t)-position, total_frames) : (size_t)(position * total_frames);
+}
+
+int main(const int argc, char** const argv)
+{
+	int exit_code = EXIT_FAILURE;
+
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s input-filename\n", argv[0]);
+	}
+	else
+	{
+		const char* const filename = argv[1];
+		ClownCD_File file = ClownCD_FileOpen(filename, CLOWNCD_RB, NULL);
+		ClownCD_Vorbis vorbis;
+		ClownCD_AudioMetadata metadata;
+
+		if (!ClownCD_FileIsOpen(&file) || !ClownCD_VorbisOpen(&vorbis, &file, &metadata))
+		{
+			fputs("Could not open input file.\n", stderr);
+
+			if (ClownCD_FileIsOpen(&file))
+				ClownCD_FileClose(&file);
+		}
+		else
+		{
+			const size_t total_channels = metadata.total_channels;
+			size_t capacity = 0x100000, total_frames = 0;
+			short *reference = (short*)malloc(capacity * total_channels * sizeof(short));
+			short *output = NULL;
+
+			/* Decode the whole file the plain way, to compare against. */
+			while (reference != NULL)
+			{
+				short *new_reference;
+
+				total_frames += ReadAll(&vorbis, &reference[total_frames * total_channels], total_channels, capacity - total_frames);
+
+				if (total_frames != capacity)
+					break;
+
+				capacity *= 2;
+				new_reference = (short*)realloc(reference, capacity * total_channels * sizeof(short));
+
+				if (new_reference == NULL)
+					free(reference);
+
+				reference = new_reference;
+			}
+
+			ClownCD_VorbisClose(&vorbis);
+			ClownCD_FileClose(&file);
+
+			if (reference != NULL)
+				output = (short*)malloc(total_frames * total_channels * sizeof(short));
+
+			if (output == NULL)
+			{
+				fputs("Could not allocate memory.\n", stderr);
+			}
+			else
+			{
+				size_t failures = 0, i;
+
+				printf("Decoded %lu frames.\n", (unsigned long)total_frames);
+
+				for (i = 0; i < CC_COUNT_OF(checks); ++i)
+				{
+					const Check* const check = &checks[i];
+					const size_t frames_read_first = ToFrame(check->frames_read_first, total_frames);
+					const size_t seek_target = ToFrame(check->seek_target, total_frames);
+					const size_t frames_wanted = total_frames - seek_target;
+
+					cc_bool passed = cc_false;
+					size_t frames_got = 0;
+
+					file = ClownCD_FileOpen(filename, CLOWNCD_RB, NULL);
+
+					if (ClownCD_FileIsOpen(&file) && ClownCD_VorbisOpen(&vorbis, &file, &metadata))
+					{
+						const cc_bool read_first = ReadAll(&vorbis, output, total_channels, frames_read_first) == frames_read_first;
+
+						if (read_first && ClownCD_VorbisSeek(&vorbis, seek_target))
+						{
+							frames_got = ReadAll(&vorbis, output, total_channels, total_frames);
+							passed = frames_got == frames_wanted && memcmp(output, &reference[seek_target * total_channels], frames_wanted * total_channels * sizeof(short)) == 0;
+						}
+
+						ClownCD_VorbisClose(&vorbis);
+					}
+
+					if (ClownCD_FileIsOpen(&file))
+						ClownCD_FileClose(&file);
+
+					printf("%s: %s (read %lu, seek to %lu, got %lu of %lu frames).\n", passed ? "Passed" : "FAILED", check->description,
+						(unsigned long)frames_read_first, (unsigned long)seek_target, (unsigned long)frames_got, (unsigned long)frames_wanted);
+
+					if (!passed)
+						++failures;
+				}
+
+				if (failures == 0)
+					exit_code = EXIT_SUCCESS;
+			}
+
+			free(output);
+			free(reference);
+		}
+	}
+
+	return exit_code;
+}
@@ -53,41 +53,62 @@ cc_bool CDReader_SeekToSector(CDReader_State* const state, const CDReader_Sector
 	return ClownCD_SeekSector(&state->clowncd, sector_index);
 }
 
-static size_t AttemptReadSector(CDReader_State* const state, cc_u16l* const buffer)
+static void BytesToBigEndianWords(cc_u16l* const words, const unsigned char* const bytes, const size_t total_words)
 {
-	cc_u16f i;
+	size_t i;
 
-	if (!ClownCD_BeginSectorStream(&state->clowncd))
-		return 0;
+	/* This is kept simple so that the compiler can turn it into a vectorised byte-swap. */
+	for (i = 0; i < total_words; ++i)
+		words[i] = (cc_u16l)bytes[i * 2 + 0] << 8 | bytes[i * 2 + 1];
+}
 
-	for (i = 0; i < CDREADER_SECTOR_SIZE / 2; ++i)
+static size_t AttemptReadSectors(CDReader_State* const state, cc_u16l* const buffer, const size_t total_sectors)
+{
+	size_t sectors_done = 0;
+	size_t words_read = 0;
+
+	while (sectors_done != total_sectors)
 	{
-		unsigned char bytes[2];
+		/* Sectors are read in batches, to keep the stack usage reasonable. */
+		unsigned char bytes[CDREADER_SECTOR_SIZE * 4 + 1];
+		const size_t sectors_remaining = total_sectors - sectors_done;
+		const size_t sectors_to_read = CC_MIN(sectors_remaining, CC_COUNT_OF(bytes) / CDREADER_SECTOR_SIZE);
+		const size_t bytes_read = ClownCD_ReadSectors(&state->clowncd, bytes, sectors_to_read);
+		const size_t batch_words_read = CC_DIVIDE_CEILING(bytes_read, 2);
 
 		/* Sanely handle a partial read. */
-		bytes[1] = 0;
+		bytes[bytes_read] = 0;
 
-		if (ClownCD_ReadSectorStream(&state->clowncd, bytes, CC_COUNT_OF(bytes)) == 0)
-			break;
+		BytesToBigEndianWords(&buffer[words_read], bytes, batch_words_read);
 
-		buffer[i] = (cc_u16l)bytes[0] << 8 | bytes[1];
-	}
+		words_read += batch_words_read;
+		sectors_done += sectors_to_read;
 
-	ClownCD_EndSectorStream(&state->clowncd);
+		if (bytes_read != sectors_to_read * CDREADER_SECTOR_SIZE)
+			break;
+	}
 
-	return i;
+	return words_read;
 }
 
 cc_bool CDReader_ReadSector(CDReader_State* const state, cc_u16l* const buffer)
 {
+	return CDReader_ReadSectors(state, buffer, 1) != 0;
+}
+
+cc_u32f CDReader_ReadSectors(CDReader_State* const state, cc_u16l* const buffer, const cc_u32f total_sectors)
+{
+	const size_t total_words = (size_t)total_sectors * (CDREADER_SECTOR_SIZE / 2);
+
 	size_t words_read = 0;
 
 	if (CDReader_IsOpen(state))
-		words_read = AttemptReadSector(state, buffer);
+		words_read = AttemptReadSectors(state, buffer, total_sectors);
 
-	memset(buffer + words_read, 0, (CDREADER_SECTOR_SIZE / 2 - words_read) * sizeof(cc_u16l));
+	memset(buffer + words_read, 0, (total_words - words_read) * sizeof(cc_u16l));
 
-	return words_read != 0;
+	/* A partially-read sector still counts, as it always has. */
+	return CC_DIVIDE_CEILING(words_read, CDREADER_SECTOR_SIZE / 2);
 }
 
 cc_bool CDReader_PlayAudio(CDReader_State* const state, const CDReader_TrackIndex track_index, const CDReader_PlaybackSetting setting)
@@ -0,0 +1,461 @@
+/* Runs a game twice, side by side: once with the SUB-CPU on the same thread as everything else,
+   and once with it on a thread of its own. The two must end every frame in exactly the same state.
+   'core/unity.c' leaves out two of the core's files, so from the root of the repository, build it with:
+
+   cc -std=c99 -O2 -ICore -ICore/include -ICore/include/core/clown68000/interpreter Core/common/lockstep-checker.c Core/common/unity.c Core/core/fm-lfo.c Core/core/low-pass-filter.c -pthread -lm -o lockstep-checker */
+
+/* For 'clock_gettime'. */
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "common/cd-reader.h"
+#include "core/clownmdemu.h"
+
+#define MAXIMUM_CARTRIDGE_SIZE 0x800000
+
+typedef struct Emulator
+{
+	ClownMDEmu_Configuration configuration;
+	ClownMDEmu_Constant constant;
+	ClownMDEmu_State state;
+	ClownMDEmu_MegaCDState mega_cd_state;
+	ClownMDEmu_Callbacks callbacks;
+	ClownMDEmu clownmdemu;
+
+	const unsigned char *cartridge;
+	size_t cartridge_size;
+	CDReader_State cd_reader;
+
+	/* Each emulator gets its own, so that neither can see the other's audio. */
+	cc_s16l sample_buffer[0x2000 * 2];
+
+	/* Everything below is only used when the SUB-CPU has a thread of its own. */
+	ClownMDEmu_SubCPUThread sub_cpu_thread;
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t condition;
+	void *job;
+	cc_bool busy, quitting;
+
+	double seconds;
+} Emulator;
+
+static void* SubCPUThreadLoop(void* const user_data)
+{
+	Emulator* const emulator = (Emulator*)user_data;
+
+	pthread_mutex_lock(&emulator->mutex);
+
+	for (;;)
+	{
+		while (!emulator->busy && !emulator->quitting)
+			pthread_cond_wait(&emulator->condition, &emulator->mutex);
+
+		if (!emulator->busy)
+			break;
+
+		pthread_mutex_unlock(&emulator->mutex);
+		ClownMDEmu_RunSubCPU(emulator->job);
+		pthread_mutex_lock(&emulator->mutex);
+
+		emulator->busy = cc_false;
+		pthread_cond_broadcast(&emulator->condition);
+	}
+
+	pthread_mutex_unlock(&emulator->mutex);
+
+	return NULL;
+}
+
+static void SubCPUReleased(void* const user_data, void* const job)
+{
+	Emulator* const emulator = (Emulator*)user_data;
+
+	pthread_mutex_lock(&emulator->mutex);
+	emulator->job = job;
+	emulator->busy = cc_true;
+	pthread_cond_broadcast(&emulator->condition);
+	pthread_mutex_unlock(&emulator->mutex);
+}
+
+static void SubCPUReclaimed(void* const user_data)
+{
+	Emulator* const emulator = (Emulator*)user_data;
+
+	pthread_mutex_lock(&emulator->mutex);
+	while (emulator->busy)
+		pthread_cond_wait(&emulator->condition, &emulator->mutex);
+	pthread_mutex_unlock(&emulator->mutex);
+}
+
+static cc_u8f CartridgeRead(void* const user_data, const cc_u32f address)
+{
+	const Emulator* const emulator = (const Emulator*)user_data;
+
+	return address < emulator->cartridge_size ? emulator->cartridge[address] : 0;
+}
+
+static void CartridgeWritten(void* const user_data, const cc_u32f address, const cc_u8f value)
+{
+	(void)user_data;
+	(void)address;
+	(void)value;
+}
+
+static void ColourUpdated(void* const user_data, const cc_u16f index, const cc_u16f colour)
+{
+	(void)user_data;
+	(void)index;
+	(void)colour;
+}
+
+static void ScanlineRendered(void* const user_data, const cc_u16f scanline, const cc_u8l* const pixels, const cc_u16f left_boundary, const cc_u16f right_boundary, const cc_u16f screen_width, const cc_u16f screen_height)
+{
+	(void)user_data;
+	(void)scanline;
+	(void)pixels;
+	(void)left_boundary;
+	(void)right_boundary;
+	(void)screen_width;
+	(void)screen_height;
+}
+
+static cc_bool InputRequested(void* const user_data, const cc_u8f player_id, const ClownMDEmu_Button button_id)
+{
+	(void)user_data;
+	(void)player_id;
+	(void)button_id;
+
+	return cc_false;
+}
+
+static void AudioToBeGenerated(void* const user_data, const ClownMDEmu* const clownmdemu, size_t total_frames, void (* const generate_audio)(const ClownMDEmu *clownmdemu, cc_s16l *sample_buffer, size_t total_frames))
+{
+	Emulator* const emulator = (Emulator*)user_data;
+
+	/* The audio is thrown away, but it still has to be generated, as that updates the state of the sound chips. */
+	while (total_frames != 0)
+	{
+		const size_t frames_to_do = CC_MIN(total_frames, CC_COUNT_OF(emulator->sample_buffer) / 2);
+
+		generate_audio(clownmdemu, emulator->sample_buffer, frames_to_do);
+		total_frames -= frames_to_do;
+	}
+}
+
+static void CDSeeked(void* const user_data, const cc_u32f sector_index)
+{
+	CDReader_SeekToSector(&((Emulator*)user_data)->cd_reader, sector_index);
+}
+
+static void CDSectorRead(void* const user_data, cc_u16l* const buffer)
+{
+	CDReader_ReadSector(&((Emulator*)user_data)->cd_reader, buffer);
+}
+
+static cc_bool CDTrackSeeked(void* const user_data, const cc_u16f track_index, const ClownMDEmu_CDDAMode mode)
+{
+	CDReader_PlaybackSetting playback_setting;
+
+	switch (mode)
+	{
+		default:
+			return cc_false;
+
+		case CLOWNMDEMU_CDDA_PLAY_ALL:
+			playback_setting = CDREADER_PLAYBACK_ALL;
+			break;
+
+		case CLOWNMDEMU_CDDA_PLAY_ONCE:
+			playback_setting = CDREADER_PLAYBACK_ONCE;
+			break;
+
+		case CLOWNMDEMU_CDDA_PLAY_REPEAT:
+			playback_setting = CDREADER_PLAYBACK_REPEAT;
+			break;
+	}
+
+	return CDReader_PlayAudio(&((Emulator*)user_data)->cd_reader, track_index, playback_setting);
+}
+
+static size_t CDAudioRead(void* const user_data, cc_s16l* const sample_buffer, const size_t total_frames)
+{
+	return CDReader_ReadAudio(&((Emulator*)user_data)->cd_reader, sample_buffer, total_frames);
+}
+
+/* Both emulators would be fighting over the same files, so neither of them gets any. */
+static cc_bool SaveFileOpened(void* const user_data, const char* const filename)
+{
+	(void)user_data;
+	(void)filename;
+
+	return cc_false;
+}
+
+static size_t SaveFileRead(void* const user_data, cc_u8l* const buffer, const size_t total_bytes)
+{
+	(void)user_data;
+	(void)buffer;
+	(void)total_bytes;
+
+	return 0;
+}
+
+static void SaveFileWritten(void* const user_data, const cc_u8l* const buffer, const size_t total_bytes)
+{
+	(void)user_data;
+	(void)buffer;
+	(void)total_bytes;
+}
+
+static void SaveFileClosed(void* const user_data)
+{
+	(void)user_data;
+}
+
+static cc_bool SaveFileSizeObtained(void* const user_data, const char* const filename, size_t* const size)
+{
+	(void)user_data;
+	(void)filename;
+	(void)size;
+
+	return cc_false;
+}
+
+static void LogCallback(void* const user_data, const char* const format, va_list arg)
+{
+	(void)user_data;
+	(void)format;
+	(void)arg;
+}
+
+static cc_bool EmulatorInitialise(Emulator* const emulator, const char* const filename, const unsigned char* const cartridge, const size_t cartridge_size, const cc_bool threaded)
+{
+	ClownMDEmu_Parameters_Initialise(&emulator->clownmdemu, &emulator->configuration, &emulator->constant, &emulator->state, &emulator->mega_cd_state, &emulator->callbacks);
+
+	emulator->callbacks.user_data = emulator;
+	emulator->callbacks.cartridge_read = CartridgeRead;
+	emulator->callbacks.cartridge_written = CartridgeWritten;
+	emulator->callbacks.colour_updated = ColourUpdated;
+	emulator->callbacks.scanline_rendered = ScanlineRendered;
+	emulator->callbacks.input_requested = InputRequested;
+	emulator->callbacks.fm_audio_to_be_generated = AudioToBeGenerated;
+	emulator->callbacks.psg_audio_to_be_generated = AudioToBeGenerated;
+	emulator->callbacks.pcm_audio_to_be_generated = AudioToBeGenerated;
+	emulator->callbacks.cdda_audio_to_be_generated = AudioToBeGenerated;
+	emulator->callbacks.cd_seeked = CDSeeked;
+	emulator->callbacks.cd_sector_read = CDSectorRead;
+	emulator->callbacks.cd_track_seeked = CDTrackSeeked;
+	emulator->callbacks.cd_audio_read = CDAudioRead;
+	emulator->callbacks.save_file_opened_for_reading = SaveFileOpened;
+	emulator->callbacks.save_file_read = SaveFileRead;
+	emulator->callbacks.save_file_opened_for_writing = SaveFileOpened;
+	emulator->callbacks.save_file_written = SaveFileWritten;
+	emulator->callbacks.save_file_closed = SaveFileClosed;
+	emulator->callbacks.save_file_removed = SaveFileOpened;
+	emulator->callbacks.save_file_size_obtained = SaveFileSizeObtained;
+
+	/* Each emulator reads the disc through its own handles, so that they cannot lose each other's place. */
+	CDReader_Initialise(&emulator->cd_reader);
+
+	if (cartridge == NULL)
+		CDReader_Open(&emulator->cd_reader, NULL, filename, NULL);
+
+	emulator->cartridge = cartridge;
+	emulator->cartridge_size = cartridge_size;
+
+	if (threaded)
+	{
+		emulator->sub_cpu_thread.user_data = emulator;
+		emulator->sub_cpu_thread.released = SubCPUReleased;
+		emulator->sub_cpu_thread.reclaimed = SubCPUReclaimed;
+		emulator->clownmdemu.sub_cpu_thread = &emulator->sub_cpu_thread;
+
+		pthread_mutex_init(&emulator->mutex, NULL);
+		pthread_cond_init(&emulator->condition, NULL);
+
+		if (pthread_create(&emulator->thread, NULL, SubCPUThreadLoop, emulator) != 0)
+		{
+			pthread_cond_destroy(&emulator->condition);
+			pthread_mutex_destroy(&emulator->mutex);
+			CDReader_Deinitialise(&emulator->cd_reader);
+			return cc_false;
+		}
+	}
+
+	ClownMDEmu_Constant_Initialise(&emulator->constant);
+	ClownMDEmu_State_Initialise(&emulator->state);
+	ClownMDEmu_MegaCDState_Initialise(&emulator->mega_cd_state);
+	ClownMDEmu_Reset(&emulator->clownmdemu, cartridge == NULL, cartridge_size);
+
+	return cc_true;
+}
+
+static void EmulatorDeinitialise(Emulator* const emulator)
+{
+	if (emulator->clownmdemu.sub_cpu_thread != NULL)
+	{
+		pthread_mutex_lock(&emulator->mutex);
+		emulator->quitting = cc_true;
+		pthread_cond_broadcast(&emulator->condition);
+		pthread_mutex_unlock(&emulator->mutex);
+
+		pthread_join(emulator->thread, NULL);
+		pthread_cond_destroy(&emulator->condition);
+		pthread_mutex_destroy(&emulator->mutex);
+	}
+
+	CDReader_Deinitialise(&emulator->cd_reader);
+}
+
+static double GetTime(void)
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1000000000.0;
+}
+
+static void EmulatorIterate(Emulator* const emulator)
+{
+	const double starting_time = GetTime();
+
+	ClownMDEmu_Iterate(&emulator->clownmdemu);
+
+	emulator->seconds += GetTime() - starting_time;
+}
+
+/* Returns the offset of the first byte that differs, or 'size' if none do. */
+static size_t CompareStates(const void* const state_a, const void* const state_b, const size_t size)
+{
+	const unsigned char* const bytes_a = (const unsigned char*)state_a;
+	const unsigned char* const bytes_b = (const unsigned char*)state_b;
+
+	size_t i;
+
+	if (memcmp(state_a, state_b, size) == 0)
+		return size;
+
+	for (i = 0; i < size; ++i)
+		if (bytes_a[i] != bytes_b[i])
+			break;
+
+	return i;
+}
+
+static unsigned char* LoadCartridge(const char* const filename, size_t* const cartridge_size)
+{
+	FILE* const file = fopen(filename, "rb");
+	unsigned char *cartridge = NULL;
+
+	if (file != NULL)
+	{
+		cartridge = (unsigned char*)malloc(MAXIMUM_CARTRIDGE_SIZE);
+
+		if (cartridge != NULL)
+			*cartridge_size = fread(cartridge, 1, MAXIMUM_CARTRIDGE_SIZE, file);
+
+		fclose(file);
+	}
+
+	return cartridge;
+}
+
+int main(const int argc, char** const argv)
+{
+	int exit_code = EXIT_FAILURE;
+
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s input-filename [frames]\n", argv[0]);
+	}
+	else
+	{
+		const char* const filename = argv[1];
+		const unsigned long total_frames = argc >= 3 ? strtoul(argv[2], NULL, 0) : 60 * 60;
+
+		Emulator* const emulators = (Emulator*)calloc(2, sizeof(Emulator));
+		CDReader_State cd_reader;
+		cc_bool is_disc;
+		unsigned char *cartridge = NULL;
+		size_t cartridge_size = 0;
+
+		/* Anything that is not a Mega CD disc is assumed to be a cartridge. */
+		CDReader_Initialise(&cd_reader);
+		CDReader_Open(&cd_reader, NULL, filename, NULL);
+		is_disc = CDReader_IsMegaCDGame(&cd_reader);
+		CDReader_Deinitialise(&cd_reader);
+
+		ClownMDEmu_SetLogCallback(LogCallback, NULL);
+
+		if (!is_disc)
+			cartridge = LoadCartridge(filename, &cartridge_size);
+
+		if (emulators == NULL)
+		{
+			fputs("Could not allocate memory.\n", stderr);
+		}
+		else if (!is_disc && cartridge == NULL)
+		{
+			fputs("Could not open input file.\n", stderr);
+		}
+		else if (!EmulatorInitialise(&emulators[0], filename, cartridge, cartridge_size, cc_false))
+		{
+			fputs("Could not initialise emulator.\n", stderr);
+		}
+		else
+		{
+			if (!EmulatorInitialise(&emulators[1], filename, cartridge, cartridge_size, cc_true))
+			{
+				fputs("Could not start SUB-CPU thread.\n", stderr);
+			}
+			else
+			{
+				unsigned long frame;
+				size_t mismatch = sizeof(ClownMDEmu_State);
+				size_t mega_cd_mismatch = sizeof(ClownMDEmu_MegaCDState);
+
+				for (frame = 0; frame < total_frames; ++frame)
+				{
+					EmulatorIterate(&emulators[0]);
+					EmulatorIterate(&emulators[1]);
+
+					mismatch = CompareStates(&emulators[0].state, &emulators[1].state, sizeof(ClownMDEmu_State));
+					mega_cd_mismatch = CompareStates(&emulators[0].mega_cd_state, &emulators[1].mega_cd_state, sizeof(ClownMDEmu_MegaCDState));
+
+					if (mismatch != sizeof(ClownMDEmu_State) || mega_cd_mismatch != sizeof(ClownMDEmu_MegaCDState))
+						break;
+				}
+
+				if (mismatch != sizeof(ClownMDEmu_State))
+				{
+					printf("Mismatch after frame %lu, at state offset 0x%lX.\n", frame, (unsigned long)mismatch);
+				}
+				else if (mega_cd_mismatch != sizeof(ClownMDEmu_MegaCDState))
+				{
+					printf("Mismatch after frame %lu, at Mega CD state offset 0x%lX.\n", frame, (unsigned long)mega_cd_mismatch);
+				}
+				else
+				{
+					printf("Matched for %lu frames. Single-threaded: %.3f seconds. Threaded: %.3f seconds.\n", total_frames, emulators[0].seconds, emulators[1].seconds);
+					exit_code = EXIT_SUCCESS;
+				}
+
+				EmulatorDeinitialise(&emulators[1]);
+			}
+
+			EmulatorDeinitialise(&emulators[0]);
+		}
+
+		free(cartridge);
+		free(emulators);
+	}
+
+	return exit_code;
+}
@@ -1,4 +1,5 @@
-#include "common/cd-reader.c"
+/* This must come first, for the same reason as 'clowncd/file-io.c' does in there. */
 #include "clowncd/unity.c"
+#include "common/cd-reader.c"
 #include "core/unity.c"
 #include "clowncd/audio/libraries/clownresampler/clownresampler.c"
@@ -4,6 +4,7 @@
 
 #include "core/cdda.h"
 #include "core/fm.h"
+#include "core/log.h"
 #include "core/low-pass-filter.h"
 #include "core/pcm.h"
 #include "core/psg.h"
@@ -103,7 +104,16 @@ void SyncCPUCommon(const ClownMDEmu* const clownmdemu, SyncCPUState* const sync,
 			countdown -= cycles_to_do;
 
 			if (countdown == 0)
+			{
 				countdown = callback(clownmdemu, (void*)user_data);
+
+				/* The callback has nothing more to do. */
+				if (countdown == 0)
+				{
+					sync->current_cycle = target_cycle;
+					break;
+				}
+			}
 		}
 
 		/* Store this back in memory for later. */
@@ -157,11 +167,57 @@ void SyncPSG(CPUCallbackUserData* const other_state, const CycleMegaDrive target
 {
 	const cc_u32f frames_to_generate = SyncCommon(&other_state->sync.psg, target_cycle.cycle, CLOWNMDEMU_Z80_CLOCK_DIVIDER * CLOWNMDEMU_PSG_SAMPLE_RATE_DIVIDER);
 
+	/* When the writes are being logged, the audio is generated later from the log instead. */
 	/* TODO: Is this check necessary? */
-	if (frames_to_generate != 0)
+	if (frames_to_generate != 0 && other_state->clownmdemu->psg_log == NULL)
 		other_state->clownmdemu->callbacks->psg_audio_to_be_generated((void*)other_state->clownmdemu->callbacks->user_data, other_state->clownmdemu, frames_to_generate, GeneratePSGAudio);
 }
 
+void WritePSG(CPUCallbackUserData* const other_state, const CycleMegaDrive target_cycle, const cc_u8f command)
+{
+	ClownMDEmu_PSGLog* const log = other_state->clownmdemu->psg_log;
+
+	SyncPSG(other_state, target_cycle);
+
+	if (log == NULL)
+	{
+		PSG_DoCommand(&other_state->clownmdemu->psg, command);
+	}
+	else if (log->total_writes == CC_COUNT_OF(log->writes))
+	{
+		LogMessage("PSG log is full; write of 0x%" CC_PRIXFAST8 " was dropped", command);
+	}
+	else
+	{
+		ClownMDEmu_PSGLog_Write* const logged_write = &log->writes[log->total_writes++];
+
+		/* SyncPSG has just brought the PSG's cycle counter (which is in PSG frames) up to this write. */
+		logged_write->frame = other_state->sync.psg.current_cycle;
+		logged_write->command = command;
+	}
+}
+
+void GeneratePSGAudioFromLog(const ClownMDEmu* const clownmdemu, const ClownMDEmu_PSGLog* const log)
+{
+	size_t current_frame = 0;
+	size_t i;
+
+	/* Generate the audio in between each write, just as SyncPSG would have. */
+	/* The PSG and its low-pass filter carry their state between calls, so this matches regardless of how the frame is divided. */
+	for (i = 0; i <= log->total_writes; ++i)
+	{
+		const size_t target_frame = i == log->total_writes ? log->total_frames : log->writes[i].frame;
+
+		if (target_frame != current_frame)
+			clownmdemu->callbacks->psg_audio_to_be_generated((void*)clownmdemu->callbacks->user_data, clownmdemu, target_frame - current_frame, GeneratePSGAudio);
+
+		current_frame = target_frame;
+
+		if (i != log->total_writes)
+			PSG_DoCommand(&clownmdemu->psg, log->writes[i].command);
+	}
+}
+
 static void GeneratePCMAudio(const ClownMDEmu* const clownmdemu, cc_s16l* const sample_buffer, const size_t total_frames)
 {
 	PCM_Update(&clownmdemu->pcm, sample_buffer, total_frames);
@@ -182,7 +238,7 @@ void SyncPCM(CPUCallbackUserData* const other_state, const CycleMegaCD target_cy
 
 static void GenerateCDDAAudio(const ClownMDEmu* const clownmdemu, cc_s16l* const sample_buffer, const size_t total_frames)
 {
-	CDDA_Update(&clownmdemu->state->mega_cd.cdda, clownmdemu->callbacks->cd_audio_read, clownmdemu->callbacks->user_data, sample_buffer, total_frames);
+	CDDA_Update(&clownmdemu->mega_cd_state->cdda, clownmdemu->callbacks->cd_audio_read, clownmdemu->callbacks->user_data, sample_buffer, total_frames);
 }
 
 void SyncCDDA(CPUCallbackUserData* const other_state, const cc_u32f total_frames)
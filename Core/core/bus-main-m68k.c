@@ -173,7 +173,7 @@ cc_u16f M68kReadCallbackWithCycleWithDMA(const void* const user_data, const cc_u
 		case 0x400000 / 0x200000:
 		case 0x600000 / 0x200000:
 			/* Cartridge, Mega CD. */
-			if (((address & 0x400000) == 0) != clownmdemu->state->mega_cd.boot_from_cd)
+			if (((address & 0x400000) == 0) != clownmdemu->state->boot_from_cd)
 			{
 				if ((address & 0x200000) != 0 && clownmdemu->state->external_ram.mapped_in)
 				{
@@ -203,12 +203,19 @@ cc_u16f M68kReadCallbackWithCycleWithDMA(const void* const user_data, const cc_u
 						value |= frontend_callbacks->cartridge_read((void*)frontend_callbacks->user_data, cartridge_address + 1) << 0;
 				}
 			}
+			else if (!MEGA_CD_ATTACHED(clownmdemu))
+			{
+				LOG_MAIN_CPU_BUS_ERROR_1("Attempted to read invalid 68k address 0x%" CC_PRIXFAST32, address);
+			}
 			else
 			{
 				if ((address & 0x200000) != 0)
 				{
 					/* WORD-RAM */
-					if (clownmdemu->state->mega_cd.word_ram.in_1m_mode)
+					/* The SUB-CPU can give WORD-RAM away, or split it in two, at any moment. */
+					SyncMCDM68k(clownmdemu, callback_user_data, CycleMegaDriveToMegaCD(clownmdemu, target_cycle));
+
+					if (clownmdemu->mega_cd_state->word_ram.in_1m_mode)
 					{
 						if ((address & 0x20000) != 0)
 						{
@@ -217,18 +224,18 @@ cc_u16f M68kReadCallbackWithCycleWithDMA(const void* const user_data, const cc_u
 						}
 						else
 						{
-							value = clownmdemu->state->mega_cd.word_ram.buffer[(address_word & 0xFFFF) * 2 + clownmdemu->state->mega_cd.word_ram.ret];
+							value = clownmdemu->mega_cd_state->word_ram.buffer[(address_word & 0xFFFF) * 2 + clownmdemu->mega_cd_state->word_ram.ret];
 						}
 					}
 					else
 					{
-						if (clownmdemu->state->mega_cd.word_ram.dmna)
+						if (clownmdemu->mega_cd_state->word_ram.dmna)
 						{
 							LOG_MAIN_CPU_BUS_ERROR_0("MAIN-CPU attempted to read from WORD-RAM while SUB-CPU has it");
 						}
 						else
 						{
-							value = clownmdemu->state->mega_cd.word_ram.buffer[address_word & 0x1FFFF];
+							value = clownmdemu->mega_cd_state->word_ram.buffer[address_word & 0x1FFFF];
 						}
 					}
 
@@ -238,8 +245,8 @@ cc_u16f M68kReadCallbackWithCycleWithDMA(const void* const user_data, const cc_u
 						/* This can easily be seen in Sonic CD's FMVs. */
 						const cc_u16f delayed_value = value;
 
-						value = clownmdemu->state->mega_cd.delayed_dma_word;
-						clownmdemu->state->mega_cd.delayed_dma_word = delayed_value;
+						value = clownmdemu->mega_cd_state->delayed_dma_word;
+						clownmdemu->mega_cd_state->delayed_dma_word = delayed_value;
 					}
 				}
 				else if ((address & 0x20000) == 0)
@@ -249,7 +256,7 @@ cc_u16f M68kReadCallbackWithCycleWithDMA(const void* const user_data, const cc_u
 					{
 						/* The Mega CD has this strange hack in its bug logic, which allows
 						   the H-Int interrupt address to be overridden with a register. */
-						value = clownmdemu->state->mega_cd.hblank_address;
+						value = clownmdemu->mega_cd_state->hblank_address;
 					}
 					else
 					{
@@ -259,13 +266,13 @@ cc_u16f M68kReadCallbackWithCycleWithDMA(const void* const user_data, const cc_u
 				else
 				{
 					/* PRG-RAM */
-					if (!clownmdemu->state->mega_cd.m68k.bus_requested)
+					if (!clownmdemu->mega_cd_state->m68k.bus_requested)
 					{
 						LOG_MAIN_CPU_BUS_ERROR_0("Attempted to read from PRG-RAM while SUB-CPU has it");
 					}
 					else
 					{
-						value = clownmdemu->state->mega_cd.prg_ram.buffer[0x10000 * clownmdemu->state->mega_cd.prg_ram.bank + (address_word & 0xFFFF)];
+						value = clownmdemu->mega_cd_state->prg_ram.buffer[0x10000 * clownmdemu->mega_cd_state->prg_ram.bank + (address_word & 0xFFFF)];
 					}
 				}
 			}
@@ -317,7 +324,7 @@ cc_u16f M68kReadCallbackWithCycleWithDMA(const void* const user_data, const cc_u
 				{
 					case 0xA10000:
 						if (do_low_byte)
-							value |= ((clownmdemu->configuration->general.region == CLOWNMDEMU_REGION_OVERSEAS) << 7) | ((clownmdemu->configuration->general.tv_standard == CLOWNMDEMU_TV_STANDARD_PAL) << 6) | (0 << 5);	/* Bit 5 clear = Mega CD attached */
+							value |= ((clownmdemu->configuration->general.region == CLOWNMDEMU_REGION_OVERSEAS) << 7) | ((clownmdemu->configuration->general.tv_standard == CLOWNMDEMU_TV_STANDARD_PAL) << 6) | (!MEGA_CD_ATTACHED(clownmdemu) << 5);	/* Bit 5 clear = Mega CD attached */
 
 						break;
 
@@ -384,32 +391,41 @@ cc_u16f M68kReadCallbackWithCycleWithDMA(const void* const user_data, const cc_u
 				value = 0xFF ^ clownmdemu->state->z80.reset_held;
 				value = value << 8 | value;
 			}
+			else if (!MEGA_CD_ATTACHED(clownmdemu) && address >= 0xA12000 && address < 0xA12040)
+			{
+				/* Without a Mega CD, there is nothing here. */
+				LOG_MAIN_CPU_BUS_ERROR_1("Attempted to read invalid 68k address 0x%" CC_PRIXFAST32, address);
+			}
 			else if (address == 0xA12000)
 			{
 				/* RESET, HALT */
-				value = ((cc_u16f)clownmdemu->state->mega_cd.irq.enabled[1] << 15) |
-					((cc_u16f)clownmdemu->state->mega_cd.m68k.bus_requested << 1) |
-					((cc_u16f)!clownmdemu->state->mega_cd.m68k.reset_held << 0);
+				SyncMCDM68k(clownmdemu, callback_user_data, CycleMegaDriveToMegaCD(clownmdemu, target_cycle));
+				value = ((cc_u16f)clownmdemu->mega_cd_state->irq.enabled[1] << 15) |
+					((cc_u16f)clownmdemu->mega_cd_state->m68k.bus_requested << 1) |
+					((cc_u16f)!clownmdemu->mega_cd_state->m68k.reset_held << 0);
 			}
 			else if (address == 0xA12002)
 			{
 				/* Memory mode / Write protect */
-				value = ((cc_u16f)clownmdemu->state->mega_cd.prg_ram.write_protect << 8) | ((cc_u16f)clownmdemu->state->mega_cd.prg_ram.bank << 6) | ((cc_u16f)clownmdemu->state->mega_cd.word_ram.in_1m_mode << 2) | ((cc_u16f)clownmdemu->state->mega_cd.word_ram.dmna << 1) | ((cc_u16f)clownmdemu->state->mega_cd.word_ram.ret << 0);
+				SyncMCDM68k(clownmdemu, callback_user_data, CycleMegaDriveToMegaCD(clownmdemu, target_cycle));
+				value = ((cc_u16f)clownmdemu->mega_cd_state->prg_ram.write_protect << 8) | ((cc_u16f)clownmdemu->mega_cd_state->prg_ram.bank << 6) | ((cc_u16f)clownmdemu->mega_cd_state->word_ram.in_1m_mode << 2) | ((cc_u16f)clownmdemu->mega_cd_state->word_ram.dmna << 1) | ((cc_u16f)clownmdemu->mega_cd_state->word_ram.ret << 0);
 			}
 			else if (address == 0xA12004)
 			{
 				/* CDC mode */
-				value = CDC_Mode(&clownmdemu->state->mega_cd.cdc, cc_false);
+				SyncMCDM68k(clownmdemu, callback_user_data, CycleMegaDriveToMegaCD(clownmdemu, target_cycle));
+				value = CDC_Mode(&clownmdemu->mega_cd_state->cdc, cc_false);
 			}
 			else if (address == 0xA12006)
 			{
 				/* H-INT vector */
-				value = clownmdemu->state->mega_cd.hblank_address;
+				value = clownmdemu->mega_cd_state->hblank_address;
 			}
 			else if (address == 0xA12008)
 			{
 				/* CDC host data */
-				value = CDC_HostData(&clownmdemu->state->mega_cd.cdc, cc_false);
+				SyncMCDM68k(clownmdemu, callback_user_data, CycleMegaDriveToMegaCD(clownmdemu, target_cycle));
+				value = CDC_HostData(&clownmdemu->mega_cd_state->cdc, cc_false);
 			}
 			else if (address == 0xA1200C)
 			{
@@ -420,19 +436,19 @@ cc_u16f M68kReadCallbackWithCycleWithDMA(const void* const user_data, const cc_u
 			{
 				/* Communication flag */
 				SyncMCDM68k(clownmdemu, callback_user_data, CycleMegaDriveToMegaCD(clownmdemu, target_cycle));
-				value = clownmdemu->state->mega_cd.communication.flag;
+				value = clownmdemu->mega_cd_state->communication.flag;
 			}
 			else if (address >= 0xA12010 && address < 0xA12020)
 			{
 				/* Communication command */
 				SyncMCDM68k(clownmdemu, callback_user_data, CycleMegaDriveToMegaCD(clownmdemu, target_cycle));
-				value = clownmdemu->state->mega_cd.communication.command[(address - 0xA12010) / 2];
+				value = clownmdemu->mega_cd_state->communication.command[(address - 0xA12010) / 2];
 			}
 			else if (address >= 0xA12020 && address < 0xA12030)
 			{
 				/* Communication status */
 				SyncMCDM68k(clownmdemu, callback_user_data, CycleMegaDriveToMegaCD(clownmdemu, target_cycle));
-				value = clownmdemu->state->mega_cd.communication.status[(address - 0xA12020) / 2];
+				value = clownmdemu->mega_cd_state->communication.status[(address - 0xA12020) / 2];
 			}
 			else if (address == 0xA12030)
 			{
@@ -576,7 +592,7 @@ void M68kWriteCallbackWithCycle(const void* const user_data, const cc_u32f addre
 		case 0x400000 / 0x200000:
 		case 0x600000 / 0x200000:
 			/* Cartridge, Mega CD. */
-			if (((address & 0x400000) == 0) != clownmdemu->state->mega_cd.boot_from_cd)
+			if (((address & 0x400000) == 0) != clownmdemu->state->boot_from_cd)
 			{
 				if ((address & 0x200000) != 0 && clownmdemu->state->external_ram.mapped_in)
 				{
@@ -605,6 +621,10 @@ void M68kWriteCallbackWithCycle(const void* const user_data, const cc_u32f addre
 								clownmdemu->state->external_ram.buffer[index + 1] = low_byte;
 								break;
 						}
+
+						/* Remember what has been written, so that the frontend only has to save that. */
+						clownmdemu->state->external_ram.dirty_start = CC_MIN(clownmdemu->state->external_ram.dirty_start, index);
+						clownmdemu->state->external_ram.dirty_end = CC_MAX(clownmdemu->state->external_ram.dirty_end, index + 2);
 					}
 				}
 				else
@@ -619,12 +639,19 @@ void M68kWriteCallbackWithCycle(const void* const user_data, const cc_u32f addre
 					LOG_MAIN_CPU_BUS_ERROR_1("Attempted to write to ROM address 0x%" CC_PRIXFAST32, address);
 				}
 			}
+			else if (!MEGA_CD_ATTACHED(clownmdemu))
+			{
+				LOG_MAIN_CPU_BUS_ERROR_1("Attempted to write invalid 68k address 0x%" CC_PRIXFAST32, address);
+			}
 			else
 			{
 				if ((address & 0x200000) != 0)
 				{
 					/* WORD-RAM */
-					if (clownmdemu->state->mega_cd.word_ram.in_1m_mode)
+					/* The SUB-CPU can give WORD-RAM away, or split it in two, at any moment. */
+					SyncMCDM68k(clownmdemu, callback_user_data, CycleMegaDriveToMegaCD(clownmdemu, target_cycle));
+
+					if (clownmdemu->mega_cd_state->word_ram.in_1m_mode)
 					{
 						if ((address & 0x20000) != 0)
 						{
@@ -633,20 +660,20 @@ void M68kWriteCallbackWithCycle(const void* const user_data, const cc_u32f addre
 						}
 						else
 						{
-							clownmdemu->state->mega_cd.word_ram.buffer[(address_word & 0xFFFF) * 2 + clownmdemu->state->mega_cd.word_ram.ret] &= ~mask;
-							clownmdemu->state->mega_cd.word_ram.buffer[(address_word & 0xFFFF) * 2 + clownmdemu->state->mega_cd.word_ram.ret] |= value & mask;
+							clownmdemu->mega_cd_state->word_ram.buffer[(address_word & 0xFFFF) * 2 + clownmdemu->mega_cd_state->word_ram.ret] &= ~mask;
+							clownmdemu->mega_cd_state->word_ram.buffer[(address_word & 0xFFFF) * 2 + clownmdemu->mega_cd_state->word_ram.ret] |= value & mask;
 						}
 					}
 					else
 					{
-						if (clownmdemu->state->mega_cd.word_ram.dmna)
+						if (clownmdemu->mega_cd_state->word_ram.dmna)
 						{
 							LOG_MAIN_CPU_BUS_ERROR_0("Attempted to write to WORD-RAM while SUB-CPU has it");
 						}
 						else
 						{
-							clownmdemu->state->mega_cd.word_ram.buffer[address_word & 0x1FFFF] &= ~mask;
-							clownmdemu->state->mega_cd.word_ram.buffer[address_word & 0x1FFFF] |= value & mask;
+							clownmdemu->mega_cd_state->word_ram.buffer[address_word & 0x1FFFF] &= ~mask;
+							clownmdemu->mega_cd_state->word_ram.buffer[address_word & 0x1FFFF] |= value & mask;
 						}
 					}
 				}
@@ -658,20 +685,20 @@ void M68kWriteCallbackWithCycle(const void* const user_data, const cc_u32f addre
 				else
 				{
 					/* PRG-RAM */
-					const cc_u32f prg_ram_index = 0x10000 * clownmdemu->state->mega_cd.prg_ram.bank + (address_word & 0xFFFF);
+					const cc_u32f prg_ram_index = 0x10000 * clownmdemu->mega_cd_state->prg_ram.bank + (address_word & 0xFFFF);
 
-					if (!clownmdemu->state->mega_cd.m68k.bus_requested)
+					if (!clownmdemu->mega_cd_state->m68k.bus_requested)
 					{
 						LOG_MAIN_CPU_BUS_ERROR_0("Attempted to write to PRG-RAM while SUB-CPU has it");
 					}
-					else if (prg_ram_index < (cc_u32f)clownmdemu->state->mega_cd.prg_ram.write_protect * 0x200)
+					else if (prg_ram_index < (cc_u32f)clownmdemu->mega_cd_state->prg_ram.write_protect * 0x200)
 					{
 						LOG_MAIN_CPU_BUS_ERROR_1("Attempted to write to write-protected portion of PRG-RAM (0x%" CC_PRIXFAST32 ")", prg_ram_index);
 					}
 					else
 					{
-						clownmdemu->state->mega_cd.prg_ram.buffer[prg_ram_index] &= ~mask;
-						clownmdemu->state->mega_cd.prg_ram.buffer[prg_ram_index] |= value & mask;
+						clownmdemu->mega_cd_state->prg_ram.buffer[prg_ram_index] &= ~mask;
+						clownmdemu->mega_cd_state->prg_ram.buffer[prg_ram_index] |= value & mask;
 					}
 				}
 			}
@@ -788,6 +815,11 @@ void M68kWriteCallbackWithCycle(const void* const user_data, const cc_u32f addre
 					clownmdemu->state->z80.reset_held = new_reset_held;
 				}
 			}
+			else if (!MEGA_CD_ATTACHED(clownmdemu) && address >= 0xA12000 && address < 0xA12040)
+			{
+				/* Without a Mega CD, there is nothing here. */
+				LOG_MAIN_CPU_BUS_ERROR_1("Attempted to write invalid 68k address 0x%" CC_PRIXFAST32, address);
+			}
 			else if (address == 0xA12000)
 			{
 				/* RESET, HALT */
@@ -801,43 +833,37 @@ void M68kWriteCallbackWithCycle(const void* const user_data, const cc_u32f addre
 				m68k_read_write_callbacks.write_callback = MCDM68kWriteCallback;
 				m68k_read_write_callbacks.user_data = callback_user_data;
 
-				if (clownmdemu->state->mega_cd.m68k.bus_requested != bus_request)
-					SyncMCDM68k(clownmdemu, callback_user_data, CycleMegaDriveToMegaCD(clownmdemu, target_cycle));
+				/* The SUB-CPU looks at all of these, so it must be brought up to date before any of them change. */
+				SyncMCDM68k(clownmdemu, callback_user_data, CycleMegaDriveToMegaCD(clownmdemu, target_cycle));
 
-				if (clownmdemu->state->mega_cd.m68k.reset_held && !reset)
-				{
-					SyncMCDM68k(clownmdemu, callback_user_data, CycleMegaDriveToMegaCD(clownmdemu, target_cycle));
+				if (clownmdemu->mega_cd_state->m68k.reset_held && !reset)
 					Clown68000_Reset(clownmdemu->mcd_m68k, &m68k_read_write_callbacks);
-				}
 
-				if (interrupt && clownmdemu->state->mega_cd.irq.enabled[1])
-				{
-					SyncMCDM68k(clownmdemu, callback_user_data, CycleMegaDriveToMegaCD(clownmdemu, target_cycle));
+				if (interrupt && clownmdemu->mega_cd_state->irq.enabled[1])
 					Clown68000_Interrupt(clownmdemu->mcd_m68k, 2);
-				}
 
-				clownmdemu->state->mega_cd.m68k.bus_requested = bus_request;
-				clownmdemu->state->mega_cd.m68k.reset_held = reset;
+				clownmdemu->mega_cd_state->m68k.bus_requested = bus_request;
+				clownmdemu->mega_cd_state->m68k.reset_held = reset;
 			}
 			else if (address == 0xA12002)
 			{
 				/* Memory mode / Write protect */
+				SyncMCDM68k(clownmdemu, callback_user_data, CycleMegaDriveToMegaCD(clownmdemu, target_cycle));
+
 				if (do_high_byte)
-					clownmdemu->state->mega_cd.prg_ram.write_protect = high_byte;
+					clownmdemu->mega_cd_state->prg_ram.write_protect = high_byte;
 
 				if (do_low_byte)
 				{
 					if ((low_byte & (1 << 1)) != 0)
 					{
-						SyncMCDM68k(clownmdemu, callback_user_data, CycleMegaDriveToMegaCD(clownmdemu, target_cycle));
-
-						clownmdemu->state->mega_cd.word_ram.dmna = cc_true;
+						clownmdemu->mega_cd_state->word_ram.dmna = cc_true;
 
-						if (!clownmdemu->state->mega_cd.word_ram.in_1m_mode)
-							clownmdemu->state->mega_cd.word_ram.ret = cc_false;
+						if (!clownmdemu->mega_cd_state->word_ram.in_1m_mode)
+							clownmdemu->mega_cd_state->word_ram.ret = cc_false;
 					}
 
-					clownmdemu->state->mega_cd.prg_ram.bank = (low_byte >> 6) & 3;
+					clownmdemu->mega_cd_state->prg_ram.bank = (low_byte >> 6) & 3;
 				}
 			}
 			else if (address == 0xA12004)
@@ -848,8 +874,8 @@ void M68kWriteCallbackWithCycle(const void* const user_data, const cc_u32f addre
 			else if (address == 0xA12006)
 			{
 				/* H-INT vector */
-				clownmdemu->state->mega_cd.hblank_address &= ~mask;
-				clownmdemu->state->mega_cd.hblank_address |= value & mask;
+				clownmdemu->mega_cd_state->hblank_address &= ~mask;
+				clownmdemu->mega_cd_state->hblank_address |= value & mask;
 			}
 			else if (address == 0xA12008)
 			{
@@ -867,7 +893,7 @@ void M68kWriteCallbackWithCycle(const void* const user_data, const cc_u32f addre
 				if (do_high_byte)
 				{
 					SyncMCDM68k(clownmdemu, callback_user_data, CycleMegaDriveToMegaCD(clownmdemu, target_cycle));
-					clownmdemu->state->mega_cd.communication.flag = (clownmdemu->state->mega_cd.communication.flag & 0x00FF) | (value & 0xFF00);
+					clownmdemu->mega_cd_state->communication.flag = (clownmdemu->mega_cd_state->communication.flag & 0x00FF) | (value & 0xFF00);
 				}
 
 				if (do_low_byte)
@@ -877,8 +903,8 @@ void M68kWriteCallbackWithCycle(const void* const user_data, const cc_u32f addre
 			{
 				/* Communication command */
 				SyncMCDM68k(clownmdemu, callback_user_data, CycleMegaDriveToMegaCD(clownmdemu, target_cycle));
-				clownmdemu->state->mega_cd.communication.command[(address - 0xA12010) / 2] &= ~mask;
-				clownmdemu->state->mega_cd.communication.command[(address - 0xA12010) / 2] |= value & mask;
+				clownmdemu->mega_cd_state->communication.command[(address - 0xA12010) / 2] &= ~mask;
+				clownmdemu->mega_cd_state->communication.command[(address - 0xA12010) / 2] |= value & mask;
 			}
 			else if (address >= 0xA12020 && address < 0xA12030)
 			{
@@ -952,10 +978,9 @@ void M68kWriteCallbackWithCycle(const void* const user_data, const cc_u32f addre
 					if (do_low_byte)
 					{
 						SyncZ80(clownmdemu, callback_user_data, target_cycle);
-						SyncPSG(callback_user_data, target_cycle);
 
 						/* Alter the PSG's state */
-						PSG_DoCommand(&clownmdemu->psg, low_byte);
+						WritePSG(callback_user_data, target_cycle, low_byte);
 					}
 					break;
 
@@ -6,11 +6,14 @@
 #include "core/bus-sub-m68k.h"
 
 #include <assert.h>
+#include <string.h>
 
 #include "core/bus-main-m68k.h"
 #include "core/cdda.h"
 #include "core/log.h"
 
+static void SyncGraphics(CPUCallbackUserData *other_state, CycleMegaCD target_cycle);
+
 static cc_u16f MCDM68kReadByte(const void* const user_data, const cc_u32f address, const CycleMegaCD target_cycle)
 {
 	const cc_bool is_odd = (address & 1) != 0;
@@ -49,15 +52,113 @@ static void MCDM68kWriteWord(const void* const user_data, const cc_u32f address,
 
 static void ROMSEEK(const ClownMDEmu* const clownmdemu, const ClownMDEmu_Callbacks* const frontend_callbacks, const cc_u32f starting_sector, const cc_u32f total_sectors)
 {
-	CDC_Stop(&clownmdemu->state->mega_cd.cdc);
-	CDC_Seek(&clownmdemu->state->mega_cd.cdc, frontend_callbacks->cd_sector_read, frontend_callbacks->user_data, starting_sector, total_sectors);
+	CDC_Stop(&clownmdemu->mega_cd_state->cdc);
+	CDC_Seek(&clownmdemu->mega_cd_state->cdc, frontend_callbacks->cd_sector_read, frontend_callbacks->user_data, starting_sector, total_sectors);
 	frontend_callbacks->cd_seeked((void*)frontend_callbacks->user_data, starting_sector);
 }
 
 static void CDCSTART(const ClownMDEmu* const clownmdemu, const ClownMDEmu_Callbacks* const frontend_callbacks)
 {
-	CDDA_SetPlaying(&clownmdemu->state->mega_cd.cdda, cc_false);
-	CDC_Start(&clownmdemu->state->mega_cd.cdc, frontend_callbacks->cd_sector_read, frontend_callbacks->user_data);
+	CDDA_SetPlaying(&clownmdemu->mega_cd_state->cdda, cc_false);
+	CDC_Start(&clownmdemu->mega_cd_state->cdc, frontend_callbacks->cd_sector_read, frontend_callbacks->user_data);
+}
+
+/* Writes CDC data to its DMA destination. The part that lands in PRG-RAM, WORD-RAM, or PCM wave RAM is copied
+   directly, with the write-protection and WORD-RAM ownership checks done once for all of it.
+   Anything past the end of that memory goes through the address decoder a word at a time, as before. */
+static void CDCDMA(const ClownMDEmu* const clownmdemu, const void* const user_data, cc_u32f address, const cc_u16l* const words, const cc_u16f total_words, const CycleMegaCD target_cycle)
+{
+	const cc_bool to_pcm_ram = clownmdemu->mega_cd_state->cdc.device_destination == CDC_DESTINATION_PCM_RAM;
+	const cc_u32f masked_address = address & 0xFFFFFF;
+
+	cc_u16f words_done = 0;
+	cc_u16f i;
+
+	if (to_pcm_ram)
+	{
+		/* PCM wave RAM */
+		if (masked_address >= 0xFF2000 && masked_address < 0xFF4000)
+		{
+			/* Each word is written as two bytes, and each byte takes up a word of address space. */
+			words_done = CC_MIN(total_words, (0xFF4000 - masked_address) / 4);
+
+			SyncPCM((CPUCallbackUserData*)user_data, target_cycle);
+			PCM_WriteWaveRAMWords(&clownmdemu->pcm, (masked_address / 2) & 0xFFF, words, words_done);
+		}
+	}
+	else if (masked_address < 0x80000)
+	{
+		/* PRG-RAM */
+		const cc_u32f write_protect_end = (cc_u32f)clownmdemu->mega_cd_state->prg_ram.write_protect * 0x200;
+		cc_u16f protected_words = 0;
+
+		words_done = CC_MIN(total_words, (0x80000 - masked_address) / 2);
+
+		if (masked_address < write_protect_end)
+		{
+			protected_words = CC_MIN(words_done, (write_protect_end - masked_address + 1) / 2);
+			LogMessage("SUB-CPU attempted to DMA to write-protected portion of PRG-RAM (0x%" CC_PRIXFAST32 ") at 0x%" CC_PRIXLEAST32, masked_address, clownmdemu->mega_cd_state->m68k.state.program_counter);
+		}
+
+		memcpy(&clownmdemu->mega_cd_state->prg_ram.buffer[masked_address / 2 + protected_words], &words[protected_words], (words_done - protected_words) * sizeof(*words));
+	}
+	else if (masked_address < 0xC0000)
+	{
+		/* WORD-RAM (2M) */
+		if (!clownmdemu->mega_cd_state->word_ram.in_1m_mode)
+		{
+			words_done = CC_MIN(total_words, (0xC0000 - masked_address) / 2);
+
+			if (!clownmdemu->mega_cd_state->word_ram.dmna)
+			{
+				LogMessage("SUB-CPU attempted to DMA to WORD-RAM while MAIN-CPU has it at 0x%" CC_PRIXLEAST32, clownmdemu->mega_cd_state->m68k.state.program_counter);
+			}
+			else
+			{
+				/* The graphics operation's lines that are due must read WORD-RAM as it was before this. */
+				SyncGraphics((CPUCallbackUserData*)user_data, target_cycle);
+				memcpy(&clownmdemu->mega_cd_state->word_ram.buffer[(masked_address / 2) & 0x1FFFF], words, words_done * sizeof(*words));
+			}
+		}
+	}
+	else if (masked_address < 0xE0000)
+	{
+		/* WORD-RAM (1M) */
+		if (clownmdemu->mega_cd_state->word_ram.in_1m_mode)
+		{
+			/* The SUB-CPU's bank is interleaved with the MAIN-CPU's. */
+			cc_u16l* const bank = &clownmdemu->mega_cd_state->word_ram.buffer[!clownmdemu->mega_cd_state->word_ram.ret];
+			const cc_u32f first_word = (masked_address / 2) & 0xFFFF;
+
+			words_done = CC_MIN(total_words, (0xE0000 - masked_address) / 2);
+
+			SyncGraphics((CPUCallbackUserData*)user_data, target_cycle);
+
+			for (i = 0; i < words_done; ++i)
+				bank[(first_word + i) * 2] = words[i];
+		}
+	}
+
+	address += words_done * (to_pcm_ram ? 4 : 2);
+
+	for (i = words_done; i < total_words; ++i)
+	{
+		/* The behaviour of CDC-to-PCM DMA exposes that this really does leverage the Sub-CPU bus on a Mega CD:
+		   the DMA destination address is measured in Sub-CPU address space bytes, not PCM RAM buffer bytes.
+		   That is to say, setting it to 8 will cause the data to be copied to 4 bytes into PCM RAM. */
+		if (to_pcm_ram)
+		{
+			MCDM68kWriteWord(user_data, address, words[i] >> 8, target_cycle);
+			address += 2;
+			MCDM68kWriteWord(user_data, address, words[i] & 0xFF, target_cycle);
+		}
+		else
+		{
+			MCDM68kWriteWord(user_data, address, words[i], target_cycle);
+		}
+
+		address += 2;
+	}
 }
 
 /* TODO: Move this to its own file? */
@@ -76,12 +177,12 @@ static void MegaCDBIOSCall(const ClownMDEmu* const clownmdemu, const void* const
 			/* Fallthrough */
 		case 0x03:
 			/* MSCPAUSEON */
-			CDDA_SetPaused(&clownmdemu->state->mega_cd.cdda, cc_true);
+			CDDA_SetPaused(&clownmdemu->mega_cd_state->cdda, cc_true);
 			break;
 
 		case 0x04:
 			/* MSCPAUSEOFF */
-			CDDA_SetPaused(&clownmdemu->state->mega_cd.cdda, cc_false);
+			CDDA_SetPaused(&clownmdemu->mega_cd_state->cdda, cc_false);
 			break;
 
 		case 0x11:
@@ -93,8 +194,8 @@ static void MegaCDBIOSCall(const ClownMDEmu* const clownmdemu, const void* const
 		{
 			const cc_u16f track_number = MCDM68kReadWord(user_data, clownmdemu->mcd_m68k->address_registers[0] + 0, target_cycle);
 
-			CDDA_SetPlaying(&clownmdemu->state->mega_cd.cdda, cc_true);
-			CDDA_SetPaused(&clownmdemu->state->mega_cd.cdda, cc_false);
+			CDDA_SetPlaying(&clownmdemu->mega_cd_state->cdda, cc_true);
+			CDDA_SetPaused(&clownmdemu->mega_cd_state->cdda, cc_false);
 
 			frontend_callbacks->cd_track_seeked((void*)frontend_callbacks->user_data, track_number, command == 0x11 ? CLOWNMDEMU_CDDA_PLAY_ALL : command == 0x12 ? CLOWNMDEMU_CDDA_PLAY_ONCE : CLOWNMDEMU_CDDA_PLAY_REPEAT);
 			break;
@@ -149,9 +250,9 @@ static void MegaCDBIOSCall(const ClownMDEmu* const clownmdemu, const void* const
 			const cc_u16f volume = clownmdemu->mcd_m68k->data_registers[1] & 0x7FFF;
 
 			if (is_master_volume)
-				CDDA_SetMasterVolume(&clownmdemu->state->mega_cd.cdda, volume);
+				CDDA_SetMasterVolume(&clownmdemu->mega_cd_state->cdda, volume);
 			else
-				CDDA_SetVolume(&clownmdemu->state->mega_cd.cdda, volume);
+				CDDA_SetVolume(&clownmdemu->mega_cd_state->cdda, volume);
 
 			break;
 		}
@@ -162,7 +263,7 @@ static void MegaCDBIOSCall(const ClownMDEmu* const clownmdemu, const void* const
 			const cc_u16f target_volume = clownmdemu->mcd_m68k->data_registers[1] >> 16;
 			const cc_u16f fade_step = clownmdemu->mcd_m68k->data_registers[1] & 0xFFFF;
 
-			CDDA_FadeToVolume(&clownmdemu->state->mega_cd.cdda, target_volume, fade_step);
+			CDDA_FadeToVolume(&clownmdemu->mega_cd_state->cdda, target_volume, fade_step);
 
 			break;
 		}
@@ -174,12 +275,12 @@ static void MegaCDBIOSCall(const ClownMDEmu* const clownmdemu, const void* const
 
 		case 0x89:
 			/* CDCSTOP */
-			CDC_Stop(&clownmdemu->state->mega_cd.cdc);
+			CDC_Stop(&clownmdemu->mega_cd_state->cdc);
 			break;
 
 		case 0x8A:
 			/* CDCSTAT */
-			if (!CDC_Stat(&clownmdemu->state->mega_cd.cdc, frontend_callbacks->cd_sector_read, frontend_callbacks->user_data))
+			if (!CDC_Stat(&clownmdemu->mega_cd_state->cdc, frontend_callbacks->cd_sector_read, frontend_callbacks->user_data))
 				clownmdemu->mcd_m68k->status_register |= 1; /* Set carry flag to signal that a sector is not ready. */
 			else
 				clownmdemu->mcd_m68k->status_register &= ~1; /* Clear carry flag to signal that there's a sector ready. */
@@ -188,7 +289,7 @@ static void MegaCDBIOSCall(const ClownMDEmu* const clownmdemu, const void* const
 
 		case 0x8B:
 			/* CDCREAD */
-			if (!CDC_Read(&clownmdemu->state->mega_cd.cdc, frontend_callbacks->cd_sector_read, frontend_callbacks->user_data, &clownmdemu->mcd_m68k->data_registers[0]))
+			if (!CDC_Read(&clownmdemu->mega_cd_state->cdc, frontend_callbacks->cd_sector_read, frontend_callbacks->user_data, &clownmdemu->mcd_m68k->data_registers[0]))
 			{
 				/* Sonic Megamix 4.0b relies on this. */
 				clownmdemu->mcd_m68k->status_register |= 1; /* Set carry flag to signal that a sector has not been prepared. */
@@ -196,7 +297,7 @@ static void MegaCDBIOSCall(const ClownMDEmu* const clownmdemu, const void* const
 			else
 			{
 				/* TODO: This really belongs in the CDC logic, but it needs access to the RAM buffers... */
-				switch (clownmdemu->state->mega_cd.cdc.device_destination)
+				switch (clownmdemu->mega_cd_state->cdc.device_destination)
 				{
 					case CDC_DESTINATION_PCM_RAM:
 					case CDC_DESTINATION_PRG_RAM:
@@ -204,9 +305,9 @@ static void MegaCDBIOSCall(const ClownMDEmu* const clownmdemu, const void* const
 					{
 						/* TODO: How is RAM address overflow handled? */
 						cc_u32f address;
-						const cc_u32f offset = (cc_u32f)clownmdemu->state->mega_cd.cdc.dma_address * 8;
+						const cc_u32f offset = (cc_u32f)clownmdemu->mega_cd_state->cdc.dma_address * 8;
 
-						switch (clownmdemu->state->mega_cd.cdc.device_destination)
+						switch (clownmdemu->mega_cd_state->cdc.device_destination)
 						{
 							case 4:
 								address = 0xFFFF2000 + (offset & 0x1FFF);
@@ -217,34 +318,21 @@ static void MegaCDBIOSCall(const ClownMDEmu* const clownmdemu, const void* const
 								break;
 
 							case 7:
-								address = clownmdemu->state->mega_cd.word_ram.in_1m_mode ? 0xC0000 + (offset & 0x1FFFF) : 0x80000 + (offset & 0x3FFFF);
+								address = clownmdemu->mega_cd_state->word_ram.in_1m_mode ? 0xC0000 + (offset & 0x1FFFF) : 0x80000 + (offset & 0x3FFFF);
 								break;
 						}
 
 						/* Discard the header data. */
-						CDC_HostData(&clownmdemu->state->mega_cd.cdc, cc_true);
-						CDC_HostData(&clownmdemu->state->mega_cd.cdc, cc_true);
+						CDC_HostData(&clownmdemu->mega_cd_state->cdc, cc_true);
+						CDC_HostData(&clownmdemu->mega_cd_state->cdc, cc_true);
 
 						/* Copy the sector data to the DMA destination. */
-						/* The behaviour of CDC-to-PCM DMA exposes that this really does leverage the Sub-CPU bus on a Mega CD:
-						   the DMA destination address is measured in Sub-CPU address space bytes, not PCM RAM buffer bytes.
-						   That is to say, setting it to 8 will cause the data to be copied to 4 bytes into PCM RAM. */
-						while ((CDC_Mode(&clownmdemu->state->mega_cd.cdc, cc_true) & 0x4000) != 0)
 						{
-							const cc_u16f word = CDC_HostData(&clownmdemu->state->mega_cd.cdc, cc_true);
-
-							if (clownmdemu->state->mega_cd.cdc.device_destination == CDC_DESTINATION_PCM_RAM)
-							{
-								MCDM68kWriteWord(user_data, address, word >> 8, target_cycle);
-								address += 2;
-								MCDM68kWriteWord(user_data, address, word & 0xFF, target_cycle);
-							}
-							else
-							{
-								MCDM68kWriteWord(user_data, address, word, target_cycle);
-							}
-
-							address += 2;
+							const cc_u16l *words;
+							const cc_u16f total_words = CDC_HostDataSpan(&clownmdemu->mega_cd_state->cdc, cc_true, &words);
+
+							if (total_words != 0)
+								CDCDMA(clownmdemu, user_data, address, words, total_words, target_cycle);
 						}
 
 						break;
@@ -258,7 +346,7 @@ static void MegaCDBIOSCall(const ClownMDEmu* const clownmdemu, const void* const
 
 		case 0x8C:
 			/* CDCTRN */
-			if ((CDC_Mode(&clownmdemu->state->mega_cd.cdc, cc_true) & 0x8000) != 0)
+			if ((CDC_Mode(&clownmdemu->mega_cd_state->cdc, cc_true) & 0x8000) != 0)
 			{
 				clownmdemu->mcd_m68k->status_register |= 1; /* Set carry flag to signal that there's not a sector ready. */
 			}
@@ -268,11 +356,11 @@ static void MegaCDBIOSCall(const ClownMDEmu* const clownmdemu, const void* const
 				const cc_u32f sector_address = clownmdemu->mcd_m68k->address_registers[0];
 				const cc_u32f header_address = clownmdemu->mcd_m68k->address_registers[1];
 
-				MCDM68kWriteWord(user_data, header_address + 0, CDC_HostData(&clownmdemu->state->mega_cd.cdc, cc_true), target_cycle);
-				MCDM68kWriteWord(user_data, header_address + 2, CDC_HostData(&clownmdemu->state->mega_cd.cdc, cc_true), target_cycle);
+				MCDM68kWriteWord(user_data, header_address + 0, CDC_HostData(&clownmdemu->mega_cd_state->cdc, cc_true), target_cycle);
+				MCDM68kWriteWord(user_data, header_address + 2, CDC_HostData(&clownmdemu->mega_cd_state->cdc, cc_true), target_cycle);
 
 				for (i = 0; i < CDC_SECTOR_SIZE; i += 2)
-					MCDM68kWriteWord(user_data, sector_address + i, CDC_HostData(&clownmdemu->state->mega_cd.cdc, cc_true), target_cycle);
+					MCDM68kWriteWord(user_data, sector_address + i, CDC_HostData(&clownmdemu->mega_cd_state->cdc, cc_true), target_cycle);
 
 				clownmdemu->mcd_m68k->address_registers[0] = (clownmdemu->mcd_m68k->address_registers[0] + CDC_SECTOR_SIZE) & 0xFFFFFFFF;
 				clownmdemu->mcd_m68k->address_registers[1] = (clownmdemu->mcd_m68k->address_registers[1] + 4) & 0xFFFFFFFF;
@@ -284,7 +372,7 @@ static void MegaCDBIOSCall(const ClownMDEmu* const clownmdemu, const void* const
 
 		case 0x8D:
 			/* CDCACK */
-			CDC_Ack(&clownmdemu->state->mega_cd.cdc);
+			CDC_Ack(&clownmdemu->mega_cd_state->cdc);
 			break;
 
 		default:
@@ -293,58 +381,9 @@ static void MegaCDBIOSCall(const ClownMDEmu* const clownmdemu, const void* const
 	}
 }
 
-static cc_u16f SyncMCDM68kForRealCallback(const ClownMDEmu* const clownmdemu, void* const user_data)
+static size_t StampMapDiameterInPixels(ClownMDEmu_MegaCDState* const state)
 {
-	const Clown68000_ReadWriteCallbacks* const m68k_read_write_callbacks = (const Clown68000_ReadWriteCallbacks*)user_data;
-
-	return CLOWNMDEMU_MCD_M68K_CLOCK_DIVIDER * Clown68000_DoCycle(clownmdemu->mcd_m68k, m68k_read_write_callbacks);
-}
-
-void SyncMCDM68kForReal(const ClownMDEmu* const clownmdemu, const Clown68000_ReadWriteCallbacks* const m68k_read_write_callbacks, const CycleMegaCD target_cycle)
-{
-	const cc_bool mcd_m68k_not_running = clownmdemu->state->mega_cd.m68k.bus_requested || clownmdemu->state->mega_cd.m68k.reset_held;
-
-	CPUCallbackUserData* const other_state = (CPUCallbackUserData*)m68k_read_write_callbacks->user_data;
-
-	SyncCPUCommon(clownmdemu, &other_state->sync.mcd_m68k, target_cycle.cycle, mcd_m68k_not_running, SyncMCDM68kForRealCallback, m68k_read_write_callbacks);
-}
-
-static cc_u16f SyncMCDM68kCallback(const ClownMDEmu* const clownmdemu, void* const user_data)
-{
-	const Clown68000_ReadWriteCallbacks* const m68k_read_write_callbacks = (const Clown68000_ReadWriteCallbacks*)user_data;
-	CPUCallbackUserData* const other_state = (CPUCallbackUserData*)m68k_read_write_callbacks->user_data;
-	CycleMegaCD current_cycle;
-
-	/* Update the 68000 to this point in time. */
-	current_cycle.cycle = other_state->sync.mcd_m68k_irq3.current_cycle;
-	SyncMCDM68kForReal(clownmdemu, m68k_read_write_callbacks, current_cycle);
-
-	/* Raise an interrupt. */
-	if (clownmdemu->state->mega_cd.irq.enabled[2])
-		Clown68000_Interrupt(clownmdemu->mcd_m68k, 3);
-
-	return clownmdemu->state->mega_cd.irq.irq3_countdown_master;
-}
-
-void SyncMCDM68k(const ClownMDEmu* const clownmdemu, CPUCallbackUserData* const other_state, const CycleMegaCD target_cycle)
-{
-	Clown68000_ReadWriteCallbacks m68k_read_write_callbacks;
-
-	m68k_read_write_callbacks.read_callback = MCDM68kReadCallback;
-	m68k_read_write_callbacks.write_callback = MCDM68kWriteCallback;
-	m68k_read_write_callbacks.user_data = other_state;
-
-	/* In order to support the timer interrupt (IRQ3), we hijack this function to update an IRQ3 sync object instead. */
-	/* This sync object will raise interrupts whilst also synchronising the 68000. */
-	SyncCPUCommon(clownmdemu, &other_state->sync.mcd_m68k_irq3, target_cycle.cycle, cc_false, SyncMCDM68kCallback, &m68k_read_write_callbacks);
-
-	/* Now that we're done with IRQ3, finish synchronising the 68000. */
-	SyncMCDM68kForReal(clownmdemu, &m68k_read_write_callbacks, target_cycle);
-}
-
-static size_t StampMapDiameterInPixels(ClownMDEmu_State* const state)
-{
-	return state->mega_cd.rotation.large_stamp_map ? 1 << 12 : 1 << 8;
+	return state->rotation.large_stamp_map ? 1 << 12 : 1 << 8;
 }
 
 #define SHIFT_TO_NORMAL(SHIFT) ((size_t)1 << (SHIFT))
@@ -357,14 +396,9 @@ static size_t StampMapDiameterInPixels(ClownMDEmu_State* const state)
 #define STAMP_TILE_DIAMETER_IN_PIXELS_SHIFT 3
 #define STAMP_TILE_DIAMETER_IN_PIXELS SHIFT_TO_NORMAL(STAMP_TILE_DIAMETER_IN_PIXELS_SHIFT)
 
-static cc_u8f StampDiameterInPixelsShift(ClownMDEmu_State* const state)
+static cc_u8f StampDiameterInPixelsShift(ClownMDEmu_MegaCDState* const state)
 {
-	return STAMP_TILE_DIAMETER_IN_PIXELS_SHIFT + 1 + state->mega_cd.rotation.large_stamp;
-}
-
-static const cc_u16l* GetStampMapAddress(ClownMDEmu_State* const state)
-{
-	return state->mega_cd.word_ram.buffer + (size_t)state->mega_cd.rotation.stamp_map_address * 2;
+	return STAMP_TILE_DIAMETER_IN_PIXELS_SHIFT + 1 + state->rotation.large_stamp;
 }
 
 #define SMALL_STAMP_DIAMETER_IN_PIXELS_SHIFT (STAMP_TILE_DIAMETER_IN_PIXELS_SHIFT + 1) /* 16x16 */
@@ -375,12 +409,12 @@ static const cc_u16l* GetStampMapAddress(ClownMDEmu_State* const state)
 #define SMALL_STAMP_SIZE_IN_WORDS (SMALL_STAMP_DIAMETER_IN_PIXELS * SMALL_STAMP_DIAMETER_IN_PIXELS / PIXELS_PER_WORD)
 #define LARGE_STAMP_SIZE_IN_WORDS (LARGE_STAMP_DIAMETER_IN_PIXELS * LARGE_STAMP_DIAMETER_IN_PIXELS / PIXELS_PER_WORD)
 
-static const cc_u16l* GetStampAddress(ClownMDEmu_State* const state, const cc_u16f index)
+static const cc_u16l* GetStampAddress(ClownMDEmu_MegaCDState* const state, const cc_u16f index)
 {
-	if (state->mega_cd.rotation.large_stamp)
-		return state->mega_cd.word_ram.buffer + (index * SMALL_STAMP_SIZE_IN_WORDS);
+	if (state->rotation.large_stamp)
+		return state->word_ram.buffer + (index * SMALL_STAMP_SIZE_IN_WORDS);
 	else
-		return state->mega_cd.word_ram.buffer + (index / (LARGE_STAMP_SIZE_IN_WORDS / SMALL_STAMP_SIZE_IN_WORDS) * LARGE_STAMP_SIZE_IN_WORDS);
+		return state->word_ram.buffer + (index / (LARGE_STAMP_SIZE_IN_WORDS / SMALL_STAMP_SIZE_IN_WORDS) * LARGE_STAMP_SIZE_IN_WORDS);
 }
 
 static size_t PixelIndexFromImageBufferCoordinate(const cc_u16f x, const cc_u16f y, const size_t image_buffer_height)
@@ -393,106 +427,427 @@ static size_t PixelIndexFromImageBufferCoordinate(const cc_u16f x, const cc_u16f
 	return (size_t)tile_row_index * STAMP_TILE_DIAMETER_IN_PIXELS + pixel_x_in_tile;
 }
 
-static cc_u8f ReadPixelFromWord(const cc_u16f word, const cc_u8f pixel_index)
+/* Draws one line of the graphics operation, by walking its trace vector across the stamp map. */
+static void DrawGraphicsLine(ClownMDEmu_MegaCDState* const state)
 {
-	const cc_u8f pixel_mask = ((1 << BITS_PER_PIXEL) - 1);
-	return (word >> (BITS_PER_WORD - (BITS_PER_PIXEL * (1 + pixel_index)))) & pixel_mask;
+	const cc_u8f fraction_shift = 11;
+	const cc_u16l* const word_ram = state->word_ram.buffer;
+	const cc_u32f trace_vector_index = (cc_u32f)state->rotation.trace_table_address * 2;
+	/* TODO: Does this actually offset the destination instead of the source? */
+	const cc_u32f x_offset = -(cc_u32f)state->rotation.image_buffer_x_offset << fraction_shift;
+	const cc_u32f y_offset = -(cc_u32f)state->rotation.image_buffer_y_offset << fraction_shift;
+	const cc_u32f delta_x = CC_SIGN_EXTEND(cc_u32f, 15, word_ram[(trace_vector_index + 2) % CC_COUNT_OF(state->word_ram.buffer)]);
+	const cc_u32f delta_y = CC_SIGN_EXTEND(cc_u32f, 15, word_ram[(trace_vector_index + 3) % CC_COUNT_OF(state->word_ram.buffer)]);
+
+	const cc_u8f stamp_diameter_in_pixels_shift = StampDiameterInPixelsShift(state);
+	const size_t stamp_diameter_in_pixels = SHIFT_TO_NORMAL(stamp_diameter_in_pixels_shift);
+	const size_t stamp_map_diameter_in_pixels = StampMapDiameterInPixels(state);
+	const size_t stamp_map_diameter_in_stamps = stamp_map_diameter_in_pixels >> stamp_diameter_in_pixels_shift;
+	const size_t stamp_map_size_mask = stamp_map_diameter_in_pixels - 1;
+	const size_t stamp_size_mask = stamp_diameter_in_pixels - 1;
+	const size_t stamp_map_address = (size_t)state->rotation.stamp_map_address * 2;
+
+	/* TODO: Rename 'image_buffer_height_in_tiles' to 'image_buffer_height_in_tiles_minus_one'. */
+	const size_t image_buffer_height_in_pixels = (state->rotation.image_buffer_height_in_tiles + 1) * STAMP_TILE_DIAMETER_IN_PIXELS;
+	const size_t image_buffer_address = (size_t)state->rotation.image_buffer_address * 2;
+	const cc_u16f image_buffer_width = state->rotation.image_buffer_width;
+
+	cc_u32f sample_x = x_offset + (CC_SIGN_EXTEND(cc_u32f, 15, word_ram[(trace_vector_index + 0) % CC_COUNT_OF(state->word_ram.buffer)]) << (fraction_shift - 3));
+	cc_u32f sample_y = y_offset + (CC_SIGN_EXTEND(cc_u32f, 15, word_ram[(trace_vector_index + 1) % CC_COUNT_OF(state->word_ram.buffer)]) << (fraction_shift - 3));
+
+	/* Neighbouring pixels usually come from the same stamp, so the last stamp to be decoded is kept around. */
+	size_t cached_stamp_index_within_stamp_map = (size_t)-1;
+	const cc_u16l *stamp_address = NULL;
+	size_t x_flip_mask = 0, y_flip_mask = 0;
+	cc_bool swap_coordinates = cc_false;
+
+	cc_u16f word = 0;
+	cc_u16f pixel_x_in_image_buffer;
+
+	for (pixel_x_in_image_buffer = 0; pixel_x_in_image_buffer < image_buffer_width; ++pixel_x_in_image_buffer)
+	{
+		const cc_u32f pixel_x = sample_x >> fraction_shift;
+		const cc_u32f pixel_y = sample_y >> fraction_shift;
+
+		cc_u8f pixel = 0;
+
+		if (state->rotation.repeating_stamp_map || (pixel_x < stamp_map_diameter_in_pixels && pixel_y < stamp_map_diameter_in_pixels))
+		{
+			const size_t pixel_x_within_stamp_map = pixel_x & stamp_map_size_mask;
+			const size_t pixel_y_within_stamp_map = pixel_y & stamp_map_size_mask;
+
+			const size_t stamp_index_within_stamp_map = (pixel_y_within_stamp_map >> stamp_diameter_in_pixels_shift) * stamp_map_diameter_in_stamps + (pixel_x_within_stamp_map >> stamp_diameter_in_pixels_shift);
+
+			if (stamp_index_within_stamp_map != cached_stamp_index_within_stamp_map)
+			{
+				const cc_u16f stamp_metadata = word_ram[(stamp_map_address + stamp_index_within_stamp_map) % CC_COUNT_OF(state->word_ram.buffer)];
+				const cc_u16f stamp_index = stamp_metadata & 0x7FF;
+				const cc_bool horizontal_flip = (stamp_metadata & 0x8000) != 0;
+
+				cc_bool x_flip = cc_false, y_flip = cc_false;
+
+				cached_stamp_index_within_stamp_map = stamp_index_within_stamp_map;
+				stamp_address = stamp_index == 0 ? NULL : GetStampAddress(state, stamp_index);
+				swap_coordinates = cc_false;
+
+				switch ((stamp_metadata >> 13) & 3)
+				{
+					case 0: /* 0 degrees */
+						break;
+
+					case 1: /* 90 degrees */
+						y_flip = cc_true;
+						swap_coordinates = cc_true;
+						break;
+
+					case 2: /* 180 degrees */
+						x_flip = cc_true;
+						y_flip = cc_true;
+						break;
+
+					case 3: /* 270 degrees */
+						x_flip = cc_true;
+						swap_coordinates = cc_true;
+						break;
+				}
+
+				x_flip ^= horizontal_flip;
+
+				/* Stamps are a power of two in size, so flipping a coordinate is the same as inverting its bits. */
+				x_flip_mask = x_flip ? stamp_size_mask : 0;
+				y_flip_mask = y_flip ? stamp_size_mask : 0;
+			}
+
+			if (stamp_address != NULL)
+			{
+				const size_t pixel_x_within_stamp = (pixel_x_within_stamp_map & stamp_size_mask) ^ x_flip_mask;
+				const size_t pixel_y_within_stamp = (pixel_y_within_stamp_map & stamp_size_mask) ^ y_flip_mask;
+				const size_t pixel_index_within_stamp = swap_coordinates
+					? PixelIndexFromImageBufferCoordinate(pixel_y_within_stamp, pixel_x_within_stamp, stamp_diameter_in_pixels)
+					: PixelIndexFromImageBufferCoordinate(pixel_x_within_stamp, pixel_y_within_stamp, stamp_diameter_in_pixels);
+
+				pixel = (stamp_address[pixel_index_within_stamp / PIXELS_PER_WORD] >> (BITS_PER_WORD - BITS_PER_PIXEL * (1 + pixel_index_within_stamp % PIXELS_PER_WORD))) & ((1 << BITS_PER_PIXEL) - 1);
+			}
+		}
+
+		/* TODO: Priority mode! */
+		/* Pixels are gathered into words, which are then written to the image buffer whole. */
+		word = (word << BITS_PER_PIXEL) | pixel;
+
+		if (pixel_x_in_image_buffer % PIXELS_PER_WORD == PIXELS_PER_WORD - 1 || pixel_x_in_image_buffer == image_buffer_width - 1)
+		{
+			/* A word at the end of the line may be incomplete, in which case the pixels after the line are left alone. */
+			const cc_u8f unused_bits = BITS_PER_PIXEL * (PIXELS_PER_WORD - 1 - pixel_x_in_image_buffer % PIXELS_PER_WORD);
+			const cc_u16f mask = (0xFFFF << unused_bits) & 0xFFFF;
+			const size_t pixel_index_within_image_buffer = PixelIndexFromImageBufferCoordinate(pixel_x_in_image_buffer, state->rotation.image_buffer_line, image_buffer_height_in_pixels);
+			cc_u16l* const destination = &state->word_ram.buffer[(image_buffer_address + pixel_index_within_image_buffer / PIXELS_PER_WORD) % CC_COUNT_OF(state->word_ram.buffer)];
+
+			*destination = (*destination & ~mask) | (word << unused_bits);
+			word = 0;
+		}
+
+		sample_x += delta_x;
+		sample_y += delta_y;
+	}
+
+	/* Each trace vector is four words long, and the trace table address is measured in pairs of words. */
+	state->rotation.trace_table_address += 2;
+	++state->rotation.image_buffer_line;
+	/* The graphics operation decrements this until it reaches 0. Sonic CD relies on this to load its special stages. */
+	--state->rotation.image_buffer_height;
 }
 
-static void WritePixelToWord(cc_u16l* const word, const cc_u8f pixel_index, const cc_u8f pixel)
+static cc_u16f GraphicsCyclesPerLine(ClownMDEmu_MegaCDState* const state)
 {
-	const cc_u16f pixel_mask = ((1 << BITS_PER_PIXEL) - 1);
-	const cc_u8f shift = (BITS_PER_WORD - (BITS_PER_PIXEL * (1 + pixel_index)));
-	*word &= ~(pixel_mask << shift);
-	*word |= (cc_u16f)pixel << shift;
+	/* Each pixel takes 5 SUB-CPU cycles to draw. */
+	/* TODO: Find out how long an empty line takes. */
+	return CC_MAX(1, state->rotation.image_buffer_width * 5) * CLOWNMDEMU_MCD_M68K_CLOCK_DIVIDER;
 }
 
-static cc_u8f PixelFromStamp(const cc_u16l* const buffer, const cc_u16f x, const cc_u16f y, const size_t stamp_height)
+static cc_u16f SyncGraphicsCallback(const ClownMDEmu* const clownmdemu, void* const user_data)
 {
-	const cc_u32f pixel_index_within_stamp = PixelIndexFromImageBufferCoordinate(x, y, stamp_height);
+	(void)user_data;
+
+	/* The image buffer height can be changed mid-operation, so it may already be 0. */
+	if (clownmdemu->mega_cd_state->rotation.image_buffer_height != 0)
+		DrawGraphicsLine(clownmdemu->mega_cd_state);
 
-	const cc_u32f word_index_within_stamp = pixel_index_within_stamp / PIXELS_PER_WORD;
-	const cc_u8f pixel_index_within_word = pixel_index_within_stamp % PIXELS_PER_WORD;
+	if (clownmdemu->mega_cd_state->rotation.image_buffer_height != 0)
+		return GraphicsCyclesPerLine(clownmdemu->mega_cd_state);
 
-	const cc_u16f word = buffer[word_index_within_stamp];
-	const cc_u8f pixel = ReadPixelFromWord(word, pixel_index_within_word);
+	/* Fire the 'graphics operation complete' interrupt. */
+	if (clownmdemu->mega_cd_state->irq.enabled[0])
+		Clown68000_Interrupt(clownmdemu->mcd_m68k, 1);
 
-	return pixel;
+	return 0;
 }
 
-static cc_u8f ReadPixelFromStampMap(ClownMDEmu_State* const state, const cc_u32f x, const cc_u32f y)
+/* Draws the lines of the graphics operation that are due by the given cycle. */
+static void SyncGraphics(CPUCallbackUserData* const other_state, const CycleMegaCD target_cycle)
 {
-	const cc_u8f stamp_diameter_in_pixels_shift = StampDiameterInPixelsShift(state);
-	const size_t stamp_diameter_in_pixels = SHIFT_TO_NORMAL(stamp_diameter_in_pixels_shift);
-	const size_t stamp_map_diameter_in_pixels = StampMapDiameterInPixels(state);
-	const size_t stamp_map_diameter_in_stamps = stamp_map_diameter_in_pixels >> stamp_diameter_in_pixels_shift;
-	const size_t stamp_map_size_mask = stamp_map_diameter_in_pixels - 1;
-	const size_t stamp_size_mask = stamp_diameter_in_pixels - 1;
+	SyncCPUCommon(other_state->clownmdemu, &other_state->sync.mcd_graphics, target_cycle.cycle, cc_false, SyncGraphicsCallback, NULL);
+}
 
-	if (!state->mega_cd.rotation.repeating_stamp_map && (x >= stamp_map_diameter_in_pixels || y >= stamp_map_diameter_in_pixels))
+static void StartGraphics(CPUCallbackUserData* const other_state, const cc_u16f trace_table_address, const CycleMegaCD target_cycle)
+{
+	ClownMDEmu_MegaCDState* const state = other_state->clownmdemu->mega_cd_state;
+
+	/* Finish the lines of the previous operation that were drawn before this one replaced it. */
+	SyncGraphics(other_state, target_cycle);
+
+	state->rotation.trace_table_address = trace_table_address;
+	state->rotation.image_buffer_line = 0;
+
+	if (state->rotation.image_buffer_height == 0)
 	{
-		return 0;
+		state->rotation.cycle_countdown = 0;
+
+		if (state->irq.enabled[0])
+			Clown68000_Interrupt(other_state->clownmdemu->mcd_m68k, 1);
 	}
 	else
 	{
-		const size_t pixel_x_within_stamp_map = x & stamp_map_size_mask;
-		const size_t pixel_y_within_stamp_map = y & stamp_map_size_mask;
+		state->rotation.cycle_countdown = GraphicsCyclesPerLine(state);
+	}
+}
+
+/* The least number of cycles that the SUB-CPU is handed over to the other thread for. */
+#define MCD_M68K_THREAD_QUANTUM 0x8000
+
+/* Loops that are longer than these are not considered to be polling loops. */
+#define IDLE_LOOP_MAXIMUM_LENGTH 0x40
+#define IDLE_LOOP_MAXIMUM_CYCLES (0x100 * CLOWNMDEMU_MCD_M68K_CLOCK_DIVIDER)
+
+/* Skips as many whole iterations of an idle loop as will fit before the target cycle, returning the number of cycles skipped. */
+static cc_u16f SkipIdleIterations(const ClownMDEmu* const clownmdemu, const CPUCallbackUserData* const other_state, const cc_u32f cycles_per_iteration)
+{
+	const cc_u32f current_cycle = other_state->sync.mcd_m68k.current_cycle;
+	/* On the other thread, the MAIN-CPU is already known to be ahead of the target, and it cannot be looked at anyway. */
+	const cc_bool main_cpu_may_be_behind = !other_state->mcd_m68k_thread.on_other_thread;
+	const cc_u32f m68k_current_cycle = main_cpu_may_be_behind ? other_state->sync.m68k.current_cycle : 0;
+
+	/* The MAIN-CPU is normally ahead of the SUB-CPU, but, when it is not, reading the communication registers makes it catch up.
+	   Skipping past where the MAIN-CPU currently is would miss whatever it does when it catches up, so stop there instead. */
+	const cc_u32f ending_cycle = !main_cpu_may_be_behind ? other_state->mcd_m68k_idle.target_cycle : CC_MIN(other_state->mcd_m68k_idle.target_cycle, CycleMegaDriveToMegaCD(clownmdemu, MakeCycleMegaDrive(m68k_current_cycle)).cycle);
+
+	/* The countdown can only hold so many cycles, but the loop can simply be skipped again once they are done. */
+	const cc_u32f cycles_until_target = ending_cycle < current_cycle ? 0 : CC_MIN(0xFFFF, ending_cycle - current_cycle);
+
+	cc_u32f cycles_skipped = cycles_until_target - cycles_until_target % cycles_per_iteration;
+
+	/* Converting between the two clocks is not exact, so make sure. */
+	while (main_cpu_may_be_behind && cycles_skipped != 0 && CycleMegaCDToMegaDrive(clownmdemu, MakeCycleMegaCD(current_cycle + cycles_skipped)).cycle > m68k_current_cycle)
+		cycles_skipped -= cycles_per_iteration;
+
+	if (clownmdemu->sub_cpu_idle_statistics != NULL && cycles_skipped != 0)
+	{
+		++clownmdemu->sub_cpu_idle_statistics->polls_skipped;
+		clownmdemu->sub_cpu_idle_statistics->cycles_skipped += cycles_skipped;
+	}
 
-		const size_t stamp_x_within_stamp_map = pixel_x_within_stamp_map >> stamp_diameter_in_pixels_shift;
-		const size_t stamp_y_within_stamp_map = pixel_y_within_stamp_map >> stamp_diameter_in_pixels_shift;
+	return cycles_skipped;
+}
 
-		const size_t stamp_index_within_stamp_map = stamp_y_within_stamp_map * stamp_map_diameter_in_stamps + stamp_x_within_stamp_map;
+static cc_u16f SyncMCDM68kForRealCallback(const ClownMDEmu* const clownmdemu, void* const user_data)
+{
+	const Clown68000_ReadWriteCallbacks* const m68k_read_write_callbacks = (const Clown68000_ReadWriteCallbacks*)user_data;
+	CPUCallbackUserData* const other_state = (CPUCallbackUserData*)m68k_read_write_callbacks->user_data;
+	SubCPUIdleState* const idle = &other_state->mcd_m68k_idle;
+	Clown68000_State* const mcd_m68k = clownmdemu->mcd_m68k;
+	const cc_u32f previous_program_counter = mcd_m68k->program_counter;
 
-		const cc_u16f stamp_metadata = GetStampMapAddress(state)[stamp_index_within_stamp_map];
-		const cc_u16f stamp_index = stamp_metadata & 0x7FF;
-		const cc_u8f rotation = (stamp_metadata >> 13) & 3;
-		const cc_bool horizontal_flip = (stamp_metadata & 0x8000) != 0;
+	cc_u16f cycles;
 
-		if (stamp_index == 0)
+	if (!clownmdemu->configuration->general.sub_cpu_idle_skipping_disabled)
+	{
+		if (mcd_m68k->halted || (mcd_m68k->stopped && mcd_m68k->pending_interrupt != 7 && mcd_m68k->pending_interrupt <= ((cc_u16f)mcd_m68k->status_register >> 8 & 7)))
 		{
-			return 0;
+			/* The 68000 cannot do anything until an interrupt arrives, and those are only raised in between calls to 'SyncMCDM68kForReal'. */
+			cycles = SkipIdleIterations(clownmdemu, other_state, 4 * CLOWNMDEMU_MCD_M68K_CLOCK_DIVIDER);
+
+			if (cycles != 0)
+				return cycles;
 		}
-		else
+		else if (idle->monitoring && mcd_m68k->program_counter == idle->registers.program_counter)
 		{
-			const cc_u16l* const stamp_address = GetStampAddress(state, stamp_index);
+			if (clownmdemu->sub_cpu_idle_statistics != NULL)
+				++clownmdemu->sub_cpu_idle_statistics->polls;
 
-			cc_u16f pixel_x_within_stamp = pixel_x_within_stamp_map & stamp_size_mask;
-			cc_u16f pixel_y_within_stamp = pixel_y_within_stamp_map & stamp_size_mask;
+			/* If the loop only read memory that nothing but the SUB-CPU can change, and it came back around with the same registers,
+			   then every iteration until the next call to 'SyncMCDM68kForReal' will be identical to this one, so they can be skipped. */
+			if (!idle->disturbed && memcmp(mcd_m68k, &idle->registers, sizeof(*mcd_m68k)) == 0)
+			{
+				cycles = SkipIdleIterations(clownmdemu, other_state, idle->loop_cycles);
 
-			cc_bool x_flip = cc_false, y_flip = cc_false, swap_coordinates = cc_false;
+				if (cycles != 0)
+					return cycles;
+			}
 
-			switch (rotation)
-			{
-				case 0: /* 0 degrees */
-					break;
+			memcpy(&idle->registers, mcd_m68k, sizeof(*mcd_m68k));
+			idle->loop_cycles = 0;
+			idle->disturbed = cc_false;
+		}
+	}
 
-				case 1: /* 90 degrees */
-					y_flip = cc_true;
-					swap_coordinates = cc_true;
-					break;
+	cycles = CLOWNMDEMU_MCD_M68K_CLOCK_DIVIDER * Clown68000_DoCycle(mcd_m68k, m68k_read_write_callbacks);
 
-				case 2: /* 180 degrees */
-					x_flip = cc_true;
-					y_flip = cc_true;
-					break;
+	if (idle->monitoring)
+	{
+		idle->loop_cycles += cycles;
 
-				case 3: /* 270 degrees */
-					x_flip = cc_true;
-					swap_coordinates = cc_true;
-					break;
-			}
+		if (idle->loop_cycles > IDLE_LOOP_MAXIMUM_CYCLES)
+			idle->monitoring = cc_false;
+	}
+
+	/* A short jump backwards may be the end of a polling loop. */
+	if (mcd_m68k->program_counter < previous_program_counter && previous_program_counter - mcd_m68k->program_counter <= IDLE_LOOP_MAXIMUM_LENGTH
+	 && (!idle->monitoring || mcd_m68k->program_counter != idle->registers.program_counter))
+	{
+		idle->monitoring = cc_true;
+		idle->registers.program_counter = mcd_m68k->program_counter;
+		/* Make the top of the loop take a fresh snapshot of the registers. */
+		idle->disturbed = cc_true;
+	}
 
-			x_flip ^= horizontal_flip;
+	return cycles;
+}
+
+void SyncMCDM68kForReal(const ClownMDEmu* const clownmdemu, const Clown68000_ReadWriteCallbacks* const m68k_read_write_callbacks, const CycleMegaCD target_cycle)
+{
+	const cc_bool mcd_m68k_not_running = clownmdemu->mega_cd_state->m68k.bus_requested || clownmdemu->mega_cd_state->m68k.reset_held;
 
-			if (x_flip)
-				pixel_x_within_stamp = stamp_diameter_in_pixels - pixel_x_within_stamp - 1;
+	CPUCallbackUserData* const other_state = (CPUCallbackUserData*)m68k_read_write_callbacks->user_data;
 
-			if (y_flip)
-				pixel_y_within_stamp = stamp_diameter_in_pixels - pixel_y_within_stamp - 1;
+	/* This can be called recursively, so preserve the outer call's target. */
+	const cc_u32f previous_target_cycle = other_state->mcd_m68k_idle.target_cycle;
 
-			return PixelFromStamp(stamp_address, swap_coordinates ? pixel_y_within_stamp : pixel_x_within_stamp, swap_coordinates ? pixel_x_within_stamp : pixel_y_within_stamp, stamp_diameter_in_pixels);
-		}
+	/* The other hardware only gets to run in between calls to this function, so this is the only place where
+	   the things that a polling loop is waiting on can change. */
+	other_state->mcd_m68k_idle.target_cycle = target_cycle.cycle;
+	other_state->mcd_m68k_idle.disturbed = cc_true;
+
+	SyncCPUCommon(clownmdemu, &other_state->sync.mcd_m68k, target_cycle.cycle, mcd_m68k_not_running, SyncMCDM68kForRealCallback, m68k_read_write_callbacks);
+
+	other_state->mcd_m68k_idle.target_cycle = previous_target_cycle;
+}
+
+static cc_u16f SyncMCDM68kCallback(const ClownMDEmu* const clownmdemu, void* const user_data)
+{
+	const Clown68000_ReadWriteCallbacks* const m68k_read_write_callbacks = (const Clown68000_ReadWriteCallbacks*)user_data;
+	CPUCallbackUserData* const other_state = (CPUCallbackUserData*)m68k_read_write_callbacks->user_data;
+	CycleMegaCD current_cycle;
+
+	/* Update the 68000 to this point in time. */
+	current_cycle.cycle = other_state->sync.mcd_m68k_irq3.current_cycle;
+	SyncMCDM68kForReal(clownmdemu, m68k_read_write_callbacks, current_cycle);
+
+	/* Raise an interrupt. */
+	if (clownmdemu->mega_cd_state->irq.enabled[2])
+		Clown68000_Interrupt(clownmdemu->mcd_m68k, 3);
+
+	return clownmdemu->mega_cd_state->irq.irq3_countdown_master;
+}
+
+static void SyncMCDM68kAndIRQ3(const ClownMDEmu* const clownmdemu, CPUCallbackUserData* const other_state, const Clown68000_ReadWriteCallbacks* const m68k_read_write_callbacks, const CycleMegaCD target_cycle)
+{
+	/* In order to support the timer interrupt (IRQ3), we hijack this function to update an IRQ3 sync object instead. */
+	/* This sync object will raise interrupts whilst also synchronising the 68000. */
+	SyncCPUCommon(clownmdemu, &other_state->sync.mcd_m68k_irq3, target_cycle.cycle, cc_false, SyncMCDM68kCallback, m68k_read_write_callbacks);
+
+	/* Now that we're done with IRQ3, finish synchronising the 68000. */
+	SyncMCDM68kForReal(clownmdemu, m68k_read_write_callbacks, target_cycle);
+}
+
+static void RunMCDM68k(const ClownMDEmu* const clownmdemu, CPUCallbackUserData* const other_state, const CycleMegaCD target_cycle)
+{
+	Clown68000_ReadWriteCallbacks m68k_read_write_callbacks;
+
+	m68k_read_write_callbacks.read_callback = MCDM68kReadCallback;
+	m68k_read_write_callbacks.write_callback = MCDM68kWriteCallback;
+	m68k_read_write_callbacks.user_data = other_state;
+
+	/* If a graphics operation will finish before the target cycle, then run the 68000 up to that point first,
+	   so that the 'graphics operation complete' interrupt is raised at the right time. */
+	while (clownmdemu->mega_cd_state->rotation.cycle_countdown != 0)
+	{
+		const cc_u16f lines_after_current_line = CC_MAX(1, clownmdemu->mega_cd_state->rotation.image_buffer_height) - 1;
+		const CycleMegaCD ending_cycle = MakeCycleMegaCD(other_state->sync.mcd_graphics.current_cycle + clownmdemu->mega_cd_state->rotation.cycle_countdown + lines_after_current_line * GraphicsCyclesPerLine(clownmdemu->mega_cd_state));
+
+		if (ending_cycle.cycle > target_cycle.cycle)
+			break;
+
+		SyncMCDM68kAndIRQ3(clownmdemu, other_state, &m68k_read_write_callbacks, ending_cycle);
+		SyncGraphics(other_state, ending_cycle);
 	}
+
+	SyncMCDM68kAndIRQ3(clownmdemu, other_state, &m68k_read_write_callbacks, target_cycle);
+	SyncGraphics(other_state, target_cycle);
+}
+
+static void ReclaimMCDM68k(const ClownMDEmu* const clownmdemu, CPUCallbackUserData* const other_state)
+{
+	const ClownMDEmu_SubCPUThread* const thread = clownmdemu->sub_cpu_thread;
+
+	if (other_state->mcd_m68k_thread.released)
+	{
+		other_state->mcd_m68k_thread.released = cc_false;
+		thread->reclaimed((void*)thread->user_data);
+	}
+}
+
+void SyncMCDM68k(const ClownMDEmu* const clownmdemu, CPUCallbackUserData* const other_state, const CycleMegaCD target_cycle)
+{
+	/* The other thread has to be finished with the SUB-CPU before this one can touch it. */
+	ReclaimMCDM68k(clownmdemu, other_state);
+
+	RunMCDM68k(clownmdemu, other_state, target_cycle);
+
+	/* There is no point in letting the other thread run the SUB-CPU up to a point that it has already reached. */
+	other_state->mcd_m68k_thread.horizon = CC_MAX(other_state->mcd_m68k_thread.horizon, target_cycle.cycle);
+}
+
+/* Lets the frontend's other thread run the SUB-CPU for as long as it can without needing anything from the MAIN-CPU. */
+/* When there is no other thread, the SUB-CPU is run here instead: exactly where the SUB-CPU is synchronised
+   affects when some of its interrupts happen, so it must be the same either way for the results to match. */
+void ReleaseMCDM68k(const ClownMDEmu* const clownmdemu, CPUCallbackUserData* const other_state, const CycleMegaCD ending_cycle)
+{
+	const ClownMDEmu_SubCPUThread* const thread = clownmdemu->sub_cpu_thread;
+	const cc_u32f m68k_current_cycle = other_state->sync.m68k.current_cycle;
+
+	cc_u32f horizon;
+
+	/* When the SUB-CPU accesses the communication registers, it makes the MAIN-CPU catch up with it, which the other thread cannot do.
+	   The SUB-CPU is therefore only allowed to run up to the point where the MAIN-CPU would first need to catch up.
+	   Note that an instruction can begin on the target cycle itself, so it counts too. */
+	horizon = CC_MIN(ending_cycle.cycle, CycleMegaDriveToMegaCD(clownmdemu, MakeCycleMegaDrive(m68k_current_cycle)).cycle);
+
+	/* Converting between the two clocks is not exact, so make sure. */
+	while (horizon != 0 && CycleMegaCDToMegaDrive(clownmdemu, MakeCycleMegaCD(horizon)).cycle > m68k_current_cycle)
+		--horizon;
+
+	/* Handing the SUB-CPU over is not free, so wait until there is a decent amount of work for the other thread to do. */
+	if (horizon < other_state->mcd_m68k_thread.horizon + MCD_M68K_THREAD_QUANTUM)
+		return;
+
+	if (thread == NULL)
+	{
+		SyncMCDM68k(clownmdemu, other_state, MakeCycleMegaCD(horizon));
+		return;
+	}
+
+	/* The other thread is only ever given one stretch at a time, so that this thread is never more than one stretch behind it. */
+	ReclaimMCDM68k(clownmdemu, other_state);
+
+	other_state->mcd_m68k_thread.horizon = horizon;
+	other_state->mcd_m68k_thread.released = cc_true;
+	thread->released((void*)thread->user_data, other_state);
+}
+
+void SyncMCDM68kOnOtherThread(CPUCallbackUserData* const other_state)
+{
+	other_state->mcd_m68k_thread.on_other_thread = cc_true;
+	RunMCDM68k(other_state->clownmdemu, other_state, MakeCycleMegaCD(other_state->mcd_m68k_thread.horizon));
+	other_state->mcd_m68k_thread.on_other_thread = cc_false;
 }
 
 #define FILE_NAME_LENGTH 11
@@ -610,6 +965,15 @@ static cc_bool GetSaveFileSizeAny(const void* const user_data, cc_bool* const wr
 }
 
 #define BURAM_BLOCK_SIZE(WRITE_PROTECTED) ((WRITE_PROTECTED) ? 0x20 : 0x40)
+/* Save files are passed to and from the frontend in spans of this many bytes, rather than a byte at a time. */
+#define SAVE_FILE_SPAN_SIZE 0x400
+
+static void SyncMainM68k(const ClownMDEmu* const clownmdemu, CPUCallbackUserData* const other_state, const CycleMegaCD target_cycle)
+{
+	/* The other thread is never allowed to run the SUB-CPU past the MAIN-CPU, so there would be nothing to do here anyway. */
+	if (!other_state->mcd_m68k_thread.on_other_thread)
+		SyncM68k(clownmdemu, other_state, CycleMegaCDToMegaDrive(clownmdemu, target_cycle));
+}
 
 cc_u16f MCDM68kReadCallbackWithCycle(const void* const user_data, const cc_u32f address_word, const cc_bool do_high_byte, const cc_bool do_low_byte, const CycleMegaCD target_cycle)
 {
@@ -688,10 +1052,19 @@ cc_u16f MCDM68kReadCallbackWithCycle(const void* const user_data, const cc_u32f
 					else
 					{
 						cc_u32f total_bytes = 0;
-						cc_s16f value;
+						cc_u8l buffer[SAVE_FILE_SPAN_SIZE];
+						size_t bytes_read;
+
+						/* A short read means that the end of the file has been reached. */
+						do
+						{
+							size_t i;
 
-						while ((value = frontend_callbacks->save_file_read((void*)frontend_callbacks->user_data)) != -1)
-							MCDM68kWriteByte(user_data, clownmdemu->mcd_m68k->address_registers[1] + total_bytes++, value, target_cycle);
+							bytes_read = frontend_callbacks->save_file_read((void*)frontend_callbacks->user_data, buffer, sizeof(buffer));
+
+							for (i = 0; i < bytes_read; ++i)
+								MCDM68kWriteByte(user_data, clownmdemu->mcd_m68k->address_registers[1] + total_bytes++, buffer[i], target_cycle);
+						} while (bytes_read == sizeof(buffer));
 
 						frontend_callbacks->save_file_closed((void*)frontend_callbacks->user_data);
 
@@ -719,10 +1092,19 @@ cc_u16f MCDM68kReadCallbackWithCycle(const void* const user_data, const cc_u32f
 					{
 						const cc_u16f total_blocks = MCDM68kReadWord(user_data, clownmdemu->mcd_m68k->address_registers[0] + FILE_NAME_LENGTH + 1, target_cycle);
 						const cc_u32f total_bytes = (cc_u32f)total_blocks * BURAM_BLOCK_SIZE(write_protected);
+						cc_u8l buffer[SAVE_FILE_SPAN_SIZE];
 						cc_u32f i;
 
-						for (i = 0; i < total_bytes; ++i)
-							frontend_callbacks->save_file_written((void*)frontend_callbacks->user_data, MCDM68kReadByte(user_data, clownmdemu->mcd_m68k->address_registers[1] + i, target_cycle));
+						for (i = 0; i < total_bytes; i += sizeof(buffer))
+						{
+							const cc_u32f span_size = CC_MIN(sizeof(buffer), total_bytes - i);
+							cc_u32f j;
+
+							for (j = 0; j < span_size; ++j)
+								buffer[j] = MCDM68kReadByte(user_data, clownmdemu->mcd_m68k->address_registers[1] + i + j, target_cycle);
+
+							frontend_callbacks->save_file_written((void*)frontend_callbacks->user_data, buffer, span_size);
+						}
 
 						frontend_callbacks->save_file_closed((void*)frontend_callbacks->user_data);
 
@@ -766,21 +1148,30 @@ cc_u16f MCDM68kReadCallbackWithCycle(const void* const user_data, const cc_u32f
 						/* TODO: Signal an error if the file is longer than expected? */
 						const cc_u16f total_blocks = MCDM68kReadWord(user_data, clownmdemu->mcd_m68k->address_registers[0] + FILE_NAME_LENGTH + 1, target_cycle);
 						const cc_u32f total_bytes = (cc_u32f)total_blocks * BURAM_BLOCK_SIZE(write_protected);
+						cc_u8l buffer[SAVE_FILE_SPAN_SIZE];
 						cc_u32f i;
 
-						for (i = 0; i < total_bytes; ++i)
+						for (i = 0; i < total_bytes; i += sizeof(buffer))
 						{
-							const cc_u8f source_value = MCDM68kReadByte(user_data, clownmdemu->mcd_m68k->address_registers[1] + i, target_cycle);
-							const cc_s16f destination_value = frontend_callbacks->save_file_read((void*)frontend_callbacks->user_data);
+							const cc_u32f span_size = CC_MIN(sizeof(buffer), total_bytes - i);
+							cc_u32f j;
+
+							/* End of file encountered too early. */
+							if (frontend_callbacks->save_file_read((void*)frontend_callbacks->user_data, buffer, span_size) != span_size)
+								break;
 
-							/* End of file encountered too early, or mismatch. */
-							if (destination_value == -1 || (cc_u16f)destination_value != source_value)
+							for (j = 0; j < span_size; ++j)
+								if (buffer[j] != MCDM68kReadByte(user_data, clownmdemu->mcd_m68k->address_registers[1] + i + j, target_cycle))
+									break;
+
+							/* Mismatch. */
+							if (j != span_size)
 								break;
 						}
 
 						frontend_callbacks->save_file_closed((void*)frontend_callbacks->user_data);
 
-						if (i != total_bytes)
+						if (i < total_bytes)
 							clownmdemu->mcd_m68k->status_register |= 1; /* Error. */
 						else
 							clownmdemu->mcd_m68k->status_register &= ~1; /* Okay. */
@@ -805,38 +1196,40 @@ cc_u16f MCDM68kReadCallbackWithCycle(const void* const user_data, const cc_u32f
 		}
 		else
 		{
-			value = clownmdemu->state->mega_cd.prg_ram.buffer[address_word];
+			value = clownmdemu->mega_cd_state->prg_ram.buffer[address_word];
 		}
 	}
 	else if (address < 0xC0000)
 	{
 		/* WORD-RAM */
-		if (clownmdemu->state->mega_cd.word_ram.in_1m_mode)
+		if (clownmdemu->mega_cd_state->word_ram.in_1m_mode)
 		{
 			/* TODO. */
-			LogMessage("SUB-CPU attempted to read from the weird half of 1M WORD-RAM at 0x%" CC_PRIXLEAST32, clownmdemu->state->mega_cd.m68k.state.program_counter);
+			LogMessage("SUB-CPU attempted to read from the weird half of 1M WORD-RAM at 0x%" CC_PRIXLEAST32, clownmdemu->mega_cd_state->m68k.state.program_counter);
 		}
-		else if (!clownmdemu->state->mega_cd.word_ram.dmna)
+		else if (!clownmdemu->mega_cd_state->word_ram.dmna)
 		{
 			/* TODO: According to Page 24 of MEGA-CD HARDWARE MANUAL, this should cause the CPU to hang, just like the Z80 accessing the ROM during a DMA transfer. */
-			LogMessage("SUB-CPU attempted to read from WORD-RAM while MAIN-CPU has it at 0x%" CC_PRIXLEAST32, clownmdemu->state->mega_cd.m68k.state.program_counter);
+			LogMessage("SUB-CPU attempted to read from WORD-RAM while MAIN-CPU has it at 0x%" CC_PRIXLEAST32, clownmdemu->mega_cd_state->m68k.state.program_counter);
 		}
 		else
 		{
-			value = clownmdemu->state->mega_cd.word_ram.buffer[address_word % CC_COUNT_OF(clownmdemu->state->mega_cd.word_ram.buffer)];
+			/* The graphics operation draws into WORD-RAM, so bring it up to date. */
+			SyncGraphics(callback_user_data, target_cycle);
+			value = clownmdemu->mega_cd_state->word_ram.buffer[address_word % CC_COUNT_OF(clownmdemu->mega_cd_state->word_ram.buffer)];
 		}
 	}
 	else if (address < 0xE0000)
 	{
 		/* WORD-RAM */
-		if (!clownmdemu->state->mega_cd.word_ram.in_1m_mode)
+		if (!clownmdemu->mega_cd_state->word_ram.in_1m_mode)
 		{
 			/* TODO. */
-			LogMessage("SUB-CPU attempted to read from the 1M half of WORD-RAM in 2M mode at 0x%" CC_PRIXLEAST32, clownmdemu->state->mega_cd.m68k.state.program_counter);
+			LogMessage("SUB-CPU attempted to read from the 1M half of WORD-RAM in 2M mode at 0x%" CC_PRIXLEAST32, clownmdemu->mega_cd_state->m68k.state.program_counter);
 		}
 		else
 		{
-			value = clownmdemu->state->mega_cd.word_ram.buffer[(address_word * 2 + !clownmdemu->state->mega_cd.word_ram.ret) % CC_COUNT_OF(clownmdemu->state->mega_cd.word_ram.buffer)];
+			value = clownmdemu->mega_cd_state->word_ram.buffer[(address_word * 2 + !clownmdemu->mega_cd_state->word_ram.ret) % CC_COUNT_OF(clownmdemu->mega_cd_state->word_ram.buffer)];
 		}
 	}
 	else if (address >= 0xFF0000 && address < 0xFF8000)
@@ -864,12 +1257,12 @@ cc_u16f MCDM68kReadCallbackWithCycle(const void* const user_data, const cc_u32f
 	else if (address == 0xFF8002)
 	{
 		/* Memory mode / Write protect */
-		value = ((cc_u16f)clownmdemu->state->mega_cd.prg_ram.write_protect << 8) | ((cc_u16f)clownmdemu->state->mega_cd.word_ram.in_1m_mode << 2) | ((cc_u16f)clownmdemu->state->mega_cd.word_ram.dmna << 1) | ((cc_u16f)clownmdemu->state->mega_cd.word_ram.ret << 0);
+		value = ((cc_u16f)clownmdemu->mega_cd_state->prg_ram.write_protect << 8) | ((cc_u16f)clownmdemu->mega_cd_state->word_ram.in_1m_mode << 2) | ((cc_u16f)clownmdemu->mega_cd_state->word_ram.dmna << 1) | ((cc_u16f)clownmdemu->mega_cd_state->word_ram.ret << 0);
 	}
 	else if (address == 0xFF8004)
 	{
 		/* CDC mode / device destination */
-		value = CDC_Mode(&clownmdemu->state->mega_cd.cdc, cc_true);
+		value = CDC_Mode(&clownmdemu->mega_cd_state->cdc, cc_true);
 	}
 	else if (address == 0xFF8006)
 	{
@@ -879,7 +1272,7 @@ cc_u16f MCDM68kReadCallbackWithCycle(const void* const user_data, const cc_u32f
 	else if (address == 0xFF8008)
 	{
 		/* CDC host data */
-		value = CDC_HostData(&clownmdemu->state->mega_cd.cdc, cc_true);
+		value = CDC_HostData(&clownmdemu->mega_cd_state->cdc, cc_true);
 	}
 	else if (address == 0xFF800A)
 	{
@@ -894,20 +1287,20 @@ cc_u16f MCDM68kReadCallbackWithCycle(const void* const user_data, const cc_u32f
 	else if (address == 0xFF800E)
 	{
 		/* Communication flag */
-		SyncM68k(clownmdemu, callback_user_data, CycleMegaCDToMegaDrive(clownmdemu, target_cycle));
-		value = clownmdemu->state->mega_cd.communication.flag;
+		SyncMainM68k(clownmdemu, callback_user_data, target_cycle);
+		value = clownmdemu->mega_cd_state->communication.flag;
 	}
 	else if (address >= 0xFF8010 && address < 0xFF8020)
 	{
 		/* Communication command */
-		SyncM68k(clownmdemu, callback_user_data, CycleMegaCDToMegaDrive(clownmdemu, target_cycle));
-		value = clownmdemu->state->mega_cd.communication.command[(address - 0xFF8010) / 2];
+		SyncMainM68k(clownmdemu, callback_user_data, target_cycle);
+		value = clownmdemu->mega_cd_state->communication.command[(address - 0xFF8010) / 2];
 	}
 	else if (address >= 0xFF8020 && address < 0xFF8030)
 	{
 		/* Communication status */
-		SyncM68k(clownmdemu, callback_user_data, CycleMegaCDToMegaDrive(clownmdemu, target_cycle));
-		value = clownmdemu->state->mega_cd.communication.status[(address - 0xFF8020) / 2];
+		SyncMainM68k(clownmdemu, callback_user_data, target_cycle);
+		value = clownmdemu->mega_cd_state->communication.status[(address - 0xFF8020) / 2];
 	}
 	else if (address == 0xFF8030)
 	{
@@ -921,43 +1314,45 @@ cc_u16f MCDM68kReadCallbackWithCycle(const void* const user_data, const cc_u32f
 
 		value = 0;
 
-		for (i = 0; i < CC_COUNT_OF(clownmdemu->state->mega_cd.irq.enabled); ++i)
-			value |= (cc_u16f)clownmdemu->state->mega_cd.irq.enabled[i] << (1 + i);
+		for (i = 0; i < CC_COUNT_OF(clownmdemu->mega_cd_state->irq.enabled); ++i)
+			value |= (cc_u16f)clownmdemu->mega_cd_state->irq.enabled[i] << (1 + i);
 	}
 	else if (address == 0xFF8058)
 	{
 		/* Stamp data size */
-		value = clownmdemu->state->mega_cd.rotation.large_stamp_map << 2 | clownmdemu->state->mega_cd.rotation.large_stamp << 1 | clownmdemu->state->mega_cd.rotation.repeating_stamp_map << 0;
+		SyncGraphics(callback_user_data, target_cycle);
+		value = (clownmdemu->mega_cd_state->rotation.cycle_countdown != 0) << 15 | clownmdemu->mega_cd_state->rotation.large_stamp_map << 2 | clownmdemu->mega_cd_state->rotation.large_stamp << 1 | clownmdemu->mega_cd_state->rotation.repeating_stamp_map << 0;
 	}
 	else if (address == 0xFF805A)
 	{
 		/* Stamp map base address */
-		value = clownmdemu->state->mega_cd.rotation.stamp_map_address;
+		value = clownmdemu->mega_cd_state->rotation.stamp_map_address;
 	}
 	else if (address == 0xFF805C)
 	{
 		/* Image buffer vertical cell size */
-		value = clownmdemu->state->mega_cd.rotation.image_buffer_height_in_tiles;
+		value = clownmdemu->mega_cd_state->rotation.image_buffer_height_in_tiles;
 	}
 	else if (address == 0xFF805E)
 	{
 		/* Image buffer base address */
-		value = clownmdemu->state->mega_cd.rotation.image_buffer_address;
+		value = clownmdemu->mega_cd_state->rotation.image_buffer_address;
 	}
 	else if (address == 0xFF8060)
 	{
 		/* Image buffer offset */
-		value = clownmdemu->state->mega_cd.rotation.image_buffer_y_offset << 3 | clownmdemu->state->mega_cd.rotation.image_buffer_x_offset << 0;
+		value = clownmdemu->mega_cd_state->rotation.image_buffer_y_offset << 3 | clownmdemu->mega_cd_state->rotation.image_buffer_x_offset << 0;
 	}
 	else if (address == 0xFF8062)
 	{
 		/* Image buffer width */
-		value = clownmdemu->state->mega_cd.rotation.image_buffer_width;
+		value = clownmdemu->mega_cd_state->rotation.image_buffer_width;
 	}
 	else if (address == 0xFF8064)
 	{
 		/* Image buffer height */
-		value = clownmdemu->state->mega_cd.rotation.image_buffer_height;
+		SyncGraphics(callback_user_data, target_cycle);
+		value = clownmdemu->mega_cd_state->rotation.image_buffer_height;
 	}
 	else if (address == 0xFF8066)
 	{
@@ -972,11 +1367,30 @@ cc_u16f MCDM68kReadCallbackWithCycle(const void* const user_data, const cc_u32f
 	return value;
 }
 
+/* Whether reading this address can only produce a different value if the SUB-CPU writes to it, or if the MAIN-CPU does. */
+static cc_bool IsIdleLoopSafeRead(const ClownMDEmu_MegaCDState* const state, const cc_u32f address)
+{
+	if (address < 0x80000)
+		return address != 0x5F16 && address != 0x5F22; /* Do not get in the way of the BIOS calls. */
+	else if (address < 0xE0000)
+		return state->rotation.cycle_countdown == 0;
+	else
+		return address == 0xFF8000 || address == 0xFF8002 || (address >= 0xFF800E && address < 0xFF8030);
+}
+
 cc_u16f MCDM68kReadCallback(const void* const user_data, const cc_u32f address, const cc_bool do_high_byte, const cc_bool do_low_byte)
 {
 	CPUCallbackUserData* const callback_user_data = (CPUCallbackUserData*)user_data;
+	/* The MAIN-CPU belongs to the other thread while this one is running the SUB-CPU, and it never catches up anyway. */
+	const cc_bool main_cpu_may_be_behind = !callback_user_data->mcd_m68k_thread.on_other_thread;
+	const cc_u32f m68k_current_cycle = main_cpu_may_be_behind ? callback_user_data->sync.m68k.current_cycle : 0;
+	const cc_u16f value = MCDM68kReadCallbackWithCycle(user_data, address, do_high_byte, do_low_byte, MakeCycleMegaCD(callback_user_data->sync.mcd_m68k.current_cycle));
 
-	return MCDM68kReadCallbackWithCycle(user_data, address, do_high_byte, do_low_byte, MakeCycleMegaCD(callback_user_data->sync.mcd_m68k.current_cycle));
+	/* Reading the communication registers can make the MAIN-CPU catch up, and who knows what it will do then. */
+	if (!IsIdleLoopSafeRead(callback_user_data->clownmdemu->mega_cd_state, address * 2) || (main_cpu_may_be_behind && callback_user_data->sync.m68k.current_cycle != m68k_current_cycle))
+		callback_user_data->mcd_m68k_idle.disturbed = cc_true;
+
+	return value;
 }
 
 void MCDM68kWriteCallbackWithCycle(const void* const user_data, const cc_u32f address_word, const cc_bool do_high_byte, const cc_bool do_low_byte, const cc_u16f value, const CycleMegaCD target_cycle)
@@ -998,46 +1412,48 @@ void MCDM68kWriteCallbackWithCycle(const void* const user_data, const cc_u32f ad
 	if (/*address >= 0 &&*/ address < 0x80000)
 	{
 		/* PRG-RAM */
-		if (address < (cc_u32f)clownmdemu->state->mega_cd.prg_ram.write_protect * 0x200)
+		if (address < (cc_u32f)clownmdemu->mega_cd_state->prg_ram.write_protect * 0x200)
 		{
-			LogMessage("MAIN-CPU attempted to write to write-protected portion of PRG-RAM (0x%" CC_PRIXFAST32 ") at 0x%" CC_PRIXLEAST32, address, clownmdemu->state->mega_cd.m68k.state.program_counter);
+			LogMessage("MAIN-CPU attempted to write to write-protected portion of PRG-RAM (0x%" CC_PRIXFAST32 ") at 0x%" CC_PRIXLEAST32, address, clownmdemu->mega_cd_state->m68k.state.program_counter);
 		}
 		else
 		{
-			clownmdemu->state->mega_cd.prg_ram.buffer[address_word] &= ~mask;
-			clownmdemu->state->mega_cd.prg_ram.buffer[address_word] |= value & mask;
+			clownmdemu->mega_cd_state->prg_ram.buffer[address_word] &= ~mask;
+			clownmdemu->mega_cd_state->prg_ram.buffer[address_word] |= value & mask;
 		}
 	}
 	else if (address < 0xC0000)
 	{
 		/* WORD-RAM */
-		if (clownmdemu->state->mega_cd.word_ram.in_1m_mode)
+		if (clownmdemu->mega_cd_state->word_ram.in_1m_mode)
 		{
 			/* TODO. */
-			LogMessage("SUB-CPU attempted to write to the weird half of 1M WORD-RAM at 0x%" CC_PRIXLEAST32, clownmdemu->state->mega_cd.m68k.state.program_counter);
+			LogMessage("SUB-CPU attempted to write to the weird half of 1M WORD-RAM at 0x%" CC_PRIXLEAST32, clownmdemu->mega_cd_state->m68k.state.program_counter);
 		}
-		else if (!clownmdemu->state->mega_cd.word_ram.dmna)
+		else if (!clownmdemu->mega_cd_state->word_ram.dmna)
 		{
-			LogMessage("SUB-CPU attempted to write to WORD-RAM while MAIN-CPU has it at 0x%" CC_PRIXLEAST32, clownmdemu->state->mega_cd.m68k.state.program_counter);
+			LogMessage("SUB-CPU attempted to write to WORD-RAM while MAIN-CPU has it at 0x%" CC_PRIXLEAST32, clownmdemu->mega_cd_state->m68k.state.program_counter);
 		}
 		else
 		{
-			clownmdemu->state->mega_cd.word_ram.buffer[address_word & 0x1FFFF] &= ~mask;
-			clownmdemu->state->mega_cd.word_ram.buffer[address_word & 0x1FFFF] |= value & mask;
+			SyncGraphics(callback_user_data, target_cycle);
+			clownmdemu->mega_cd_state->word_ram.buffer[address_word & 0x1FFFF] &= ~mask;
+			clownmdemu->mega_cd_state->word_ram.buffer[address_word & 0x1FFFF] |= value & mask;
 		}
 	}
 	else if (address < 0xE0000)
 	{
 		/* WORD-RAM */
-		if (!clownmdemu->state->mega_cd.word_ram.in_1m_mode)
+		if (!clownmdemu->mega_cd_state->word_ram.in_1m_mode)
 		{
 			/* TODO. */
-			LogMessage("SUB-CPU attempted to write to the 1M half of WORD-RAM in 2M mode at 0x%" CC_PRIXLEAST32, clownmdemu->state->mega_cd.m68k.state.program_counter);
+			LogMessage("SUB-CPU attempted to write to the 1M half of WORD-RAM in 2M mode at 0x%" CC_PRIXLEAST32, clownmdemu->mega_cd_state->m68k.state.program_counter);
 		}
 		else
 		{
-			clownmdemu->state->mega_cd.word_ram.buffer[(address_word & 0xFFFF) * 2 + !clownmdemu->state->mega_cd.word_ram.ret] &= ~mask;
-			clownmdemu->state->mega_cd.word_ram.buffer[(address_word & 0xFFFF) * 2 + !clownmdemu->state->mega_cd.word_ram.ret] |= value & mask;
+			SyncGraphics(callback_user_data, target_cycle);
+			clownmdemu->mega_cd_state->word_ram.buffer[(address_word & 0xFFFF) * 2 + !clownmdemu->mega_cd_state->word_ram.ret] &= ~mask;
+			clownmdemu->mega_cd_state->word_ram.buffer[(address_word & 0xFFFF) * 2 + !clownmdemu->mega_cd_state->word_ram.ret] |= value & mask;
 		}
 	}
 	else if (address >= 0xFF0000 && address < 0xFF8000)
@@ -1067,21 +1483,22 @@ void MCDM68kWriteCallbackWithCycle(const void* const user_data, const cc_u32f ad
 		{
 			const cc_bool ret = (value & (1 << 0)) != 0;
 
-			SyncM68k(clownmdemu, callback_user_data, CycleMegaCDToMegaDrive(clownmdemu, target_cycle));
+			SyncMainM68k(clownmdemu, callback_user_data, target_cycle);
+			SyncGraphics(callback_user_data, target_cycle);
 
-			clownmdemu->state->mega_cd.word_ram.in_1m_mode = (value & (1 << 2)) != 0;
+			clownmdemu->mega_cd_state->word_ram.in_1m_mode = (value & (1 << 2)) != 0;
 
-			if (ret || clownmdemu->state->mega_cd.word_ram.in_1m_mode)
+			if (ret || clownmdemu->mega_cd_state->word_ram.in_1m_mode)
 			{
-				clownmdemu->state->mega_cd.word_ram.dmna = cc_false;
-				clownmdemu->state->mega_cd.word_ram.ret = ret;
+				clownmdemu->mega_cd_state->word_ram.dmna = cc_false;
+				clownmdemu->mega_cd_state->word_ram.ret = ret;
 			}
 		}
 	}
 	else if (address == 0xFF8004)
 	{
 		/* CDC mode / device destination */
-		CDC_SetDeviceDestination(&clownmdemu->state->mega_cd.cdc, high_byte & 7);
+		CDC_SetDeviceDestination(&clownmdemu->mega_cd_state->cdc, high_byte & 7);
 	}
 	else if (address == 0xFF8006)
 	{
@@ -1096,7 +1513,7 @@ void MCDM68kWriteCallbackWithCycle(const void* const user_data, const cc_u32f ad
 	else if (address == 0xFF800A)
 	{
 		/* CDC DMA address */
-		CDC_SetDMAAddress(&clownmdemu->state->mega_cd.cdc, value);
+		CDC_SetDMAAddress(&clownmdemu->mega_cd_state->cdc, value);
 	}
 	else if (address == 0xFF800C)
 	{
@@ -1111,8 +1528,8 @@ void MCDM68kWriteCallbackWithCycle(const void* const user_data, const cc_u32f ad
 
 		if (do_low_byte)
 		{
-			SyncM68k(clownmdemu, callback_user_data, CycleMegaCDToMegaDrive(clownmdemu, target_cycle));
-			clownmdemu->state->mega_cd.communication.flag = (clownmdemu->state->mega_cd.communication.flag & 0xFF00) | (value & 0x00FF);
+			SyncMainM68k(clownmdemu, callback_user_data, target_cycle);
+			clownmdemu->mega_cd_state->communication.flag = (clownmdemu->mega_cd_state->communication.flag & 0xFF00) | (value & 0x00FF);
 		}
 	}
 	else if (address >= 0xFF8010 && address < 0xFF8020)
@@ -1123,16 +1540,16 @@ void MCDM68kWriteCallbackWithCycle(const void* const user_data, const cc_u32f ad
 	else if (address >= 0xFF8020 && address < 0xFF8030)
 	{
 		/* Communication status */
-		SyncM68k(clownmdemu, callback_user_data, CycleMegaCDToMegaDrive(clownmdemu, target_cycle));
-		clownmdemu->state->mega_cd.communication.status[(address - 0xFF8020) / 2] &= ~mask;
-		clownmdemu->state->mega_cd.communication.status[(address - 0xFF8020) / 2] |= value & mask;
+		SyncMainM68k(clownmdemu, callback_user_data, target_cycle);
+		clownmdemu->mega_cd_state->communication.status[(address - 0xFF8020) / 2] &= ~mask;
+		clownmdemu->mega_cd_state->communication.status[(address - 0xFF8020) / 2] |= value & mask;
 	}
 	else if (address == 0xFF8030)
 	{
 		if (do_low_byte) /* TODO: Does setting just the upper byte cause this to be updated anyway? */
 		{
 			/* Timer W/INT3 */
-			clownmdemu->state->mega_cd.irq.irq3_countdown_master = clownmdemu->state->mega_cd.irq.irq3_countdown = low_byte == 0 ? 0 : (low_byte + 1) * CLOWNMDEMU_MCD_M68K_CLOCK_DIVIDER * CLOWNMDEMU_PCM_SAMPLE_RATE_DIVIDER;
+			clownmdemu->mega_cd_state->irq.irq3_countdown_master = clownmdemu->mega_cd_state->irq.irq3_countdown = low_byte == 0 ? 0 : (low_byte + 1) * CLOWNMDEMU_MCD_M68K_CLOCK_DIVIDER * CLOWNMDEMU_PCM_SAMPLE_RATE_DIVIDER;
 		}
 	}
 	else if (address == 0xFF8032)
@@ -1142,104 +1559,60 @@ void MCDM68kWriteCallbackWithCycle(const void* const user_data, const cc_u32f ad
 		{
 			cc_u8f i;
 
-			for (i = 0; i < CC_COUNT_OF(clownmdemu->state->mega_cd.irq.enabled); ++i)
-				clownmdemu->state->mega_cd.irq.enabled[i] = (value & (1 << (1 + i))) != 0;
-
-			if (!clownmdemu->state->mega_cd.irq.enabled[0])
-				clownmdemu->state->mega_cd.irq.irq1_pending = cc_false;
+			for (i = 0; i < CC_COUNT_OF(clownmdemu->mega_cd_state->irq.enabled); ++i)
+				clownmdemu->mega_cd_state->irq.enabled[i] = (value & (1 << (1 + i))) != 0;
 		}
 	}
-	else if (address == 0xFF8058)
+	else if (address >= 0xFF8058 && address < 0xFF8066)
 	{
-		/* Stamp data size */
-		clownmdemu->state->mega_cd.rotation.large_stamp_map = (value & (1 << 2)) != 0;
-		clownmdemu->state->mega_cd.rotation.large_stamp = (value & (1 << 1)) != 0;
-		clownmdemu->state->mega_cd.rotation.repeating_stamp_map = (value & (1 << 0)) != 0;
-	}
-	else if (address == 0xFF805A)
-	{
-		/* Stamp map base address */
-		clownmdemu->state->mega_cd.rotation.stamp_map_address = value;
-	}
-	else if (address == 0xFF805C)
-	{
-		/* Image buffer vertical cell size */
-		clownmdemu->state->mega_cd.rotation.image_buffer_height_in_tiles = value;
-	}
-	else if (address == 0xFF805E)
-	{
-		/* Image buffer base address */
-		clownmdemu->state->mega_cd.rotation.image_buffer_address = value;
-	}
-	else if (address == 0xFF8060)
-	{
-		/* Image buffer offset */
-		clownmdemu->state->mega_cd.rotation.image_buffer_y_offset = value >> 3 & 7;
-		clownmdemu->state->mega_cd.rotation.image_buffer_x_offset = value >> 0 & 7;
-	}
-	else if (address == 0xFF8062)
-	{
-		/* Image buffer width */
-		clownmdemu->state->mega_cd.rotation.image_buffer_width = value;
-	}
-	else if (address == 0xFF8064)
-	{
-		/* Image buffer height */
-		/* TODO: Are the upper bits discarded or just left unused? */
-		clownmdemu->state->mega_cd.rotation.image_buffer_height = value;
+		/* Any lines that are already due must be drawn with the old settings. */
+		SyncGraphics(callback_user_data, target_cycle);
+
+		if (address == 0xFF8058)
+		{
+			/* Stamp data size */
+			clownmdemu->mega_cd_state->rotation.large_stamp_map = (value & (1 << 2)) != 0;
+			clownmdemu->mega_cd_state->rotation.large_stamp = (value & (1 << 1)) != 0;
+			clownmdemu->mega_cd_state->rotation.repeating_stamp_map = (value & (1 << 0)) != 0;
+		}
+		else if (address == 0xFF805A)
+		{
+			/* Stamp map base address */
+			clownmdemu->mega_cd_state->rotation.stamp_map_address = value;
+		}
+		else if (address == 0xFF805C)
+		{
+			/* Image buffer vertical cell size */
+			clownmdemu->mega_cd_state->rotation.image_buffer_height_in_tiles = value;
+		}
+		else if (address == 0xFF805E)
+		{
+			/* Image buffer base address */
+			clownmdemu->mega_cd_state->rotation.image_buffer_address = value;
+		}
+		else if (address == 0xFF8060)
+		{
+			/* Image buffer offset */
+			clownmdemu->mega_cd_state->rotation.image_buffer_y_offset = value >> 3 & 7;
+			clownmdemu->mega_cd_state->rotation.image_buffer_x_offset = value >> 0 & 7;
+		}
+		else if (address == 0xFF8062)
+		{
+			/* Image buffer width */
+			clownmdemu->mega_cd_state->rotation.image_buffer_width = value & 0x1FF;
+		}
+		else if (address == 0xFF8064)
+		{
+			/* Image buffer height */
+			/* TODO: Are the upper bits discarded or just left unused? */
+			clownmdemu->mega_cd_state->rotation.image_buffer_height = value;
+		}
 	}
 	else if (address == 0xFF8066)
 	{
 		/* Trace table address */
-		cc_u8f pixel_y_in_image_buffer;
-		/* TODO: Correctly mask the address! */
-		const cc_u16l *trace_table = &clownmdemu->state->mega_cd.word_ram.buffer[value * 2];
-		const cc_u8f fraction_shift = 11;
-		/* TODO: Does this actually offset the destination instead of the source? */
-		const cc_u32f x_offset = -(cc_u32f)clownmdemu->state->mega_cd.rotation.image_buffer_x_offset << fraction_shift;
-		const cc_u32f y_offset = -(cc_u32f)clownmdemu->state->mega_cd.rotation.image_buffer_y_offset << fraction_shift;
-
-		/* TODO: Correctly mask the address! */
-		cc_u16l* const image_buffer = &clownmdemu->state->mega_cd.word_ram.buffer[clownmdemu->state->mega_cd.rotation.image_buffer_address * 2];
-		/* TODO: Rename 'image_buffer_height_in_tiles' to 'image_buffer_height_in_tiles_minus_one'. */
-		const cc_u16f image_buffer_height_in_pixels = (clownmdemu->state->mega_cd.rotation.image_buffer_height_in_tiles + 1) * STAMP_TILE_DIAMETER_IN_PIXELS;
-
-		for (pixel_y_in_image_buffer = 0; pixel_y_in_image_buffer < clownmdemu->state->mega_cd.rotation.image_buffer_height; ++pixel_y_in_image_buffer)
-		{
-			cc_u16f pixel_x_in_image_buffer;
-			cc_u32f sample_x = x_offset + (CC_SIGN_EXTEND(cc_u32f, 15, trace_table[0]) << (fraction_shift - 3));
-			cc_u32f sample_y = y_offset + (CC_SIGN_EXTEND(cc_u32f, 15, trace_table[1]) << (fraction_shift - 3));
-			const cc_u32f delta_x = CC_SIGN_EXTEND(cc_u32f, 15, trace_table[2]);
-			const cc_u32f delta_y = CC_SIGN_EXTEND(cc_u32f, 15, trace_table[3]);
-			trace_table += 4;
-
-			for (pixel_x_in_image_buffer = 0; pixel_x_in_image_buffer < clownmdemu->state->mega_cd.rotation.image_buffer_width; ++pixel_x_in_image_buffer)
-			{
-				const cc_u32f pixel_x = sample_x >> fraction_shift;
-				const cc_u32f pixel_y = sample_y >> fraction_shift;
-				const cc_u8f pixel = ReadPixelFromStampMap(clownmdemu->state, pixel_x, pixel_y);
-
-				/* TODO: Priority mode! */
-				const cc_u32f pixel_index_within_image_buffer = PixelIndexFromImageBufferCoordinate(pixel_x_in_image_buffer, pixel_y_in_image_buffer, image_buffer_height_in_pixels);
-
-				const cc_u32f word_index_within_image_buffer = pixel_index_within_image_buffer / PIXELS_PER_WORD;
-				const cc_u8f pixel_index_within_word = pixel_index_within_image_buffer % PIXELS_PER_WORD;
-
-				cc_u16l* const word = &image_buffer[word_index_within_image_buffer];
-
-				WritePixelToWord(word, pixel_index_within_word, pixel);
-
-				sample_x += delta_x;
-				sample_y += delta_y;
-			}
-		}
-
-		/* The graphics operation decrements this until it reaches 0. Sonic CD relies on this to load its special stages. */
-		clownmdemu->state->mega_cd.rotation.image_buffer_height = 0;
-
-		/* Fire the 'graphics operation complete' interrupt. */
-		if (clownmdemu->state->mega_cd.irq.enabled[0])
-			clownmdemu->state->mega_cd.irq.irq1_pending = cc_true;
+		/* The graphics operation is drawn a line at a time, as the emulated time passes. */
+		StartGraphics(callback_user_data, value, target_cycle);
 	}
 	else
 	{
@@ -1251,5 +1624,7 @@ void MCDM68kWriteCallback(const void* const user_data, const cc_u32f address, co
 {
 	CPUCallbackUserData* const callback_user_data = (CPUCallbackUserData*)user_data;
 
+	callback_user_data->mcd_m68k_idle.disturbed = cc_true;
+
 	MCDM68kWriteCallbackWithCycle(user_data, address, do_high_byte, do_low_byte, value, MakeCycleMegaCD(callback_user_data->sync.mcd_m68k.current_cycle));
 }
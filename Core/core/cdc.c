@@ -1,5 +1,7 @@
 #include "core/cdc.h"
 
+#include <stddef.h>
+
 #include "core/log.h"
 
 #define CDC_END(CDC) CC_COUNT_OF((CDC)->buffered_sectors[0])
@@ -176,6 +178,24 @@ cc_u16f CDC_HostData(CDC* const cdc, const cc_bool is_sub_cpu)
 	return value;
 }
 
+cc_u16f CDC_HostDataSpan(CDC* const cdc, const cc_bool is_sub_cpu, const cc_u16l** const words)
+{
+	cc_u16f total_words;
+
+	if (is_sub_cpu != cdc->host_data_target_sub_cpu || !cdc->host_data_bound || !DataSetReady(cdc))
+	{
+		*words = NULL;
+		return 0;
+	}
+
+	*words = &cdc->buffered_sectors[cdc->host_data_buffered_sector_index][cdc->host_data_word_index];
+	total_words = CDC_END(cdc) - cdc->host_data_word_index;
+
+	cdc->host_data_word_index = CDC_END(cdc);
+
+	return total_words;
+}
+
 void CDC_Ack(CDC* const cdc)
 {
 	if (!cdc->host_data_bound)
@@ -2241,6 +2241,9 @@ cc_u8f Clown68000_DoCycle(Clown68000_State *state, const Clown68000_ReadWriteCal
 	stuff.state = state;
 	stuff.callbacks = callbacks;
 	stuff.cycles_left_in_instruction = 4;
+	/* Some instructions, such as ADDQ, have no source operand to decode, yet their duration is still worked out from it,
+	   so it must not be left to whatever happens to be on the stack. */
+	stuff.source_decoded_address_mode.type = DECODED_ADDRESS_MODE_TYPE_REGISTER;
 
 	if (!state->halted)
 	{
@@ -1,6 +1,7 @@
 #include "core/clownmdemu.h"
 
 #include <assert.h>
+#include <math.h>
 #include <stddef.h>
 #include <string.h>
 
@@ -85,66 +86,76 @@ void ClownMDEmu_State_Initialise(ClownMDEmu_State* const state)
 	state->external_ram.data_size = 0;
 	state->external_ram.device_type = 0;
 	state->external_ram.mapped_in = cc_false;
+	state->external_ram.dirty_start = CC_COUNT_OF(state->external_ram.buffer);
+	state->external_ram.dirty_end = 0;
 
 	for (i = 0; i < CC_COUNT_OF(state->cartridge_bankswitch); ++i)
 		state->cartridge_bankswitch[i] = i;
 
-	/* Mega CD */
-	state->mega_cd.m68k.cycle_countdown = 1;
-	state->mega_cd.m68k.bus_requested = cc_true;
-	state->mega_cd.m68k.reset_held = cc_true;
+	state->boot_from_cd = cc_false;
 
-	state->mega_cd.prg_ram.bank = 0;
+	/* Low-pass filters. */
+	LowPassFilter_FirstOrder_Initialise(state->low_pass_filters.fm, CC_COUNT_OF(state->low_pass_filters.fm));
+	LowPassFilter_FirstOrder_Initialise(state->low_pass_filters.psg, CC_COUNT_OF(state->low_pass_filters.psg));
+	LowPassFilter_SecondOrder_Initialise(state->low_pass_filters.pcm, CC_COUNT_OF(state->low_pass_filters.pcm));
+}
 
-	state->mega_cd.word_ram.in_1m_mode = cc_false;
+void ClownMDEmu_MegaCDState_Initialise(ClownMDEmu_MegaCDState* const state)
+{
+	cc_u16f i;
+
+	state->m68k.cycle_countdown = 1;
+	state->m68k.bus_requested = cc_true;
+	state->m68k.reset_held = cc_true;
+
+	state->prg_ram.bank = 0;
+
+	state->word_ram.in_1m_mode = cc_false;
 	/* Page 24 of MEGA-CD HARDWARE MANUAL confirms this. */
-	state->mega_cd.word_ram.dmna = cc_false;
-	state->mega_cd.word_ram.ret = cc_true;
+	state->word_ram.dmna = cc_false;
+	state->word_ram.ret = cc_true;
 
-	state->mega_cd.communication.flag = 0;
+	state->communication.flag = 0;
 
-	for (i = 0; i < CC_COUNT_OF(state->mega_cd.communication.command); ++i)
-		state->mega_cd.communication.command[i] = 0;
+	for (i = 0; i < CC_COUNT_OF(state->communication.command); ++i)
+		state->communication.command[i] = 0;
 
-	for (i = 0; i < CC_COUNT_OF(state->mega_cd.communication.status); ++i)
-		state->mega_cd.communication.status[i] = 0;
+	for (i = 0; i < CC_COUNT_OF(state->communication.status); ++i)
+		state->communication.status[i] = 0;
 	
-	for (i = 0; i < CC_COUNT_OF(state->mega_cd.irq.enabled); ++i)
-		state->mega_cd.irq.enabled[i] = cc_false;
-
-	state->mega_cd.irq.irq1_pending = cc_false;
-	state->mega_cd.irq.irq3_countdown_master = state->mega_cd.irq.irq3_countdown = 0;
-
-	state->mega_cd.rotation.large_stamp_map = cc_false;
-	state->mega_cd.rotation.large_stamp = cc_false;
-	state->mega_cd.rotation.repeating_stamp_map = cc_false;
-	state->mega_cd.rotation.stamp_map_address = 0;
-	state->mega_cd.rotation.image_buffer_address = 0;
-	state->mega_cd.rotation.image_buffer_width = 0;
-	state->mega_cd.rotation.image_buffer_height = 0;
-	state->mega_cd.rotation.image_buffer_height_in_tiles = 0;
-	state->mega_cd.rotation.image_buffer_x_offset = 0;
-	state->mega_cd.rotation.image_buffer_y_offset = 0;
-
-	CDC_Initialise(&state->mega_cd.cdc);
-	CDDA_Initialise(&state->mega_cd.cdda);
-	PCM_State_Initialise(&state->mega_cd.pcm);
-
-	state->mega_cd.boot_from_cd = cc_false;
-	state->mega_cd.hblank_address = 0xFFFF;
-	state->mega_cd.delayed_dma_word = 0;
-
-	/* Low-pass filters. */
-	LowPassFilter_FirstOrder_Initialise(state->low_pass_filters.fm, CC_COUNT_OF(state->low_pass_filters.fm));
-	LowPassFilter_FirstOrder_Initialise(state->low_pass_filters.psg, CC_COUNT_OF(state->low_pass_filters.psg));
-	LowPassFilter_SecondOrder_Initialise(state->low_pass_filters.pcm, CC_COUNT_OF(state->low_pass_filters.pcm));
+	for (i = 0; i < CC_COUNT_OF(state->irq.enabled); ++i)
+		state->irq.enabled[i] = cc_false;
+
+	state->irq.irq3_countdown_master = state->irq.irq3_countdown = 0;
+
+	state->rotation.large_stamp_map = cc_false;
+	state->rotation.large_stamp = cc_false;
+	state->rotation.repeating_stamp_map = cc_false;
+	state->rotation.stamp_map_address = 0;
+	state->rotation.image_buffer_address = 0;
+	state->rotation.image_buffer_width = 0;
+	state->rotation.image_buffer_height = 0;
+	state->rotation.image_buffer_height_in_tiles = 0;
+	state->rotation.image_buffer_x_offset = 0;
+	state->rotation.image_buffer_y_offset = 0;
+	state->rotation.trace_table_address = 0;
+	state->rotation.image_buffer_line = 0;
+	state->rotation.cycle_countdown = 0;
+
+	CDC_Initialise(&state->cdc);
+	CDDA_Initialise(&state->cdda);
+	PCM_State_Initialise(&state->pcm);
+
+	state->hblank_address = 0xFFFF;
+	state->delayed_dma_word = 0;
 }
 
-void ClownMDEmu_Parameters_Initialise(ClownMDEmu* const clownmdemu, const ClownMDEmu_Configuration* const configuration, const ClownMDEmu_Constant* const constant, ClownMDEmu_State* const state, const ClownMDEmu_Callbacks* const callbacks)
+void ClownMDEmu_Parameters_Initialise(ClownMDEmu* const clownmdemu, const ClownMDEmu_Configuration* const configuration, const ClownMDEmu_Constant* const constant, ClownMDEmu_State* const state, ClownMDEmu_MegaCDState* const mega_cd_state, const ClownMDEmu_Callbacks* const callbacks)
 {
 	clownmdemu->configuration = configuration;
 	clownmdemu->constant = constant;
 	clownmdemu->state = state;
+	clownmdemu->mega_cd_state = mega_cd_state;
 	clownmdemu->callbacks = callbacks;
 
 	clownmdemu->m68k = &state->m68k.state;
@@ -152,7 +163,7 @@ void ClownMDEmu_Parameters_Initialise(ClownMDEmu* const clownmdemu, const ClownM
 	clownmdemu->z80.constant = &constant->z80;
 	clownmdemu->z80.state = &state->z80.state;
 
-	clownmdemu->mcd_m68k = &state->mega_cd.m68k.state;
+	clownmdemu->mcd_m68k = mega_cd_state == NULL ? NULL : &mega_cd_state->m68k.state;
 
 	clownmdemu->vdp.configuration = &configuration->vdp;
 	clownmdemu->vdp.constant = &constant->vdp;
@@ -165,7 +176,11 @@ void ClownMDEmu_Parameters_Initialise(ClownMDEmu* const clownmdemu, const ClownM
 	clownmdemu->psg.state = &state->psg;
 
 	clownmdemu->pcm.configuration = &configuration->pcm;
-	clownmdemu->pcm.state = &state->mega_cd.pcm;
+	clownmdemu->pcm.state = mega_cd_state == NULL ? NULL : &mega_cd_state->pcm;
+
+	clownmdemu->psg_log = NULL;
+	clownmdemu->sub_cpu_idle_statistics = NULL;
+	clownmdemu->sub_cpu_thread = NULL;
 }
 
 /* Very useful H-Counter/V-Counter information:
@@ -231,14 +246,34 @@ void ClownMDEmu_Iterate(const ClownMDEmu* const clownmdemu)
 	cpu_callback_user_data.sync.z80.current_cycle = 0;
 	cpu_callback_user_data.sync.z80.cycle_countdown = &state->z80.cycle_countdown;
 	cpu_callback_user_data.sync.mcd_m68k.current_cycle = 0;
-	cpu_callback_user_data.sync.mcd_m68k.cycle_countdown = &state->mega_cd.m68k.cycle_countdown;
 	cpu_callback_user_data.sync.mcd_m68k_irq3.current_cycle = 0;
-	cpu_callback_user_data.sync.mcd_m68k_irq3.cycle_countdown = &state->mega_cd.irq.irq3_countdown;
+	cpu_callback_user_data.sync.mcd_graphics.current_cycle = 0;
+	if (MEGA_CD_ATTACHED(clownmdemu))
+	{
+		cpu_callback_user_data.sync.mcd_m68k.cycle_countdown = &clownmdemu->mega_cd_state->m68k.cycle_countdown;
+		cpu_callback_user_data.sync.mcd_m68k_irq3.cycle_countdown = &clownmdemu->mega_cd_state->irq.irq3_countdown;
+		cpu_callback_user_data.sync.mcd_graphics.cycle_countdown = &clownmdemu->mega_cd_state->rotation.cycle_countdown;
+	}
 	cpu_callback_user_data.sync.fm.current_cycle = 0;
 	cpu_callback_user_data.sync.psg.current_cycle = 0;
 	cpu_callback_user_data.sync.pcm.current_cycle = 0;
 	for (i = 0; i < CC_COUNT_OF(cpu_callback_user_data.sync.io_ports); ++i)
 		cpu_callback_user_data.sync.io_ports[i].current_cycle = 0;
+	cpu_callback_user_data.mcd_m68k_idle.target_cycle = 0;
+	cpu_callback_user_data.mcd_m68k_idle.monitoring = cc_false;
+	cpu_callback_user_data.mcd_m68k_thread.horizon = 0;
+	cpu_callback_user_data.mcd_m68k_thread.released = cc_false;
+	cpu_callback_user_data.mcd_m68k_thread.on_other_thread = cc_false;
+
+	if (clownmdemu->psg_log != NULL)
+		clownmdemu->psg_log->total_writes = 0;
+
+	if (clownmdemu->sub_cpu_idle_statistics != NULL)
+	{
+		clownmdemu->sub_cpu_idle_statistics->polls = 0;
+		clownmdemu->sub_cpu_idle_statistics->polls_skipped = 0;
+		clownmdemu->sub_cpu_idle_statistics->cycles_skipped = 0;
+	}
 
 	/* Reload H-Int counter at the top of the screen, just like real hardware does */
 	h_int_counter = state->vdp.h_int_interval;
@@ -253,6 +288,8 @@ void ClownMDEmu_Iterate(const ClownMDEmu* const clownmdemu)
 
 		/* Sync the 68k, since it's the one thing that can influence the VDP */
 		SyncM68k(clownmdemu, &cpu_callback_user_data, current_cycle_minus_horizontal_sync);
+		if (MEGA_CD_ATTACHED(clownmdemu))
+			ReleaseMCDM68k(clownmdemu, &cpu_callback_user_data, cycles_per_frame_mega_cd);
 
 		if (scanline < console_vertical_resolution)
 		{
@@ -278,6 +315,8 @@ void ClownMDEmu_Iterate(const ClownMDEmu* const clownmdemu)
 		}
 
 		SyncM68k(clownmdemu, &cpu_callback_user_data, current_cycle);
+		if (MEGA_CD_ATTACHED(clownmdemu))
+			ReleaseMCDM68k(clownmdemu, &cpu_callback_user_data, cycles_per_frame_mega_cd);
 
 		/* Only render scanlines and generate H-Ints for scanlines that the console outputs to */
 		if (scanline < console_vertical_resolution)
@@ -317,22 +356,21 @@ void ClownMDEmu_Iterate(const ClownMDEmu* const clownmdemu)
 	/* Update everything for the rest of the frame. */
 	SyncM68k(clownmdemu, &cpu_callback_user_data, cycles_per_frame_mega_drive);
 	SyncZ80(clownmdemu, &cpu_callback_user_data, cycles_per_frame_mega_drive);
-	SyncMCDM68k(clownmdemu, &cpu_callback_user_data, cycles_per_frame_mega_cd);
 	SyncFM(&cpu_callback_user_data, cycles_per_frame_mega_drive);
 	SyncPSG(&cpu_callback_user_data, cycles_per_frame_mega_drive);
-	SyncPCM(&cpu_callback_user_data, cycles_per_frame_mega_cd);
-	SyncCDDA(&cpu_callback_user_data, clownmdemu->configuration->general.tv_standard == CLOWNMDEMU_TV_STANDARD_PAL ? CLOWNMDEMU_DIVIDE_BY_PAL_FRAMERATE(44100) : CLOWNMDEMU_DIVIDE_BY_NTSC_FRAMERATE(44100));
+	if (clownmdemu->psg_log != NULL)
+		clownmdemu->psg_log->total_frames = cpu_callback_user_data.sync.psg.current_cycle;
 
-	/* Fire IRQ1 if needed. */
-	/* TODO: This is a hack. Look into when this interrupt should actually be done. */
-	if (state->mega_cd.irq.irq1_pending)
+	/* Without a Mega CD, there is no PCM or CDDA audio at all, so the frontend does not even have to mix it. */
+	if (MEGA_CD_ATTACHED(clownmdemu))
 	{
-		state->mega_cd.irq.irq1_pending = cc_false;
-		Clown68000_Interrupt(clownmdemu->mcd_m68k, 1);
-	}
+		SyncMCDM68k(clownmdemu, &cpu_callback_user_data, cycles_per_frame_mega_cd);
+		SyncPCM(&cpu_callback_user_data, cycles_per_frame_mega_cd);
+		SyncCDDA(&cpu_callback_user_data, clownmdemu->configuration->general.tv_standard == CLOWNMDEMU_TV_STANDARD_PAL ? CLOWNMDEMU_DIVIDE_BY_PAL_FRAMERATE(44100) : CLOWNMDEMU_DIVIDE_BY_NTSC_FRAMERATE(44100));
 
-	/* TODO: This should be done 75 times a second (in sync with the CDD interrupt), not 60! */
-	CDDA_UpdateFade(&state->mega_cd.cdda);
+		/* TODO: This should be done 75 times a second (in sync with the CDD interrupt), not 60! */
+		CDDA_UpdateFade(&clownmdemu->mega_cd_state->cdda);
+	}
 }
 
 static cc_u8f ReadCartridgeByte(const ClownMDEmu* const clownmdemu, const cc_u32f address)
@@ -439,16 +477,18 @@ void ClownMDEmu_Reset(const ClownMDEmu* const clownmdemu, const cc_bool cd_boot,
 
 	SetUpExternalRAM(clownmdemu, cartridge_size);
 
-	state->mega_cd.boot_from_cd = cd_boot;
+	/* There is nothing to boot from without a Mega CD. */
+	state->boot_from_cd = cd_boot && MEGA_CD_ATTACHED(clownmdemu);
 
-	if (cd_boot)
+	if (state->boot_from_cd)
 	{
 		/* Boot from CD ("Mode 2"). */
+		ClownMDEmu_MegaCDState* const mega_cd_state = clownmdemu->mega_cd_state;
 		cc_u32f ip_start, ip_length, sp_start, sp_length;
 		const cc_u16f boot_header_offset = 0x6000;
 		const cc_u16f ip_start_default = 0x200;
 		const cc_u16f ip_length_default = 0x600;
-		cc_u16l* const sector_words = &state->mega_cd.prg_ram.buffer[boot_header_offset / 2];
+		cc_u16l* const sector_words = &mega_cd_state->prg_ram.buffer[boot_header_offset / 2];
 		/*cc_u8l region;*/
 
 		/* Read first sector. */
@@ -461,24 +501,24 @@ void ClownMDEmu_Reset(const ClownMDEmu* const clownmdemu, const cc_bool cd_boot,
 		/*region = sector_bytes[0x1F0];*/
 
 		/* Don't allow overflowing the PRG-RAM array. */
-		sp_length = CC_MIN(CC_COUNT_OF(state->mega_cd.prg_ram.buffer) * 2 - boot_header_offset, sp_length);
+		sp_length = CC_MIN(CC_COUNT_OF(mega_cd_state->prg_ram.buffer) * 2 - boot_header_offset, sp_length);
 
 		/* Read Initial Program. */
-		memcpy(state->mega_cd.word_ram.buffer, &sector_words[ip_start_default / 2], ip_length_default);
+		memcpy(mega_cd_state->word_ram.buffer, &sector_words[ip_start_default / 2], ip_length_default);
 
 		/* Load additional Initial Program data if necessary. */
 		if (ip_start != ip_start_default || ip_length != ip_length_default)
-			CDSectorsTo68kRAM(clownmdemu->callbacks, &state->mega_cd.word_ram.buffer[ip_length_default / 2], ip_start, 32 * CDC_SECTOR_SIZE);
+			CDSectorsTo68kRAM(clownmdemu->callbacks, &mega_cd_state->word_ram.buffer[ip_length_default / 2], ip_start, 32 * CDC_SECTOR_SIZE);
 
 		/* This is what Sega's BIOS does. */
-		memcpy(state->m68k.ram, state->mega_cd.word_ram.buffer, sizeof(state->m68k.ram) / 2);
+		memcpy(state->m68k.ram, mega_cd_state->word_ram.buffer, sizeof(state->m68k.ram) / 2);
 
 		/* Read Sub Program. */
-		CDSectorsTo68kRAM(clownmdemu->callbacks, &state->mega_cd.prg_ram.buffer[boot_header_offset / 2], sp_start, sp_length);
+		CDSectorsTo68kRAM(clownmdemu->callbacks, &mega_cd_state->prg_ram.buffer[boot_header_offset / 2], sp_start, sp_length);
 
 		/* Give WORD-RAM to the SUB-CPU. */
-		state->mega_cd.word_ram.dmna = cc_true;
-		state->mega_cd.word_ram.ret = cc_false;
+		mega_cd_state->word_ram.dmna = cc_true;
+		mega_cd_state->word_ram.ret = cc_false;
 	}
 
 	callback_user_data.clownmdemu = clownmdemu;
@@ -489,9 +529,12 @@ void ClownMDEmu_Reset(const ClownMDEmu* const clownmdemu, const cc_bool cd_boot,
 	m68k_read_write_callbacks.write_callback = M68kWriteCallback;
 	Clown68000_Reset(clownmdemu->m68k, &m68k_read_write_callbacks);
 
-	m68k_read_write_callbacks.read_callback = MCDM68kReadCallback;
-	m68k_read_write_callbacks.write_callback = MCDM68kWriteCallback;
-	Clown68000_Reset(clownmdemu->mcd_m68k, &m68k_read_write_callbacks);
+	if (MEGA_CD_ATTACHED(clownmdemu))
+	{
+		m68k_read_write_callbacks.read_callback = MCDM68kReadCallback;
+		m68k_read_write_callbacks.write_callback = MCDM68kWriteCallback;
+		Clown68000_Reset(clownmdemu->mcd_m68k, &m68k_read_write_callbacks);
+	}
 }
 
 void ClownMDEmu_SetLogCallback(const ClownMDEmu_LogCallback log_callback, const void* const user_data)
@@ -499,3 +542,46 @@ void ClownMDEmu_SetLogCallback(const ClownMDEmu_LogCallback log_callback, const
 	SetLogCallback(log_callback, user_data);
 	Clown68000_SetErrorCallback(log_callback, user_data);
 }
+
+cc_bool ClownMDEmu_TakeExternalRAMDirtyRange(const ClownMDEmu* const clownmdemu, cc_u32f* const start, cc_u32f* const end)
+{
+	ClownMDEmu_State* const state = clownmdemu->state;
+
+	if (state->external_ram.dirty_start >= state->external_ram.dirty_end)
+		return cc_false;
+
+	*start = state->external_ram.dirty_start;
+	*end = state->external_ram.dirty_end;
+
+	state->external_ram.dirty_start = CC_COUNT_OF(state->external_ram.buffer);
+	state->external_ram.dirty_end = 0;
+
+	return cc_true;
+}
+
+void ClownMDEmu_GeneratePSGAudioBandLimited(const ClownMDEmu* const clownmdemu, PSG_BandLimited* const band_limited, cc_s16l* const sample_buffer, const size_t total_frames)
+{
+	const size_t output_frames = PSG_BandLimited_GetOutputFrames(band_limited, total_frames);
+
+	PSG_UpdateBandLimited(&clownmdemu->psg, band_limited, sample_buffer, total_frames);
+
+	/* This is the same 2842Hz filter that is applied to the PSG's native output, but configured for the output sample rate instead.
+	   The coefficients are calculated the same way as https://www.meme.net.au/butterworth.html does. */
+	if (!clownmdemu->configuration->general.low_pass_filter_disabled)
+	{
+		const double output_coefficient = 1.0 + 1.0 / tan(CC_PI * 2842.0 / band_limited->output_sample_rate);
+		const double input_coefficient = output_coefficient - 2.0;
+
+		LowPassFilter_FirstOrder_Apply(clownmdemu->state->low_pass_filters.psg, CC_COUNT_OF(clownmdemu->state->low_pass_filters.psg), sample_buffer, output_frames, LOW_PASS_FILTER_COMPUTE_MAGIC_FIRST_ORDER(output_coefficient, input_coefficient));
+	}
+}
+
+void ClownMDEmu_GeneratePSGAudioFromLog(const ClownMDEmu* const clownmdemu, const ClownMDEmu_PSGLog* const log)
+{
+	GeneratePSGAudioFromLog(clownmdemu, log);
+}
+
+void ClownMDEmu_RunSubCPU(void* const job)
+{
+	SyncMCDM68kOnOtherThread((CPUCallbackUserData*)job);
+}
@@ -1,71 +1,149 @@
 #include "core/low-pass-filter.h"
 
+#include <assert.h>
 #include <string.h>
 
-void LowPassFilter_FirstOrder_Initialise(LowPassFilter_FirstOrder_State* const states, const cc_u8f total_channels)
-{
-	memset(states, 0, sizeof(*states) * total_channels);
-}
+/* The filters are recursive, so the only parallelism available is between channels. */
+/* To expose it, each channel's state is held in a local for the duration of the loop, and every channel of a frame */
+/* is processed together. These functions are only ever called with a constant channel count, allowing the compiler */
+/* to unroll the channel loop and process the channels side-by-side. */
 
-void LowPassFilter_FirstOrder_Apply(LowPassFilter_FirstOrder_State* const states, const cc_u8f total_channels, cc_s16l* const sample_buffer, const size_t total_frames, const cc_s32f sample_magic, const cc_s32f output_magic)
+static void LowPassFilter_FirstOrder_ApplyChannels(LowPassFilter_FirstOrder_State* const states, const cc_u8f total_channels, cc_s16l* const sample_buffer, const size_t total_frames, const cc_s32f sample_magic, const cc_s32f output_magic)
 {
+	cc_s32f previous_samples[LOW_PASS_FILTER_MAXIMUM_CHANNELS], previous_outputs[LOW_PASS_FILTER_MAXIMUM_CHANNELS];
 	size_t current_frame;
+	cc_u8f current_channel;
 
 	cc_s16l *sample_pointer = sample_buffer;
 
-	for (current_frame = 0; current_frame < total_frames; ++current_frame)
+	for (current_channel = 0; current_channel < total_channels; ++current_channel)
 	{
-		cc_u8f current_channel;
+		previous_samples[current_channel] = states[current_channel].previous_sample;
+		previous_outputs[current_channel] = states[current_channel].previous_output;
+	}
 
+	for (current_frame = 0; current_frame < total_frames; ++current_frame)
+	{
 		for (current_channel = 0; current_channel < total_channels; ++current_channel)
 		{
-			LowPassFilter_FirstOrder_State* const state = &states[current_channel];
-			const cc_s16l output = (((cc_s32f)*sample_pointer + state->previous_sample) * sample_magic + state->previous_output * output_magic) / LOW_PASS_FILTER_FIXED_BASE;
+			const cc_s32f sample = sample_pointer[current_channel];
+			const cc_s16l output = ((sample + previous_samples[current_channel]) * sample_magic + previous_outputs[current_channel] * output_magic) / LOW_PASS_FILTER_FIXED_BASE;
 
-			state->previous_sample = *sample_pointer;
-			state->previous_output = output;
+			previous_samples[current_channel] = sample;
+			previous_outputs[current_channel] = output;
 
-			*sample_pointer = output;
-			++sample_pointer;
+			sample_pointer[current_channel] = output;
 		}
+
+		sample_pointer += total_channels;
 	}
-}
 
-void LowPassFilter_SecondOrder_Initialise(LowPassFilter_SecondOrder_State* const states, const cc_u8f total_channels)
-{
-	memset(states, 0, sizeof(*states) * total_channels);
+	for (current_channel = 0; current_channel < total_channels; ++current_channel)
+	{
+		states[current_channel].previous_sample = (cc_s16l)previous_samples[current_channel];
+		states[current_channel].previous_output = (cc_s16l)previous_outputs[current_channel];
+	}
 }
 
-void LowPassFilter_SecondOrder_Apply(LowPassFilter_SecondOrder_State* const states, const cc_u8f total_channels, cc_s16l* const sample_buffer, const size_t total_frames, const cc_s32f sample_magic, const cc_s32f output_magic_1, const cc_s32f output_magic_2)
+static void LowPassFilter_SecondOrder_ApplyChannels(LowPassFilter_SecondOrder_State* const states, const cc_u8f total_channels, cc_s16l* const sample_buffer, const size_t total_frames, const cc_s32f sample_magic, const cc_s32f output_magic_1, const cc_s32f output_magic_2)
 {
+	cc_s32f previous_samples[2][LOW_PASS_FILTER_MAXIMUM_CHANNELS], previous_outputs[2][LOW_PASS_FILTER_MAXIMUM_CHANNELS];
 	size_t current_frame;
+	cc_u8f current_channel;
 
 	cc_s16l *sample_pointer = sample_buffer;
 
-	for (current_frame = 0; current_frame < total_frames; ++current_frame)
+	for (current_channel = 0; current_channel < total_channels; ++current_channel)
 	{
-		cc_u8f current_channel;
+		previous_samples[0][current_channel] = states[current_channel].previous_samples[0];
+		previous_samples[1][current_channel] = states[current_channel].previous_samples[1];
+		previous_outputs[0][current_channel] = states[current_channel].previous_outputs[0];
+		previous_outputs[1][current_channel] = states[current_channel].previous_outputs[1];
+	}
 
+	for (current_frame = 0; current_frame < total_frames; ++current_frame)
+	{
 		for (current_channel = 0; current_channel < total_channels; ++current_channel)
 		{
-			LowPassFilter_SecondOrder_State* const state = &states[current_channel];
+			const cc_s32f sample = sample_pointer[current_channel];
 
 			const cc_s32f unclamped_output
-				= LOW_PASS_FILTER_FIXED_MULTIPLY((cc_s32f)*sample_pointer + state->previous_samples[0], sample_magic)
-				+ LOW_PASS_FILTER_FIXED_MULTIPLY((cc_s32f)state->previous_samples[0] + state->previous_samples[1], sample_magic)
-				+ LOW_PASS_FILTER_FIXED_MULTIPLY(state->previous_outputs[0], output_magic_1)
-				- LOW_PASS_FILTER_FIXED_MULTIPLY(state->previous_outputs[1], output_magic_2);
+				= LOW_PASS_FILTER_FIXED_MULTIPLY(sample + previous_samples[0][current_channel], sample_magic)
+				+ LOW_PASS_FILTER_FIXED_MULTIPLY(previous_samples[0][current_channel] + previous_samples[1][current_channel], sample_magic)
+				+ LOW_PASS_FILTER_FIXED_MULTIPLY(previous_outputs[0][current_channel], output_magic_1)
+				- LOW_PASS_FILTER_FIXED_MULTIPLY(previous_outputs[1][current_channel], output_magic_2);
 
 			/* For some reason, out-of-range values can be produced by this particular low-pass filter. */
 			const cc_s16l output = CC_CLAMP(-0x7FFF, 0x7FFF, unclamped_output);
 
-			state->previous_samples[1] = state->previous_samples[0];
-			state->previous_samples[0] = *sample_pointer;
-			state->previous_outputs[1] = state->previous_outputs[0];
-			state->previous_outputs[0] = output;
+			previous_samples[1][current_channel] = previous_samples[0][current_channel];
+			previous_samples[0][current_channel] = sample;
+			previous_outputs[1][current_channel] = previous_outputs[0][current_channel];
+			previous_outputs[0][current_channel] = output;
 
-			*sample_pointer = output;
-			++sample_pointer;
+			sample_pointer[current_channel] = output;
 		}
+
+		sample_pointer += total_channels;
+	}
+
+	for (current_channel = 0; current_channel < total_channels; ++current_channel)
+	{
+		states[current_channel].previous_samples[0] = (cc_s16l)previous_samples[0][current_channel];
+		states[current_channel].previous_samples[1] = (cc_s16l)previous_samples[1][current_channel];
+		states[current_channel].previous_outputs[0] = (cc_s16l)previous_outputs[0][current_channel];
+		states[current_channel].previous_outputs[1] = (cc_s16l)previous_outputs[1][current_channel];
+	}
+}
+
+void LowPassFilter_FirstOrder_Initialise(LowPassFilter_FirstOrder_State* const states, const cc_u8f total_channels)
+{
+	memset(states, 0, sizeof(*states) * total_channels);
+}
+
+void LowPassFilter_FirstOrder_Apply(LowPassFilter_FirstOrder_State* const states, const cc_u8f total_channels, cc_s16l* const sample_buffer, const size_t total_frames, const cc_s32f sample_magic, const cc_s32f output_magic)
+{
+	assert(total_channels <= LOW_PASS_FILTER_MAXIMUM_CHANNELS);
+
+	/* Give the compiler a constant channel count to work with. */
+	switch (total_channels)
+	{
+		case 1:
+			LowPassFilter_FirstOrder_ApplyChannels(states, 1, sample_buffer, total_frames, sample_magic, output_magic);
+			break;
+
+		case 2:
+			LowPassFilter_FirstOrder_ApplyChannels(states, 2, sample_buffer, total_frames, sample_magic, output_magic);
+			break;
+
+		default:
+			LowPassFilter_FirstOrder_ApplyChannels(states, total_channels, sample_buffer, total_frames, sample_magic, output_magic);
+			break;
+	}
+}
+
+void LowPassFilter_SecondOrder_Initialise(LowPassFilter_SecondOrder_State* const states, const cc_u8f total_channels)
+{
+	memset(states, 0, sizeof(*states) * total_channels);
+}
+
+void LowPassFilter_SecondOrder_Apply(LowPassFilter_SecondOrder_State* const states, const cc_u8f total_channels, cc_s16l* const sample_buffer, const size_t total_frames, const cc_s32f sample_magic, const cc_s32f output_magic_1, const cc_s32f output_magic_2)
+{
+	assert(total_channels <= LOW_PASS_FILTER_MAXIMUM_CHANNELS);
+
+	/* Give the compiler a constant channel count to work with. */
+	switch (total_channels)
+	{
+		case 1:
+			LowPassFilter_SecondOrder_ApplyChannels(states, 1, sample_buffer, total_frames, sample_magic, output_magic_1, output_magic_2);
+			break;
+
+		case 2:
+			LowPassFilter_SecondOrder_ApplyChannels(states, 2, sample_buffer, total_frames, sample_magic, output_magic_1, output_magic_2);
+			break;
+
+		default:
+			LowPassFilter_SecondOrder_ApplyChannels(states, total_channels, sample_buffer, total_frames, sample_magic, output_magic_1, output_magic_2);
+			break;
 	}
 }
@@ -1,5 +1,6 @@
 #include "core/pcm.h"
 
+#include <assert.h>
 #include <string.h>
 
 /* MEGA-CD HARDWARE MANUAL - PCM SOUND SOURCE */
@@ -8,6 +9,9 @@
 /* RF5C68A manual */
 /* https://segaretro.org/images/2/22/RF5C68A.pdf */
 
+/* The number of frames that each channel is processed for at a time. */
+#define PCM_SPAN_FRAMES 0x100
+
 void PCM_State_Initialise(PCM_State* const state)
 {
 	cc_u8f i;
@@ -196,103 +200,112 @@ void PCM_WriteWaveRAM(const PCM* const pcm, const cc_u16f address, const cc_u8f
 	pcm->state->wave_ram[(pcm->state->current_wave_bank << 12) + (address & 0xFFF)] = value;
 }
 
-static cc_u8f PCM_FetchSample(const PCM* const pcm, const PCM_ChannelState* const channel)
+void PCM_WriteWaveRAMWords(const PCM* const pcm, const cc_u16f address, const cc_u16l* const words, const cc_u16f total_words)
 {
-	return pcm->state->wave_ram[(channel->address >> 11) & 0xFFFF];
-}
+	cc_u8l* const bytes = &pcm->state->wave_ram[(pcm->state->current_wave_bank << 12) + (address & 0xFFF)];
+	cc_u16f i;
 
-static cc_u8f PCM_UpdateAddressAndFetchSample(const PCM* const pcm, PCM_ChannelState* const channel)
-{
-	cc_u8f wave_value = 0;
+	assert((address & 0xFFF) + total_words * 2 <= 0x1000);
 
-	if (PCM_IsChannelAudible(pcm, channel))
+	for (i = 0; i < total_words; ++i)
 	{
-		/* Read sample and advance address. */
-		wave_value = PCM_FetchSample(pcm, channel);
-		channel->address += channel->frequency;
-		channel->address &= 0x7FFFFFF;
-
-		/* Handle looping. */
-		if (wave_value == 0xFF)
-		{
-			channel->address = channel->loop_address << 11;
-			wave_value = PCM_FetchSample(pcm, channel);
-		}
+		bytes[i * 2 + 0] = (words[i] >> 8) & 0xFF;
+		bytes[i * 2 + 1] = (words[i] >> 0) & 0xFF;
 	}
-
-	return wave_value;
 }
 
-static cc_s16f PCM_UnsignedToSigned(const cc_u16f sample)
+static cc_s16f PCM_UnsignedToSigned(const cc_s32f sample)
 {
-	cc_s16f signed_sample;
-
 	/* Samples can be -0x8000, but that is incompatible with non-two's-complement 16-bit integers, which this emulator supports. */
-	if (sample == 0)
-		signed_sample = -0x7FFF;
-	else if ((sample & 0x8000) != 0)
-		signed_sample = (cc_s16f)(sample - 0x8000);
-	else
-		signed_sample = -(cc_s16f)(0x8000 - sample);
-
-	return signed_sample;
+	/* This is written without branches so that it can be vectorised. */
+	return CC_MAX(sample - 0x8000, -0x7FFF);
 }
 
-void PCM_Update(const PCM* const pcm, cc_s16l* const sample_buffer, const size_t total_frames)
+static void PCM_MixChannelSpan(const PCM* const pcm, PCM_ChannelState* const channel, cc_s32l* const mixed_samples, const size_t total_frames, const cc_bool muted)
 {
-	cc_s16l *sample_pointer = sample_buffer;
+	/* None of these can change during an update, so they are kept out of the loop. */
+	const cc_u8l* const wave_ram = pcm->state->wave_ram;
+	const cc_u32f frequency = channel->frequency;
+	const cc_u32f loop_address = (cc_u32f)channel->loop_address << 11;
+	/* Muted channels must still advance, so they are simply mixed at zero volume. */
+	const cc_u32f volumes[2] = {muted ? 0 : (cc_u32f)channel->volume * channel->panning[0], muted ? 0 : (cc_u32f)channel->volume * channel->panning[1]};
+
+	cc_u32f address = channel->address;
 	size_t current_frame;
 
 	for (current_frame = 0; current_frame < total_frames; ++current_frame)
 	{
-		cc_u16f mixed_samples[2] = {0x8000, 0x8000};
-		cc_u8f current_channel;
-		cc_u8f current_mixed_sample;
+		/* Read sample and advance address. */
+		cc_u8f sample = wave_ram[(address >> 11) & 0xFFFF];
+
+		address += frequency;
+		address &= 0x7FFFFFF;
+
+		/* Handle looping. */
+		if (sample == 0xFF)
+		{
+			address = loop_address;
+			sample = wave_ram[(address >> 11) & 0xFFFF];
+		}
 
-		for (current_channel = 0; current_channel < CC_COUNT_OF(pcm->state->channels); ++current_channel)
 		{
-			PCM_ChannelState* const channel = &pcm->state->channels[current_channel];
-
-			const cc_u8f sample = PCM_UpdateAddressAndFetchSample(pcm, channel);
-
-			if (PCM_IsChannelAudible(pcm, channel) && !pcm->configuration->channels_disabled[current_channel])
-			{
-				for (current_mixed_sample = 0; current_mixed_sample < CC_COUNT_OF(mixed_samples); ++current_mixed_sample)
-				{
-					/* Mask out direction bit and apply volume and panning. */
-					const cc_u8f absolute_sample = sample & 0x7F;
-					const cc_bool add_bit = (sample & 0x80) != 0;
-					const cc_u32f scaled_absolute_sample = ((cc_u32f)absolute_sample * channel->volume * channel->panning[current_mixed_sample]) >> 5;
-
-					cc_u32f mixed_sample = mixed_samples[current_mixed_sample];
-
-					/* TODO: Check if this is how real hardware handles clipping, or if it's only done after mixing. */
-					if (add_bit)
-					{
-						mixed_sample += scaled_absolute_sample;
-
-						/* Handle overflow. */
-						if (mixed_sample > 0xFFFF)
-							mixed_sample = 0xFFFF;
-					}
-					else
-					{
-						mixed_sample -= scaled_absolute_sample;
-
-						/* Handle underflow. */
-						if (mixed_sample > 0xFFFF)
-							mixed_sample = 0x0000;
-					}
-
-					mixed_samples[current_mixed_sample] = mixed_sample;
-				}
-			}
+			/* Mask out direction bit and apply volume and panning. */
+			const cc_u8f absolute_sample = sample & 0x7F;
+			const cc_bool add_bit = (sample & 0x80) != 0;
+			const cc_s32f scaled_left = (cc_s32f)((absolute_sample * volumes[0]) >> 5);
+			const cc_s32f scaled_right = (cc_s32f)((absolute_sample * volumes[1]) >> 5);
+
+			/* TODO: Check if this is how real hardware handles clipping, or if it's only done after mixing. */
+			mixed_samples[current_frame * 2 + 0] = CC_CLAMP(0, 0xFFFF, mixed_samples[current_frame * 2 + 0] + (add_bit ? scaled_left : -scaled_left));
+			mixed_samples[current_frame * 2 + 1] = CC_CLAMP(0, 0xFFFF, mixed_samples[current_frame * 2 + 1] + (add_bit ? scaled_right : -scaled_right));
 		}
+	}
+
+	channel->address = address;
+}
+
+void PCM_Update(const PCM* const pcm, cc_s16l* const sample_buffer, const size_t total_frames)
+{
+	cc_u8f active_channels[CC_COUNT_OF(pcm->state->channels)];
+	cc_u8f total_active_channels;
+	cc_u8f current_channel;
+	size_t span_start;
+
+	/* Neither the channels' enable states nor the sounding flag can change during an update, */
+	/* so find the channels that are running up-front. */
+	total_active_channels = 0;
+
+	for (current_channel = 0; current_channel < CC_COUNT_OF(pcm->state->channels); ++current_channel)
+		if (PCM_IsChannelAudible(pcm, &pcm->state->channels[current_channel]))
+			active_channels[total_active_channels++] = current_channel;
+
+	/* With no channels running, the output is silence, which would add nothing to the buffer. */
+	if (total_active_channels == 0)
+		return;
+
+	/* Process each channel over a whole span at a time, rather than every channel for each frame. */
+	/* The channels are still mixed in the same order, so the clipping behaves the same. */
+	for (span_start = 0; span_start < total_frames; span_start += PCM_SPAN_FRAMES)
+	{
+		const size_t span_frames = CC_MIN(PCM_SPAN_FRAMES, total_frames - span_start);
+
+		cc_s32l mixed_samples[PCM_SPAN_FRAMES * 2];
+		cc_s16l* const sample_pointer = &sample_buffer[span_start * 2];
+		cc_u8f current_active_channel;
+		size_t i;
 
-		for (current_mixed_sample = 0; current_mixed_sample < CC_COUNT_OF(mixed_samples); ++current_mixed_sample)
+		for (i = 0; i < span_frames * 2; ++i)
+			mixed_samples[i] = 0x8000;
+
+		for (current_active_channel = 0; current_active_channel < total_active_channels; ++current_active_channel)
 		{
-			/* TODO: Just set, rather than add, and make the mixer reflect this too. */
-			*sample_pointer++ += PCM_UnsignedToSigned(mixed_samples[current_mixed_sample]);
+			const cc_u8f channel_index = active_channels[current_active_channel];
+
+			PCM_MixChannelSpan(pcm, &pcm->state->channels[channel_index], mixed_samples, span_frames, pcm->configuration->channels_disabled[channel_index]);
 		}
+
+		/* TODO: Just set, rather than add, and make the mixer reflect this too. */
+		for (i = 0; i < span_frames * 2; ++i)
+			sample_pointer[i] += PCM_UnsignedToSigned(mixed_samples[i]);
 	}
 }
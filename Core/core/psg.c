@@ -7,7 +7,9 @@ https://www.smspower.org/Development/SN76489
 
 #include "core/psg.h"
 
+#include <assert.h>
 #include <math.h>
+#include <string.h>
 
 #include "core/clowncommon/clowncommon.h"
 
@@ -29,6 +31,43 @@ void PSG_Constant_Initialise(PSG_Constant* const constant)
 	/* The lowest volume is always 0. */
 	constant->volumes[0xF][0] = 0;
 	constant->volumes[0xF][1] = 0;
+
+	/* Generate the band-limited step table. */
+	/* Each phase is a Blackman-windowed sinc impulse, offset by a fraction of a sample, which becomes a band-limited step once integrated. */
+	for (i = 0; i < PSG_BAND_LIMITED_KERNEL_PHASES; ++i)
+	{
+		/* Cut off slightly below the output's Nyquist frequency, to leave room for the window's transition band. */
+		const double cut_off = 0.45;
+		const double offset = (double)i / PSG_BAND_LIMITED_KERNEL_PHASES;
+
+		double impulse[PSG_BAND_LIMITED_KERNEL_TAPS];
+		double total = 0.0;
+		cc_s32f rounded_total = 0;
+		cc_u8f largest_tap = 0;
+		cc_u8f j;
+
+		for (j = 0; j < PSG_BAND_LIMITED_KERNEL_TAPS; ++j)
+		{
+			const double x = (double)j - (PSG_BAND_LIMITED_KERNEL_TAPS / 2 - 1) - offset;
+			const double sinc = x == 0.0 ? 1.0 : sin(CC_PI * 2.0 * cut_off * x) / (CC_PI * 2.0 * cut_off * x);
+			const double window = 0.42 + 0.5 * cos(CC_PI * 2.0 * x / PSG_BAND_LIMITED_KERNEL_TAPS) + 0.08 * cos(CC_PI * 4.0 * x / PSG_BAND_LIMITED_KERNEL_TAPS);
+
+			impulse[j] = sinc * window;
+			total += impulse[j];
+		}
+
+		for (j = 0; j < PSG_BAND_LIMITED_KERNEL_TAPS; ++j)
+		{
+			constant->band_limited_steps[i][j] = (cc_s16l)floor(impulse[j] / total * PSG_BAND_LIMITED_KERNEL_UNITY + 0.5);
+			rounded_total += constant->band_limited_steps[i][j];
+
+			if (constant->band_limited_steps[i][j] > constant->band_limited_steps[i][largest_tap])
+				largest_tap = j;
+		}
+
+		/* Make each phase sum to exactly unity, so that the integrated output never drifts. */
+		constant->band_limited_steps[i][largest_tap] += PSG_BAND_LIMITED_KERNEL_UNITY - rounded_total;
+	}
 }
 
 void PSG_State_Initialise(PSG_State* const state)
@@ -126,98 +165,285 @@ void PSG_DoCommand(const PSG* const psg, const cc_u8f command)
 	}
 }
 
+typedef struct PSG_Output
+{
+	/* The exact path mixes directly into this buffer, which is at the PSG's native sample rate. */
+	cc_s16l *sample_buffer;
+	/* The band-limited path instead records each change in the channel's level as a band-limited step. */
+	PSG_BandLimited *band_limited;
+	cc_s16l *level;
+} PSG_Output;
+
+static void AddBandLimitedStep(const PSG* const psg, PSG_BandLimited* const band_limited, const size_t position, const cc_s32f delta)
+{
+	/* Convert the position from the native sample rate to the output sample rate, splitting it into a whole and fractional part. */
+	const cc_u32f time = (cc_u32f)position * band_limited->output_sample_rate + band_limited->time_remainder;
+	const cc_u32f index = time / band_limited->input_sample_rate;
+	const cc_u32f phase = time % band_limited->input_sample_rate * PSG_BAND_LIMITED_KERNEL_PHASES / band_limited->input_sample_rate;
+
+	const cc_s16l* const step = psg->constant->band_limited_steps[phase];
+	cc_s32l* const deltas = &band_limited->deltas[index];
+
+	cc_u8f i;
+
+	for (i = 0; i < PSG_BAND_LIMITED_KERNEL_TAPS; ++i)
+		deltas[i] += delta * step[i];
+}
+
+static void OutputSamples(const PSG* const psg, const PSG_Output* const output, const size_t position, const size_t total_frames, const cc_s16f sample)
+{
+	if (output->band_limited == NULL)
+	{
+		cc_s16l* const sample_buffer = &output->sample_buffer[position];
+
+		size_t i;
+
+		/* This is deliberately kept simple so that the compiler can vectorise it. */
+		for (i = 0; i < total_frames; ++i)
+			sample_buffer[i] += sample;
+	}
+	else if (total_frames != 0 && sample != *output->level)
+	{
+		AddBandLimitedStep(psg, output->band_limited, position, sample - *output->level);
+		*output->level = sample;
+	}
+}
+
+static void UpdateTone(const PSG* const psg, const PSG_Output* const output, PSG_ToneState* const tone, const size_t total_frames)
+{
+	size_t position = 0;
+	size_t run_length;
+
+	/* Curiously, the phase never changes if the frequency is at its maximum.
+	   This can be exploited to play PCM samples. After Burner II relies on this. */
+	if (tone->countdown_master == 0)
+	{
+		tone->countdown -= CC_MIN(tone->countdown, total_frames);
+		OutputSamples(psg, output, position, total_frames, psg->constant->volumes[tone->attenuation][tone->output_bit]);
+		return;
+	}
+
+	/* Rather than processing one sample at a time, the output is produced in runs which last until the phase changes.
+	   The countdown is decremented before it is checked, so the phase changes on the sample that makes it reach 0. */
+	run_length = tone->countdown == 0 ? 0 : tone->countdown - 1;
+
+	if (run_length >= total_frames)
+	{
+		tone->countdown -= total_frames;
+		OutputSamples(psg, output, position, total_frames, psg->constant->volumes[tone->attenuation][tone->output_bit]);
+		return;
+	}
+
+	OutputSamples(psg, output, position, run_length, psg->constant->volumes[tone->attenuation][tone->output_bit]);
+	position += run_length;
+
+	do
+	{
+		/* Switch from positive phase to negative phase and vice versa. */
+		/* The sample that causes the switch outputs the new phase, so each run is as long as the full countdown. */
+		tone->output_bit = !tone->output_bit;
+
+		run_length = CC_MIN(tone->countdown_master, total_frames - position);
+		OutputSamples(psg, output, position, run_length, psg->constant->volumes[tone->attenuation][tone->output_bit]);
+		position += run_length;
+	} while (position != total_frames);
+
+	/* Reset the countdown, accounting for however much of it was used by the final run. */
+	tone->countdown = tone->countdown_master - (run_length - 1);
+}
+
+static cc_u16f GetNoiseCountdownMaster(const PSG_State* const state)
+{
+	switch (state->noise.frequency_mode)
+	{
+		default:
+		case 0:
+			return 0x10;
+
+		case 1:
+			return 0x20;
+
+		case 2:
+			return 0x40;
+
+		case 3:
+			/* Use the last tone channel's frequency. */
+			return state->tones[CC_COUNT_OF(state->tones) - 1].countdown_master;
+	}
+}
+
+static void UpdateNoise(const PSG* const psg, const PSG_Output* const output, const size_t total_frames)
+{
+	PSG_NoiseState* const noise = &psg->state->noise;
+	const cc_u16f countdown_master = GetNoiseCountdownMaster(psg->state);
+
+	size_t position = 0;
+	size_t run_length;
+
+	/* This works the same way as the tone channels, except that the countdown always expires, even when it is reset to 0. */
+	run_length = noise->countdown == 0 ? 0 : noise->countdown - 1;
+
+	if (run_length >= total_frames)
+	{
+		noise->countdown -= total_frames;
+		OutputSamples(psg, output, position, total_frames, psg->constant->volumes[noise->attenuation][noise->real_output_bit]);
+		return;
+	}
+
+	OutputSamples(psg, output, position, run_length, psg->constant->volumes[noise->attenuation][noise->real_output_bit]);
+	position += run_length;
+
+	do
+	{
+		noise->fake_output_bit = !noise->fake_output_bit;
+
+		if (noise->fake_output_bit)
+		{
+			/* The noise channel works by maintaining a 16-bit register, whose bits are rotated every time
+			   the output bit goes from low to high. The bit that was rotated from the 'bottom' of the
+			   register to the 'top' is what is output to the speaker. In white noise mode, after rotation,
+			   the bit at the 'top' is XOR'd with the bit that is third from the 'bottom'. */
+			noise->real_output_bit = (noise->shift_register & 0x8000) >> 15;
+
+			noise->shift_register <<= 1;
+			noise->shift_register |= noise->real_output_bit;
+
+			if (noise->type == PSG_NOISE_TYPE_WHITE)
+				noise->shift_register ^= (noise->shift_register & 0x2000) >> 13;
+		}
+
+		run_length = CC_MIN(CC_MAX(countdown_master, 1), total_frames - position);
+		OutputSamples(psg, output, position, run_length, psg->constant->volumes[noise->attenuation][noise->real_output_bit]);
+		position += run_length;
+	} while (position != total_frames);
+
+	noise->countdown = countdown_master - (run_length - 1);
+}
+
 void PSG_Update(const PSG* const psg, cc_s16l* const sample_buffer, const size_t total_frames)
 {
+	PSG_Output output;
 	size_t i;
-	size_t j;
-	cc_s16l *sample_buffer_pointer;
+
+	output.sample_buffer = sample_buffer;
+	output.band_limited = NULL;
+	output.level = NULL;
 
 	/* Do the tone channels. */
 	for (i = 0; i < CC_COUNT_OF(psg->state->tones); ++i)
-	{
 		if (!psg->configuration->tone_disabled[i])
-		{
-			PSG_ToneState* const tone = &psg->state->tones[i];
+			UpdateTone(psg, &output, &psg->state->tones[i], total_frames);
 
-			sample_buffer_pointer = sample_buffer;
+	/* Do the noise channel. */
+	if (!psg->configuration->noise_disabled)
+		UpdateNoise(psg, &output, total_frames);
+}
 
-			for (j = 0; j < total_frames; ++j)
-			{
-				/* This countdown is responsible for the channel's frequency. */
-				if (tone->countdown != 0)
-					--tone->countdown;
-
-				/* Curiously, the phase never changes if the frequency is at its maximum.
-				   This can be exploited to play PCM samples. After Burner II relies on this. */
-				if (tone->countdown_master != 0 && tone->countdown == 0)
-				{
-					/* Reset the countdown. */
-					tone->countdown = tone->countdown_master;
-
-					/* Switch from positive phase to negative phase and vice versa. */
-					tone->output_bit = !tone->output_bit;
-				}
-
-				/* Output a sample. */
-				*sample_buffer_pointer++ += psg->constant->volumes[tone->attenuation][tone->output_bit];
-			}
-		}
+/* Band-Limited Synthesis */
+
+void PSG_BandLimited_Initialise(PSG_BandLimited* const band_limited, const cc_u32f input_sample_rate, const cc_u32f output_sample_rate)
+{
+	size_t i;
+
+	/* This is only intended for downsampling. */
+	assert(output_sample_rate != 0 && output_sample_rate <= input_sample_rate);
+
+	band_limited->input_sample_rate = input_sample_rate;
+	band_limited->output_sample_rate = output_sample_rate;
+	band_limited->time_remainder = 0;
+	/* Limit how much input is processed at once, so that the delta buffer never overflows. */
+	band_limited->maximum_input_frames = (size_t)(PSG_BAND_LIMITED_BUFFER_SIZE - 1) * input_sample_rate / output_sample_rate;
+	band_limited->accumulator = 0;
+
+	for (i = 0; i < CC_COUNT_OF(band_limited->levels); ++i)
+		band_limited->levels[i] = 0;
+
+	for (i = 0; i < CC_COUNT_OF(band_limited->deltas); ++i)
+		band_limited->deltas[i] = 0;
+}
+
+size_t PSG_BandLimited_GetOutputFrames(const PSG_BandLimited* const band_limited, const size_t total_input_frames)
+{
+	size_t total_output_frames = 0;
+	size_t input_frames_remaining = total_input_frames;
+	cc_u32f time_remainder = band_limited->time_remainder;
+
+	/* This mirrors the chunking that is done by 'PSG_UpdateBandLimited', to avoid overflow. */
+	while (input_frames_remaining != 0)
+	{
+		const size_t input_frames = CC_MIN(input_frames_remaining, band_limited->maximum_input_frames);
+		const cc_u32f time = (cc_u32f)input_frames * band_limited->output_sample_rate + time_remainder;
+
+		total_output_frames += time / band_limited->input_sample_rate;
+		time_remainder = time % band_limited->input_sample_rate;
+		input_frames_remaining -= input_frames;
 	}
 
+	return total_output_frames;
+}
+
+static void UpdateBandLimitedChunk(const PSG* const psg, PSG_BandLimited* const band_limited, cc_s16l* const sample_buffer, const size_t total_input_frames)
+{
+	const cc_u32f time = (cc_u32f)total_input_frames * band_limited->output_sample_rate + band_limited->time_remainder;
+	const size_t total_output_frames = time / band_limited->input_sample_rate;
+
+	PSG_Output output;
+	size_t i;
+
+	output.sample_buffer = NULL;
+	output.band_limited = band_limited;
+
+	/* Record the level changes of each channel. */
+	/* Disabled channels are faded to silence, instead of being left at whatever level they were at. */
+	for (i = 0; i < CC_COUNT_OF(psg->state->tones); ++i)
+	{
+		output.level = &band_limited->levels[i];
+
+		if (!psg->configuration->tone_disabled[i])
+			UpdateTone(psg, &output, &psg->state->tones[i], total_input_frames);
+		else
+			OutputSamples(psg, &output, 0, total_input_frames, 0);
+	}
+
+	output.level = &band_limited->levels[CC_COUNT_OF(psg->state->tones)];
+
 	if (!psg->configuration->noise_disabled)
+		UpdateNoise(psg, &output, total_input_frames);
+	else
+		OutputSamples(psg, &output, 0, total_input_frames, 0);
+
+	/* Integrate the steps to produce the output samples. */
+	for (i = 0; i < total_output_frames; ++i)
 	{
-		/* Do the noise channel. */
-		sample_buffer_pointer = sample_buffer;
+		cc_s32f sample;
 
-		for (j = 0; j < total_frames; ++j)
-		{
-			/* This countdown is responsible for the channel's frequency. */
-			if (psg->state->noise.countdown != 0)
-				--psg->state->noise.countdown;
+		band_limited->accumulator += band_limited->deltas[i];
 
-			if (psg->state->noise.countdown == 0)
-			{
-				/* Reset the countdown. */
-				switch (psg->state->noise.frequency_mode)
-				{
-					case 0:
-						psg->state->noise.countdown = 0x10;
-						break;
-
-					case 1:
-						psg->state->noise.countdown = 0x20;
-						break;
-
-					case 2:
-						psg->state->noise.countdown = 0x40;
-						break;
-
-					case 3:
-						/* Use the last tone channel's frequency. */
-						psg->state->noise.countdown = psg->state->tones[CC_COUNT_OF(psg->state->tones) - 1].countdown_master;
-						break;
-				}
-
-				psg->state->noise.fake_output_bit = !psg->state->noise.fake_output_bit;
-
-				if (psg->state->noise.fake_output_bit)
-				{
-					/* The noise channel works by maintaining a 16-bit register, whose bits are rotated every time
-					   the output bit goes from low to high. The bit that was rotated from the 'bottom' of the
-					   register to the 'top' is what is output to the speaker. In white noise mode, after rotation,
-					   the bit at the 'top' is XOR'd with the bit that is third from the 'bottom'. */
-					psg->state->noise.real_output_bit = (psg->state->noise.shift_register & 0x8000) >> 15;
-
-					psg->state->noise.shift_register <<= 1;
-					psg->state->noise.shift_register |= psg->state->noise.real_output_bit;
-
-					if (psg->state->noise.type == PSG_NOISE_TYPE_WHITE)
-						psg->state->noise.shift_register ^= (psg->state->noise.shift_register & 0x2000) >> 13;
-				}
-			}
+		/* The steps can overshoot slightly, so clamp the output. */
+		sample = band_limited->accumulator / PSG_BAND_LIMITED_KERNEL_UNITY + sample_buffer[i];
+		sample_buffer[i] = CC_CLAMP(-0x7FFF, 0x7FFF, sample);
+	}
 
-			/* Output a sample. */
-			*sample_buffer_pointer++ += psg->constant->volumes[psg->state->noise.attenuation][psg->state->noise.real_output_bit];
-		}
+	/* Move the tails of the steps that extend past the end of this chunk to the start of the buffer. */
+	memmove(band_limited->deltas, &band_limited->deltas[total_output_frames], PSG_BAND_LIMITED_KERNEL_TAPS * sizeof(*band_limited->deltas));
+	memset(&band_limited->deltas[PSG_BAND_LIMITED_KERNEL_TAPS], 0, total_output_frames * sizeof(*band_limited->deltas));
+
+	band_limited->time_remainder = time % band_limited->input_sample_rate;
+}
+
+void PSG_UpdateBandLimited(const PSG* const psg, PSG_BandLimited* const band_limited, cc_s16l* const sample_buffer, const size_t total_frames)
+{
+	cc_s16l *sample_buffer_pointer = sample_buffer;
+	size_t frames_remaining = total_frames;
+
+	while (frames_remaining != 0)
+	{
+		const size_t input_frames = CC_MIN(frames_remaining, band_limited->maximum_input_frames);
+		const size_t output_frames = PSG_BandLimited_GetOutputFrames(band_limited, input_frames);
+
+		UpdateBandLimitedChunk(psg, band_limited, sample_buffer_pointer, input_frames);
+
+		sample_buffer_pointer += output_frames;
+		frames_remaining -= input_frames;
 	}
 }
@@ -5,6 +5,7 @@
 
 #include "clowncd/clowncommon/clowncommon.h"
 
+#include "clowncd/audio-common.h"
 #include "clowncd/audio/libraries/clownresampler/clownresampler.h"
 
 #ifdef CLOWNCD_LIBSNDFILE
@@ -44,6 +45,7 @@ typedef struct ClownCD_Audio
 		ClownCD_WAV wav;
 #endif
 	} formats;
+	ClownCD_AudioMetadata metadata;
 	ClownResampler_HighLevel_State resampler;
 } ClownCD_Audio;
 
@@ -637,6 +637,21 @@ typedef struct ClownResampler_LowestLevel_Configuration
 	size_t kernel_step_size;
 } ClownResampler_LowestLevel_Configuration;
 
+/* The kernel of a particular configuration, sampled at every phase that the
+   resampler can evaluate it at, alongside the reciprocal of each phase's
+   normaliser. This turns the convolution for each output frame into a plain
+   dot product over contiguous memory. See 'ClownResampler_Polyphase_Compute'. */
+typedef struct ClownResampler_Polyphase
+{
+	size_t total_phases;
+	size_t taps_per_phase;
+	const cc_s32l *kernels;     /* 'total_phases' * 'taps_per_phase' values. */
+	const cc_s32l *reciprocals; /* 'total_phases' * CLOWNRESAMPLER_POLYPHASE_TAP_COUNTS values. */
+} ClownResampler_Polyphase;
+
+/* The number of taps that an output frame uses can vary by this many. */
+#define CLOWNRESAMPLER_POLYPHASE_TAP_COUNTS 4
+
 typedef struct ClownResampler_LowLevel_State
 {
 	ClownResampler_LowestLevel_Configuration lowest_level;
@@ -645,6 +660,7 @@ typedef struct ClownResampler_LowLevel_State
 	size_t position_integer;
 	cc_u32f position_fractional;            /* 16.16 fixed point. */
 	cc_u32f increment;                      /* 16.16 fixed point. */
+	const ClownResampler_Polyphase *polyphase; /* Optional; see 'ClownResampler_LowLevel_SetPolyphase'. */
 } ClownResampler_LowLevel_State;
 
 typedef struct ClownResampler_HighLevel_State
@@ -687,6 +703,18 @@ CLOWNRESAMPLER_API void ClownResampler_Precompute(ClownResampler_Precomputed *pr
 CLOWNRESAMPLER_API cc_bool ClownResampler_LowestLevel_Configure(ClownResampler_LowestLevel_Configuration *configuration, cc_u32f input_sample_rate, cc_u32f output_sample_rate, cc_u32f low_pass_filter_sample_rate);
 CLOWNRESAMPLER_API void ClownResampler_LowestLevel_Resample(const ClownResampler_LowestLevel_Configuration *configuration, const ClownResampler_Precomputed *precomputed, cc_s32f *output_frame, cc_u8f channels, const cc_s16l *input_buffer, size_t position_integer, cc_u32f position_fractional);
 
+/* Polyphase API.
+   A polyphase table produces exactly the same output as the regular
+   convolution, but more quickly. It only depends upon the configuration, and
+   not the increment, so a resampler whose increment is constantly nudged (for
+   instance, for rate control) can still use one. The caller owns the memory:
+   'ClownResampler_Polyphase_GetBufferSize' returns how many values 'buffer'
+   must have room for, and the table remains valid for as long as 'buffer'
+   does. */
+CLOWNRESAMPLER_API size_t ClownResampler_Polyphase_GetBufferSize(const ClownResampler_LowestLevel_Configuration *configuration);
+CLOWNRESAMPLER_API void ClownResampler_Polyphase_Compute(ClownResampler_Polyphase *polyphase, const ClownResampler_LowestLevel_Configuration *configuration, const ClownResampler_Precomputed *precomputed, cc_s32l *buffer);
+CLOWNRESAMPLER_API void ClownResampler_Polyphase_Resample(const ClownResampler_Polyphase *polyphase, const ClownResampler_LowestLevel_Configuration *configuration, cc_s32f *output_frame, cc_u8f channels, const cc_s16l *input_buffer, size_t position_integer, cc_u32f position_fractional);
+
 #endif /* CLOWNRESAMPLER_GUARD_FUNCTION_DECLARATIONS */
 
 
@@ -718,6 +746,12 @@ CLOWNRESAMPLER_API cc_bool ClownResampler_LowLevel_Init(ClownResampler_LowLevel_
    Returns 'cc_false' on failure, and 'cc_true' otherwise. */
 CLOWNRESAMPLER_API cc_bool ClownResampler_LowLevel_Adjust(ClownResampler_LowLevel_State *resampler, cc_u32f input_sample_rate, cc_u32f output_sample_rate, cc_u32f low_pass_filter_sample_rate);
 
+/* Makes the resampler use a polyphase table, which must have been computed
+   from 'resampler->lowest_level'. Pass NULL to stop using one. Since
+   'ClownResampler_LowLevel_Adjust' changes the configuration, it also detaches
+   the table. */
+CLOWNRESAMPLER_API void ClownResampler_LowLevel_SetPolyphase(ClownResampler_LowLevel_State *resampler, const ClownResampler_Polyphase *polyphase);
+
 /* Resamples (pre-processed) audio. The 'total_input_frames' and
    'total_output_frames' parameters measure the size of their respective
    buffers in frames, not samples nor bytes.
@@ -1034,6 +1068,119 @@ CLOWNRESAMPLER_API void ClownResampler_LowestLevel_Resample(const ClownResampler
 	}
 }
 
+
+/* Polyphase API */
+
+static size_t ClownResampler_Polyphase_GetTotalPhases(const ClownResampler_LowestLevel_Configuration* const configuration)
+{
+	/* In 'ClownResampler_LowestLevel_Resample', the kernel's starting index is derived from a distance that is at least
+	   'stretched_kernel_radius_delta', and less than a whole frame more than that. */
+	return CLOWNRESAMPLER_FIXED_POINT_MULTIPLY(configuration->kernel_step_size, configuration->stretched_kernel_radius_delta + CLOWNRESAMPLER_TO_FIXED_POINT_FROM_INTEGER(1) - 1) + 1;
+}
+
+CLOWNRESAMPLER_API size_t ClownResampler_Polyphase_GetBufferSize(const ClownResampler_LowestLevel_Configuration* const configuration)
+{
+	return ClownResampler_Polyphase_GetTotalPhases(configuration) * (configuration->integer_stretched_kernel_radius * 2 + CLOWNRESAMPLER_POLYPHASE_TAP_COUNTS);
+}
+
+CLOWNRESAMPLER_API void ClownResampler_Polyphase_Compute(ClownResampler_Polyphase* const polyphase, const ClownResampler_LowestLevel_Configuration* const configuration, const ClownResampler_Precomputed* const precomputed, cc_s32l* const buffer)
+{
+	const size_t total_phases = ClownResampler_Polyphase_GetTotalPhases(configuration);
+	const size_t taps_per_phase = configuration->integer_stretched_kernel_radius * 2;
+	cc_s32l* const reciprocals = buffer + total_phases * taps_per_phase;
+
+	size_t phase;
+
+	polyphase->total_phases = total_phases;
+	polyphase->taps_per_phase = taps_per_phase;
+	polyphase->kernels = buffer;
+	polyphase->reciprocals = reciprocals;
+
+	for (phase = 0; phase < total_phases; ++phase)
+	{
+		cc_s32l* const kernel = &buffer[phase * taps_per_phase];
+		cc_s32f sample_normaliser = 0;
+		size_t tap;
+
+		for (tap = 0; tap < taps_per_phase; ++tap)
+		{
+			const size_t kernel_index = phase + tap * configuration->kernel_step_size;
+
+			/* Taps that fall off the end of the kernel are never used by a convolution that reaches them. */
+			kernel[tap] = kernel_index < CLOWNRESAMPLER_COUNT_OF(precomputed->lanczos_kernel_table) ? precomputed->lanczos_kernel_table[kernel_index] : 0;
+			sample_normaliser += (cc_s32f)kernel[tap];
+
+			/* A convolution can end at any of the last few taps, and each one needs its own normaliser.
+			   These are computed exactly as 'ClownResampler_LowestLevel_Resample' computes them. */
+			if (tap + CLOWNRESAMPLER_POLYPHASE_TAP_COUNTS >= taps_per_phase)
+				reciprocals[phase * CLOWNRESAMPLER_POLYPHASE_TAP_COUNTS + taps_per_phase - 1 - tap] = sample_normaliser == 0 ? 0 : 0x80000000 / sample_normaliser;
+		}
+	}
+}
+
+CLOWNRESAMPLER_API void ClownResampler_Polyphase_Resample(const ClownResampler_Polyphase* const polyphase, const ClownResampler_LowestLevel_Configuration* const configuration, cc_s32f* const output_frame, const cc_u8f channels, const cc_s16l* const input_buffer, const size_t position_integer, const cc_u32f position_fractional)
+{
+	/* These are the same bounds as 'ClownResampler_LowestLevel_Resample' uses. */
+	const size_t min_relative = CLOWNRESAMPLER_TO_INTEGER_FROM_FIXED_POINT_CEILING(position_fractional + configuration->stretched_kernel_radius_delta);
+	const size_t max_relative = CLOWNRESAMPLER_TO_INTEGER_FROM_FIXED_POINT_FLOOR(position_fractional + configuration->stretched_kernel_radius);
+	const size_t total_taps = configuration->integer_stretched_kernel_radius + max_relative - min_relative;
+	const size_t phase = CLOWNRESAMPLER_FIXED_POINT_MULTIPLY(configuration->kernel_step_size, (CLOWNRESAMPLER_TO_FIXED_POINT_FROM_INTEGER(min_relative) - position_fractional));
+
+	const cc_s32l* const kernel = &polyphase->kernels[phase * polyphase->taps_per_phase];
+	const cc_s32f sample_normaliser = (cc_s32f)polyphase->reciprocals[phase * CLOWNRESAMPLER_POLYPHASE_TAP_COUNTS + polyphase->taps_per_phase - total_taps];
+	const cc_s16l* const samples = &input_buffer[(position_integer + min_relative) * channels];
+
+	size_t tap;
+	cc_u8f current_channel;
+
+	CLOWNRESAMPLER_ASSERT(phase < polyphase->total_phases);
+	CLOWNRESAMPLER_ASSERT(total_taps <= polyphase->taps_per_phase && polyphase->taps_per_phase - total_taps < CLOWNRESAMPLER_POLYPHASE_TAP_COUNTS);
+
+	/* The kernel is contiguous, so these loops are simple enough for the compiler to vectorise.
+	   Integer addition is associative, so the order that the taps are summed in does not affect the result. */
+	switch (channels)
+	{
+		case 1:
+		{
+			cc_s32f accumulator = 0;
+
+			for (tap = 0; tap < total_taps; ++tap)
+				accumulator += CLOWNRESAMPLER_FIXED_POINT_MULTIPLY((cc_s32f)samples[tap], (cc_s32f)kernel[tap]);
+
+			output_frame[0] = (accumulator * sample_normaliser) / (1 << 15);
+			break;
+		}
+
+		case 2:
+		{
+			cc_s32f left_accumulator = 0, right_accumulator = 0;
+
+			for (tap = 0; tap < total_taps; ++tap)
+			{
+				left_accumulator += CLOWNRESAMPLER_FIXED_POINT_MULTIPLY((cc_s32f)samples[tap * 2 + 0], (cc_s32f)kernel[tap]);
+				right_accumulator += CLOWNRESAMPLER_FIXED_POINT_MULTIPLY((cc_s32f)samples[tap * 2 + 1], (cc_s32f)kernel[tap]);
+			}
+
+			output_frame[0] = (left_accumulator * sample_normaliser) / (1 << 15);
+			output_frame[1] = (right_accumulator * sample_normaliser) / (1 << 15);
+			break;
+		}
+
+		default:
+			for (current_channel = 0; current_channel < channels; ++current_channel)
+			{
+				cc_s32f accumulator = 0;
+
+				for (tap = 0; tap < total_taps; ++tap)
+					accumulator += CLOWNRESAMPLER_FIXED_POINT_MULTIPLY((cc_s32f)samples[tap * channels + current_channel], (cc_s32f)kernel[tap]);
+
+				output_frame[current_channel] = (accumulator * sample_normaliser) / (1 << 15);
+			}
+
+			break;
+	}
+}
+
 #endif /* CLOWNRESAMPLER_GUARD_FUNCTION_DEFINITIONS */
 
 #ifndef CLOWNRESAMPLER_NO_LOW_LEVEL_API
@@ -1046,17 +1193,32 @@ CLOWNRESAMPLER_API cc_bool ClownResampler_LowLevel_Init(ClownResampler_LowLevel_
 	resampler->channels = channels;
 	resampler->position_integer = 0;
 	resampler->position_fractional = 0;
+	resampler->polyphase = NULL;
 	return ClownResampler_LowLevel_Adjust(resampler, input_sample_rate, output_sample_rate, low_pass_filter_sample_rate);
 }
 
 CLOWNRESAMPLER_API cc_bool ClownResampler_LowLevel_Adjust(ClownResampler_LowLevel_State* const resampler, const cc_u32f input_sample_rate, const cc_u32f output_sample_rate, const cc_u32f low_pass_filter_sample_rate)
 {
 	resampler->increment = ClownResampler_CalculateRatio(input_sample_rate, output_sample_rate);
+	resampler->polyphase = NULL;
 	return ClownResampler_LowestLevel_Configure(&resampler->lowest_level, input_sample_rate, output_sample_rate, low_pass_filter_sample_rate);
 }
 
+CLOWNRESAMPLER_API void ClownResampler_LowLevel_SetPolyphase(ClownResampler_LowLevel_State* const resampler, const ClownResampler_Polyphase* const polyphase)
+{
+	CLOWNRESAMPLER_ASSERT(polyphase == NULL || polyphase->taps_per_phase == resampler->lowest_level.integer_stretched_kernel_radius * 2);
+
+	resampler->polyphase = polyphase;
+}
+
 CLOWNRESAMPLER_API cc_bool ClownResampler_LowLevel_Resample(ClownResampler_LowLevel_State* const resampler, const ClownResampler_Precomputed* const precomputed, const cc_s16l* const input_buffer, size_t* const total_input_frames, const ClownResampler_OutputCallback output_callback, const void* const user_data)
 {
+	/* When the input and output rates match exactly and the kernel is not stretched, every tap but the centre one lands on a
+	   zero-crossing of the kernel, so the convolution reduces to copying the centre frame. */
+	const cc_bool passthrough = resampler->increment == CLOWNRESAMPLER_TO_FIXED_POINT_FROM_INTEGER(1)
+		&& resampler->position_fractional == 0
+		&& resampler->lowest_level.stretched_kernel_radius == CLOWNRESAMPLER_TO_FIXED_POINT_FROM_INTEGER(CLOWNRESAMPLER_KERNEL_RADIUS);
+
 	for (;;)
 	{
 		/* Check if we have reached the end of the input buffer. */
@@ -1070,7 +1232,23 @@ CLOWNRESAMPLER_API cc_bool ClownResampler_LowLevel_Resample(ClownResampler_LowLe
 		{
 			cc_s32f samples[CLOWNRESAMPLER_MAXIMUM_CHANNELS] = {0}; /* Sample accumulators. */
 
-			ClownResampler_LowestLevel_Resample(&resampler->lowest_level, precomputed, samples, resampler->channels, input_buffer, resampler->position_integer, resampler->position_fractional);
+			if (passthrough)
+			{
+				const cc_s16l* const frame = &input_buffer[(resampler->position_integer + resampler->lowest_level.integer_stretched_kernel_radius) * resampler->channels];
+
+				cc_u8f current_channel;
+
+				for (current_channel = 0; current_channel < resampler->channels; ++current_channel)
+					samples[current_channel] = frame[current_channel];
+			}
+			else if (resampler->polyphase != NULL)
+			{
+				ClownResampler_Polyphase_Resample(resampler->polyphase, &resampler->lowest_level, samples, resampler->channels, input_buffer, resampler->position_integer, resampler->position_fractional);
+			}
+			else
+			{
+				ClownResampler_LowestLevel_Resample(&resampler->lowest_level, precomputed, samples, resampler->channels, input_buffer, resampler->position_integer, resampler->position_fractional);
+			}
 
 			/* Increment input buffer position. */
 			resampler->position_fractional += resampler->increment;
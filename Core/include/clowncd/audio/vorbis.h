@@ -10,10 +10,32 @@
 
 struct stb_vorbis;
 
+/* An Ogg page that decoding can be resumed from, and the number of the frame that follows its last packet. */
+typedef struct ClownCD_VorbisPage
+{
+	unsigned long position;
+	unsigned long frame;
+} ClownCD_VorbisPage;
+
 typedef struct ClownCD_Vorbis
 {
-	void *file_buffer;
+	ClownCD_File *file;
 	struct stb_vorbis *instance;
+
+	/* The file is streamed through this buffer, which only has to be large enough to hold one packet. */
+	unsigned char *input_buffer;
+	size_t input_buffer_size, input_start, input_end;
+	cc_bool end_of_file;
+
+	/* The last frame that was decoded, and how much of it has been read. */
+	float **output;
+	size_t output_total_frames, output_frames_done;
+	size_t current_frame;
+
+	/* The seek table is only built once it is needed, as playing a track from its start never needs it. */
+	ClownCD_VorbisPage *pages;
+	size_t total_pages;
+	cc_bool pages_built;
 } ClownCD_Vorbis;
 
 cc_bool ClownCD_VorbisOpen(ClownCD_Vorbis *vorbis, ClownCD_File *file, ClownCD_AudioMetadata *metadata);
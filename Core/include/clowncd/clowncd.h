@@ -22,7 +22,8 @@ typedef enum ClownCD_DiscType
 	CLOWNCD_DISC_CUE,
 	CLOWNCD_DISC_RAW_2048,
 	CLOWNCD_DISC_RAW_2352,
-	CLOWNCD_DISC_CLOWNCD
+	CLOWNCD_DISC_CLOWNCD,
+	CLOWNCD_DISC_CLOWNCD_COMPRESSED
 } ClownCD_DiscType;
 
 typedef struct ClownCD
@@ -30,9 +31,15 @@ typedef struct ClownCD
 	char *filename;
 	ClownCD_File file;
 	ClownCD_DiscType type;
+	/* Only used by cue sheet discs. */
+	ClownCD_CueSheet cue_sheet;
+	/* One per file in the cue sheet. A file's handle is kept here while another file is the active track's,
+	   so that switching back to it does not require reopening it. */
+	ClownCD_File *cue_files;
 	struct
 	{
 		ClownCD_File file;
+		size_t cue_file; /* The entry in 'cue_files' that 'file' belongs to, or CLOWNCD_SIZE_INVALID. */
 		ClownCD_CueFileType file_type;
 		ClownCD_CueTrackType type;
 		size_t starting_frame, current_frame, total_frames;
@@ -61,6 +68,7 @@ cc_bool ClownCD_BeginSectorStream(ClownCD* disc);
 size_t ClownCD_ReadSectorStream(ClownCD* disc, unsigned char *buffer, size_t total_bytes);
 cc_bool ClownCD_EndSectorStream(ClownCD* disc);
 size_t ClownCD_ReadSector(ClownCD* disc, unsigned char *buffer);
+size_t ClownCD_ReadSectors(ClownCD* disc, unsigned char *buffer, size_t total_sectors);
 
 size_t ClownCD_ReadFrames(ClownCD *disc, short *buffer, size_t total_frames);
 
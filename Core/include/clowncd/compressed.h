@@ -0,0 +1,34 @@
+#ifndef CLOWNCD_COMPRESSED_H
+#define CLOWNCD_COMPRESSED_H
+
+#include <stddef.h>
+
+#include "clowncd/clowncommon/clowncommon.h"
+
+#include "clowncd/file-io.h"
+
+/* A compressed disc image is a version 1 clowncd image: it has the same identifier, version, and track table as
+   version 0, but these are followed by a hunk map and compressed sector data, instead of the raw sector data.
+   The sector data is split into fixed-size hunks which are compressed separately and checked with a CRC-32,
+   so that any sector can be read by decompressing just the hunk that holds it. */
+
+#define CLOWNCD_COMPRESSED_VERSION 1
+#define CLOWNCD_COMPRESSED_DEFAULT_HUNK_SECTORS 8
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Takes ownership of 'file', which should hold a version 1 image, and replaces it with a read-only stream of the
+   equivalent version 0 image. If the image is not valid, then the file is closed and cc_false is returned. */
+cc_bool ClownCD_CompressedFileOpen(ClownCD_File *file);
+
+/* Compresses the sector data in 'input', from its current position to its end, and writes it to 'output' at its
+   current position, which should be just after the track table. */
+cc_bool ClownCD_CompressedWrite(ClownCD_File *output, ClownCD_File *input, size_t hunk_sectors);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLOWNCD_COMPRESSED_H */
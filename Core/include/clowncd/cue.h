@@ -23,6 +23,35 @@ typedef enum ClownCD_CueTrackType
 	CLOWNCD_CUE_TRACK_AUDIO
 } ClownCD_CueTrackType;
 
+/* Tracks are numbered 1 to 99 on a real disc. */
+#define CLOWNCD_CUE_MAXIMUM_TRACKS 100
+
+typedef struct ClownCD_CueSheetFile
+{
+	char *filename;
+	ClownCD_CueFileType type;
+} ClownCD_CueSheetFile;
+
+typedef struct ClownCD_CueSheetTrackIndex
+{
+	size_t file; /* Index into the sheet's 'files'. */
+	unsigned int track, index;
+	ClownCD_CueTrackType type;
+	unsigned long starting_sector, ending_sector;
+} ClownCD_CueSheetTrackIndex;
+
+/* A cue sheet parsed up-front, so that seeking to a track does not involve reparsing it. */
+typedef struct ClownCD_CueSheet
+{
+	ClownCD_CueSheetFile *files;
+	size_t total_files;
+	/* Grouped by track, in the order that they appear in the sheet. */
+	ClownCD_CueSheetTrackIndex *track_indices;
+	size_t total_track_indices;
+	/* Track N's entries in 'track_indices' start at 'first_track_index[N]' and end at 'first_track_index[N + 1]'. */
+	size_t first_track_index[CLOWNCD_CUE_MAXIMUM_TRACKS + 1];
+} ClownCD_CueSheet;
+
 typedef void (*ClownCD_CueCallback)(void *user_data, const char *filename, ClownCD_CueFileType file_type, unsigned int track, ClownCD_CueTrackType track_type, unsigned int index, unsigned long sector);
 
 cc_bool ClownCD_CueParse(ClownCD_File *file, ClownCD_CueCallback callback, const void *user_data);
@@ -30,4 +59,9 @@ cc_bool ClownCD_CueGetTrackIndexInfo(ClownCD_File *file, unsigned int track, uns
 unsigned long ClownCD_CueGetTrackIndexEndingSector(ClownCD_File *file, const char *track_index_filename, unsigned int track, unsigned int index, unsigned long starting_sector);
 #define ClownCD_CueIsValid(file) ClownCD_CueParse(file, NULL, NULL)
 
+void ClownCD_CueSheetInitialise(ClownCD_CueSheet *sheet);
+cc_bool ClownCD_CueSheetLoad(ClownCD_CueSheet *sheet, ClownCD_File *file);
+void ClownCD_CueSheetFree(ClownCD_CueSheet *sheet);
+const ClownCD_CueSheetTrackIndex* ClownCD_CueSheetFind(const ClownCD_CueSheet *sheet, unsigned int track, unsigned int index);
+
 #endif /* CLOWNCD_CUE_H */
@@ -37,6 +37,15 @@ typedef struct ClownCD_File
 	cc_bool eof;
 } ClownCD_File;
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Returns callbacks that memory-map files which are opened for reading, so that reads become plain copies.
+   Files that cannot be mapped, files opened for writing, and platforms without 'mmap' use buffered stdio instead.
+   Pass these to 'ClownCD_Open' (rather than opening the stream yourself) to use them for a disc. */
+const ClownCD_FileCallbacks* ClownCD_GetMappedFileCallbacks(void);
+
 ClownCD_File ClownCD_FileOpenBlank(void);
 ClownCD_File ClownCD_FileOpen(const char *filename, ClownCD_FileMode mode, const ClownCD_FileCallbacks *callbacks);
 ClownCD_File ClownCD_FileOpenAlreadyOpen(void *stream, const ClownCD_FileCallbacks *callbacks);
@@ -57,6 +66,10 @@ unsigned long ClownCD_ReadUintFile(ClownCD_File *file, unsigned int total_bytes,
 signed long ClownCD_ReadSintMemory(const unsigned char *buffer, unsigned int total_bytes, cc_bool big_endian);
 signed long ClownCD_ReadSintFile(ClownCD_File *file, unsigned int total_bytes, cc_bool big_endian);
 
+#ifdef __cplusplus
+}
+#endif
+
 #define ClownCD_WriteU16LEMemory(buffer, value) ClownCD_WriteUintMemory(buffer, value, 2, cc_false)
 #define ClownCD_WriteU32LEMemory(buffer, value) ClownCD_WriteUintMemory(buffer, value, 4, cc_false)
 
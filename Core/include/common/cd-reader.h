@@ -47,6 +47,7 @@ cc_bool CDReader_IsOpen(const CDReader_State *state);
 cc_bool CDReader_SeekToSector(CDReader_State *state, CDReader_SectorIndex sector_index);
 cc_bool CDReader_SeekToFrame(CDReader_State *state, CDReader_FrameIndex frame_index);
 cc_bool CDReader_ReadSector(CDReader_State *state, cc_u16l *buffer);
+cc_u32f CDReader_ReadSectors(CDReader_State *state, cc_u16l *buffer, cc_u32f total_sectors);
 cc_bool CDReader_PlayAudio(CDReader_State *state, CDReader_TrackIndex track_index, CDReader_PlaybackSetting setting);
 cc_u32f CDReader_ReadAudio(CDReader_State *state, cc_s16l *sample_buffer, cc_u32f total_frames);
 void CDReader_GetStateBackup(CDReader_State *state, CDReader_StateBackup *backup);
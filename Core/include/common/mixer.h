@@ -2,42 +2,95 @@
 
 #include "core/clowncommon/clowncommon.h"
 #include "core/clownmdemu.h"
+#include "clowncd/audio/libraries/clownresampler/clownresampler.h"
 
 #ifndef MIXER_HEADER
 #define MIXER_HEADER
 
-#define MIXER_OUTPUT_SAMPLE_RATE CLOWNMDEMU_PSG_SAMPLE_RATE_NTSC
+#define MIXER_DEFAULT_OUTPUT_SAMPLE_RATE 48000
+#define MIXER_MAXIMUM_OUTPUT_SAMPLE_RATE 96000
 #define MIXER_DIVIDE_BY_LOWEST_FRAMERATE CLOWNMDEMU_DIVIDE_BY_PAL_FRAMERATE
-#define MIXER_MAXIMUM_AUDIO_FRAMES_PER_FRAME MIXER_DIVIDE_BY_LOWEST_FRAMERATE(MIXER_OUTPUT_SAMPLE_RATE)
+/* The '+1' covers the band-limited PSG, which can produce one frame more than the output rate implies. */
+#define MIXER_MAXIMUM_AUDIO_FRAMES_PER_FRAME (1 + MIXER_DIVIDE_BY_LOWEST_FRAMERATE(MIXER_MAXIMUM_OUTPUT_SAMPLE_RATE))
 #define MIXER_CHANNEL_COUNT CC_MAX(CC_MAX(CC_MAX(CLOWNMDEMU_FM_CHANNEL_COUNT, CLOWNMDEMU_PSG_CHANNEL_COUNT), CLOWNMDEMU_PCM_CHANNEL_COUNT), CLOWNMDEMU_CDDA_CHANNEL_COUNT)
 
 #define MIXER_FIXED_POINT_FRACTIONAL_SIZE (1 << 16)
 #define MIXER_TO_FIXED_POINT_FROM_INTEGER(X) ((X) * MIXER_FIXED_POINT_FRACTIONAL_SIZE)
 #define MIXER_FIXED_POINT_MULTIPLY(MULTIPLICAND, MULTIPLIER) ((MULTIPLICAND) * (MULTIPLIER) / MIXER_FIXED_POINT_FRACTIONAL_SIZE)
 
+/* Gains are 8.8 fixed point. */
+#define MIXER_GAIN_UNITY (1 << 8)
+#define MIXER_MAXIMUM_GAIN (MIXER_GAIN_UNITY * 4)
+/* Volumes are 20.12 fixed point, which leaves enough headroom for a resampled sample at the maximum gain. */
+#define MIXER_VOLUME_UNITY (1 << 12)
+
+typedef enum Mixer_SourceID
+{
+	MIXER_SOURCE_FM,
+	MIXER_SOURCE_PSG,
+	MIXER_SOURCE_PCM,
+	MIXER_SOURCE_CDDA,
+	MIXER_SOURCE_TOTAL
+} Mixer_SourceID;
+
 typedef struct Mixer_Source
 {
+	ClownResampler_LowLevel_State resampler;
+	/* The resampler's kernel, rearranged so that each output frame is a single contiguous dot product. */
+	ClownResampler_Polyphase polyphase;
+	cc_s32l *polyphase_buffer;
+	cc_bool resampled;
 	cc_u8f channels;
+	cc_s32f volume_divisor;
+	/* The per-channel multipliers that the source is mixed with, combining the gain, pan, and volume divisor. */
+	cc_s32f volumes[MIXER_CHANNEL_COUNT];
 	cc_s16l *buffer;
 	size_t capacity;
+	/* The number of frames kept from the previous frame for the resampler to read around its kernel. */
+	size_t padding;
 	size_t write_index;
+	/* The frames before this belong to the frame that the next 'Mixer_End' will output. */
+	size_t frame_end;
+	cc_bool frame_ended;
 } Mixer_Source;
 
 typedef struct Mixer_State
 {
+	ClownResampler_Precomputed resampler_precomputed;
 	Mixer_Source fm, psg, pcm, cdda;
+	cc_bool pal_mode;
+	cc_u32f output_sample_rate;
+	cc_u32f output_frames_remainder;
+	/* When enabled, the PSG is synthesised directly at the output sample rate, so it does not need resampling. */
+	cc_bool psg_band_limited_enabled;
+	PSG_BandLimited psg_band_limited;
+	/* Each source is resampled into 'resampled_buffer' before being added to 'mix_buffer'. */
+	/* Both are wide enough that loud mixes can be saturated instead of wrapping. */
+	cc_s32l resampled_buffer[MIXER_MAXIMUM_AUDIO_FRAMES_PER_FRAME * MIXER_CHANNEL_COUNT];
+	cc_s32l mix_buffer[MIXER_MAXIMUM_AUDIO_FRAMES_PER_FRAME * MIXER_CHANNEL_COUNT];
 } Mixer_State;
 
-typedef void (*Mixer_Callback)(void *user_data, const cc_s16l *audio_samples, size_t total_frames);
-
-cc_bool Mixer_Initialise(Mixer_State *state, cc_bool pal_mode);
+/* Every source is resampled to 'output_sample_rate', which should be the rate of the audio device. */
+/* 'psg_band_limited' selects the band-limited PSG synthesiser, which outputs at that rate directly. */
+cc_bool Mixer_Initialise(Mixer_State *state, cc_bool pal_mode, cc_u32f output_sample_rate, cc_bool psg_band_limited);
 void Mixer_Deinitialise(Mixer_State *state);
+/* Each call to 'Mixer_Begin' must be paired with a call to 'Mixer_End', since that decides which frames 'Mixer_Begin' then discards. */
 void Mixer_Begin(Mixer_State *state);
 cc_s16l* Mixer_AllocateFMSamples(Mixer_State *state, size_t total_frames);
 cc_s16l* Mixer_AllocatePSGSamples(Mixer_State *state, size_t total_frames);
+void Mixer_GeneratePSGSamples(Mixer_State *state, const ClownMDEmu *clownmdemu, size_t total_frames, void (*generate_psg_audio)(const ClownMDEmu *clownmdemu, cc_s16l *sample_buffer, size_t total_frames));
 cc_s16l* Mixer_AllocatePCMSamples(Mixer_State *state, size_t total_frames);
 cc_s16l* Mixer_AllocateCDDASamples(Mixer_State *state, size_t total_frames);
-void Mixer_End(Mixer_State *state, Mixer_Callback callback, const void *user_data);
+/* Marks everything allocated so far for this source as belonging to the frame that the next 'Mixer_End' will output, */
+/* holding anything allocated afterwards over to the frame after. Sources that are not marked are ended by 'Mixer_End' itself. */
+/* This allows one source to lag a frame behind the others, such as when it is being synthesised on another thread. */
+void Mixer_EndSourceFrame(Mixer_State *state, Mixer_SourceID source_id);
+/* 'output_buffer' must have room for MIXER_MAXIMUM_AUDIO_FRAMES_PER_FRAME frames. Returns the number of frames written to it. */
+size_t Mixer_End(Mixer_State *state, cc_s16l *output_buffer);
+cc_u32f Mixer_GetOutputSampleRate(const Mixer_State *state);
+/* 'gain' is 8.8 fixed point, up to MIXER_MAXIMUM_GAIN. 'pan' ranges from -MIXER_GAIN_UNITY (left) to MIXER_GAIN_UNITY (right). */
+/* Both are reset to unity and the centre by 'Mixer_Initialise'. */
+void Mixer_SetSourceGain(Mixer_State *state, Mixer_SourceID source_id, cc_u32f gain, cc_s32f pan);
 
 #ifdef __cplusplus
 
@@ -50,22 +103,41 @@ void Mixer_End(Mixer_State *state, Mixer_Callback callback, const void *user_dat
 
 #include <cassert>
 #include <cstddef>
-#if MIXER_CPLUSPLUS >= 201103L
-#include <functional>
-#endif
 
 class Mixer
 {
 protected:
 	Mixer_State state;
 	bool initialised;
+	bool pal_mode;
+	cc_u32f output_sample_rate;
+	bool psg_band_limited;
+	cc_u32f gains[MIXER_SOURCE_TOTAL];
+	cc_s32f pans[MIXER_SOURCE_TOTAL];
 
-public:
-	typedef Mixer_Callback Callback;
+	void Reinitialise()
+	{
+		Mixer_Deinitialise(&state);
+		initialised = Mixer_Initialise(&state, pal_mode, output_sample_rate, psg_band_limited);
 
-	Mixer(const bool pal_mode)
+		// Reinitialising resets the gains, so reapply them.
+		for (std::size_t i = 0; i < MIXER_SOURCE_TOTAL; ++i)
+			Mixer_SetSourceGain(&state, static_cast<Mixer_SourceID>(i), gains[i], pans[i]);
+	}
+
+public:
+	Mixer(const bool pal_mode, const cc_u32f output_sample_rate = MIXER_DEFAULT_OUTPUT_SAMPLE_RATE, const bool psg_band_limited = false)
+		: pal_mode(pal_mode)
+		, output_sample_rate(output_sample_rate)
+		, psg_band_limited(psg_band_limited)
 	{
-		initialised = Mixer_Initialise(&state, pal_mode);
+		for (std::size_t i = 0; i < MIXER_SOURCE_TOTAL; ++i)
+		{
+			gains[i] = MIXER_GAIN_UNITY;
+			pans[i] = 0;
+		}
+
+		initialised = Mixer_Initialise(&state, pal_mode, output_sample_rate, psg_band_limited);
 	}
 	Mixer(const Mixer &other) = delete;
 	Mixer(Mixer &&other) = delete;
@@ -101,6 +173,12 @@ public:
 		return Mixer_AllocatePSGSamples(&state, total_frames);
 	}
 
+	void GeneratePSGSamples(const ClownMDEmu* const clownmdemu, const std::size_t total_frames, void (* const generate_psg_audio)(const ClownMDEmu *clownmdemu, cc_s16l *sample_buffer, std::size_t total_frames))
+	{
+		assert(Initialised());
+		Mixer_GeneratePSGSamples(&state, clownmdemu, total_frames, generate_psg_audio);
+	}
+
 	cc_s16l* AllocatePCMSamples(const std::size_t total_frames)
 	{
 		assert(Initialised());
@@ -113,31 +191,52 @@ public:
 		return Mixer_AllocateCDDASamples(&state, total_frames);
 	}
 
-	void End(const Callback callback, const void* const user_data)
+	void EndSourceFrame(const Mixer_SourceID source_id)
 	{
 		assert(Initialised());
-		Mixer_End(&state, callback, user_data);
+		Mixer_EndSourceFrame(&state, source_id);
 	}
 
-#if MIXER_CPLUSPLUS >= 201103L
-	using CallbackFunctional = std::function<void(const cc_s16l *audio_samples, std::size_t total_frames)>;
-	void End(const CallbackFunctional &callback)
+	// 'output_buffer' must have room for MIXER_MAXIMUM_AUDIO_FRAMES_PER_FRAME frames.
+	std::size_t End(cc_s16l* const output_buffer)
 	{
-		End(
-			[](void* const user_data, const cc_s16l* const audio_samples, const std::size_t total_frames)
-			{
-				const auto &callback = *static_cast<const CallbackFunctional*>(user_data);
-				callback(audio_samples, total_frames);
-			}, &callback
-		);
+		assert(Initialised());
+		return Mixer_End(&state, output_buffer);
+	}
+
+	cc_u32f GetOutputSampleRate() const
+	{
+		assert(Initialised());
+		return Mixer_GetOutputSampleRate(&state);
 	}
-#endif
 
 	void SetPALMode(const bool enabled)
 	{
 		assert(Initialised());
-		Mixer_Deinitialise(&state);
-		initialised = Mixer_Initialise(&state, enabled);
+		pal_mode = enabled;
+		Reinitialise();
+	}
+
+	void SetOutputSampleRate(const cc_u32f sample_rate)
+	{
+		assert(Initialised());
+		output_sample_rate = sample_rate;
+		Reinitialise();
+	}
+
+	void SetPSGBandLimited(const bool enabled)
+	{
+		assert(Initialised());
+		psg_band_limited = enabled;
+		Reinitialise();
+	}
+
+	void SetSourceGain(const Mixer_SourceID source_id, const cc_u32f gain, const cc_s32f pan)
+	{
+		assert(Initialised());
+		gains[source_id] = gain;
+		pans[source_id] = pan;
+		Mixer_SetSourceGain(&state, source_id, gain, pan);
 	}
 };
 
@@ -174,20 +273,69 @@ public:
 
 /* Mixer Source */
 
-static cc_bool Mixer_Source_Initialise(Mixer_Source* const source, const cc_u8f channels, const cc_u32f input_sample_rate)
+static void Mixer_Source_SetGain(Mixer_Source* const source, const cc_u32f gain, const cc_s32f pan)
 {
+	const cc_s32f left_pan = pan > 0 ? MIXER_GAIN_UNITY - pan : MIXER_GAIN_UNITY;
+	const cc_s32f right_pan = pan < 0 ? MIXER_GAIN_UNITY + pan : MIXER_GAIN_UNITY;
+	/* The gain and pan multiply to 16.16, which is reduced to the volumes' precision. */
+	const cc_s32f divisor = MIXER_GAIN_UNITY * MIXER_GAIN_UNITY / MIXER_VOLUME_UNITY * source->volume_divisor;
+
+	MIXER_ASSERT(gain <= MIXER_MAXIMUM_GAIN);
+	MIXER_ASSERT(pan >= -MIXER_GAIN_UNITY && pan <= MIXER_GAIN_UNITY);
+
+	source->volumes[0] = (cc_s32f)gain * left_pan / divisor;
+	source->volumes[1] = (cc_s32f)gain * right_pan / divisor;
+}
+
+static cc_bool Mixer_Source_Initialise(Mixer_Source* const source, const ClownResampler_Precomputed* const precomputed, const cc_u8f channels, const cc_s32f volume_divisor, const cc_u32f input_sample_rate, const cc_u32f output_sample_rate, const cc_bool resampled)
+{
+	source->resampled = resampled;
 	source->channels = channels;
+	source->volume_divisor = volume_divisor;
+	Mixer_Source_SetGain(source, MIXER_GAIN_UNITY, 0);
 	/* The '+1' is just a lazy way of performing a rough ceiling division. */
-	source->capacity = 1 + MIXER_DIVIDE_BY_LOWEST_FRAMERATE(input_sample_rate);
-	source->buffer = (cc_s16l*)MIXER_CALLOC(1, (1 + source->capacity) * source->channels * sizeof(cc_s16l));
+	/* There is room for two frames, so that one can be held over by 'Mixer_EndSourceFrame'. */
+	source->capacity = (1 + MIXER_DIVIDE_BY_LOWEST_FRAMERATE(input_sample_rate)) * 2;
+	source->padding = 0;
 	source->write_index = 0;
+	source->frame_end = 0;
+	source->frame_ended = cc_false;
+	source->polyphase_buffer = NULL;
+
+	if (resampled)
+	{
+		/* The low-pass filter is placed at the output rate, to prevent aliasing when downsampling. */
+		if (!ClownResampler_LowLevel_Init(&source->resampler, channels, input_sample_rate, output_sample_rate, output_sample_rate))
+			return cc_false;
 
-	return source->buffer != NULL;
+		/* The resampler reads this many frames either side of the one that it is outputting. */
+		source->padding = source->resampler.lowest_level.integer_stretched_kernel_radius * 2;
+
+		/* The increment is stretched every frame, but the kernel is not, so one table serves every frame. */
+		source->polyphase_buffer = (cc_s32l*)MIXER_CALLOC(ClownResampler_Polyphase_GetBufferSize(&source->resampler.lowest_level), sizeof(cc_s32l));
+
+		if (source->polyphase_buffer == NULL)
+			return cc_false;
+
+		ClownResampler_Polyphase_Compute(&source->polyphase, &source->resampler.lowest_level, precomputed, source->polyphase_buffer);
+		ClownResampler_LowLevel_SetPolyphase(&source->resampler, &source->polyphase);
+	}
+
+	source->buffer = (cc_s16l*)MIXER_CALLOC(1, (source->padding + source->capacity) * source->channels * sizeof(cc_s16l));
+
+	if (source->buffer == NULL)
+	{
+		MIXER_FREE(source->polyphase_buffer);
+		return cc_false;
+	}
+
+	return cc_true;
 }
 
 static void Mixer_Source_Deinitialise(Mixer_Source* const source)
 {
 	MIXER_FREE(source->buffer);
+	MIXER_FREE(source->polyphase_buffer);
 }
 
 static cc_s16l* Mixer_Source_Buffer(Mixer_Source* const source, const size_t index)
@@ -197,21 +345,37 @@ static cc_s16l* Mixer_Source_Buffer(Mixer_Source* const source, const size_t ind
 
 static void Mixer_Source_NewFrame(Mixer_Source* const source)
 {
+	/* Discard the frame that was output by the last 'Mixer_End', leaving anything that was held over. */
+	const size_t total_frames_kept = source->write_index - source->frame_end;
+
+	source->frame_ended = cc_false;
+
+	/* Sources that are not in use, such as the Mega CD's when it is detached, have nothing to discard. */
+	if (source->frame_end == 0)
+		return;
+
 	/* To make the resampler happy, we need to maintain some padding frames. */
 	/* See clownresampler's documentation for more information. */
 
-	/* Copy the end of each buffer to its beginning, since we never used all of it. */
-	MIXER_MEMMOVE(source->buffer, Mixer_Source_Buffer(source, source->write_index), 1 * source->channels * sizeof(cc_s16l));
+	/* Copy the end of each buffer to its beginning, since the resampler has not finished with it. */
+	MIXER_MEMMOVE(source->buffer, Mixer_Source_Buffer(source, source->frame_end), (source->padding + total_frames_kept) * source->channels * sizeof(cc_s16l));
 
 	/* Blank the remainder of the buffers so that they can be mixed into. */
-	MIXER_MEMSET(Mixer_Source_Buffer(source, 1), 0, source->write_index * source->channels * sizeof(cc_s16l));
+	MIXER_MEMSET(Mixer_Source_Buffer(source, source->padding + total_frames_kept), 0, source->frame_end * source->channels * sizeof(cc_s16l));
 
-	source->write_index = 0;
+	source->write_index = total_frames_kept;
+	source->frame_end = 0;
+}
+
+static void Mixer_Source_EndFrame(Mixer_Source* const source)
+{
+	source->frame_end = source->write_index;
+	source->frame_ended = cc_true;
 }
 
 static cc_s16l* Mixer_Source_AllocateFrames(Mixer_Source* const source, const size_t total_frames)
 {
-	cc_s16l* const allocated_samples = Mixer_Source_Buffer(source, 1 + source->write_index);
+	cc_s16l* const allocated_samples = Mixer_Source_Buffer(source, source->padding + source->write_index);
 
 	source->write_index += total_frames;
 
@@ -220,28 +384,98 @@ static cc_s16l* Mixer_Source_AllocateFrames(Mixer_Source* const source, const si
 	return allocated_samples;
 }
 
-static size_t Mixer_Source_GetTotalAllocatedFrames(const Mixer_Source* const source)
+typedef struct Mixer_Source_OutputCallbackData
 {
-	return source->write_index;
+	cc_s32l *output_pointer;
+	size_t output_frames_remaining;
+} Mixer_Source_OutputCallbackData;
+
+static cc_bool Mixer_Source_OutputCallback(void* const user_data, const cc_s32f* const frame, const cc_u8f total_samples)
+{
+	Mixer_Source_OutputCallbackData* const callback_data = (Mixer_Source_OutputCallbackData*)user_data;
+
+	/* Mono sources are output to both channels. */
+	callback_data->output_pointer[0] = frame[0];
+	callback_data->output_pointer[1] = frame[total_samples - 1];
+	callback_data->output_pointer += MIXER_CHANNEL_COUNT;
+
+	return --callback_data->output_frames_remaining != 0;
 }
 
-static void Mixer_Source_GetFrame(Mixer_Source* const source, cc_s16f* const frame, const cc_u32f position)
+/* Produces up to 'output_length' stereo frames at the output rate, and returns how many were produced. */
+static size_t Mixer_Source_Resample(Mixer_Source* const source, const ClownResampler_Precomputed* const precomputed, cc_s32l* const output_buffer, const size_t output_length)
 {
-	const cc_u8f total_channels = source->channels;
-	const cc_u32f position_integral = position / MIXER_FIXED_POINT_FRACTIONAL_SIZE;
-	const cc_u32f frame_position = position_integral * total_channels;
+	size_t total_input_frames = source->frame_end;
 
-	cc_u8f i;
+	if (total_input_frames == 0 || output_length == 0)
+		return 0;
+
+	if (!source->resampled)
+	{
+		/* This source is already at the output rate, so it only needs widening. */
+		const size_t total_frames = CC_MIN(total_input_frames, output_length);
+		const cc_u8f last_channel = source->channels - 1;
+
+		size_t i;
 
-	for (i = 0; i < total_channels; ++i)
+		for (i = 0; i < total_frames; ++i)
+		{
+			const cc_s16l* const frame = Mixer_Source_Buffer(source, i);
+
+			output_buffer[i * MIXER_CHANNEL_COUNT + 0] = frame[0];
+			output_buffer[i * MIXER_CHANNEL_COUNT + 1] = frame[last_channel];
+		}
+
+		return total_frames;
+	}
+	else
 	{
-		const cc_u32f sample_position = frame_position + i;
-		const cc_s16f sample_base = source->buffer[sample_position];
+		/* Stretch this frame's input to exactly fill the output, starting from wherever the previous frame left off. */
+		/* Rounding the increment up guarantees that the resampler reaches the end of the input on the final output frame, */
+		/* and recalculating it every frame stops the leftover fraction from accumulating. */
+		const cc_u32f input_distance = MIXER_TO_FIXED_POINT_FROM_INTEGER(total_input_frames) - source->resampler.position_fractional;
+		const cc_u32f output_length_u32 = output_length;
+
+		Mixer_Source_OutputCallbackData callback_data;
+
+		callback_data.output_pointer = output_buffer;
+		callback_data.output_frames_remaining = output_length;
 
-		frame[i] = sample_base;
+		MIXER_ASSERT(source->resampler.position_integer == 0);
+
+		source->resampler.increment = CC_DIVIDE_CEILING(input_distance, output_length_u32);
+		ClownResampler_LowLevel_Resample(&source->resampler, precomputed, source->buffer, &total_input_frames, Mixer_Source_OutputCallback, &callback_data);
+
+		return output_length - callback_data.output_frames_remaining;
 	}
 }
 
+/* Mix Buffer */
+
+/* These loops are kept trivial so that the compiler can vectorise them. */
+
+static void Mixer_AddToMix(cc_s32l* const mix_buffer, const cc_s32l* const samples, const cc_s32f* const volumes, const size_t total_frames)
+{
+	const cc_s32f left_volume = volumes[0];
+	const cc_s32f right_volume = volumes[1];
+
+	size_t i;
+
+	for (i = 0; i < total_frames * MIXER_CHANNEL_COUNT; i += MIXER_CHANNEL_COUNT)
+	{
+		mix_buffer[i + 0] += samples[i + 0] * left_volume / MIXER_VOLUME_UNITY;
+		mix_buffer[i + 1] += samples[i + 1] * right_volume / MIXER_VOLUME_UNITY;
+	}
+}
+
+static void Mixer_Saturate(cc_s16l* const output_buffer, const cc_s32l* const mix_buffer, const size_t total_frames)
+{
+	size_t i;
+
+	for (i = 0; i < total_frames * MIXER_CHANNEL_COUNT; ++i)
+		output_buffer[i] = CC_CLAMP(-0x8000, 0x7FFF, mix_buffer[i]);
+}
+
 /* Mixer API */
 
 static cc_u32f Mixer_GetCorrectedSampleRate(const cc_u32f sample_rate_ntsc, const cc_u32f sample_rate_pal, const cc_bool pal_mode)
@@ -251,17 +485,33 @@ static cc_u32f Mixer_GetCorrectedSampleRate(const cc_u32f sample_rate_ntsc, cons
 		: CLOWNMDEMU_MULTIPLY_BY_NTSC_FRAMERATE(CLOWNMDEMU_DIVIDE_BY_NTSC_FRAMERATE(sample_rate_ntsc));
 }
 
-cc_bool Mixer_Initialise(Mixer_State* const state, const cc_bool pal_mode)
+cc_bool Mixer_Initialise(Mixer_State* const state, const cc_bool pal_mode, const cc_u32f output_sample_rate, const cc_bool psg_band_limited)
 {
 	const cc_u32f fm_sample_rate = Mixer_GetCorrectedSampleRate(CLOWNMDEMU_FM_SAMPLE_RATE_NTSC, CLOWNMDEMU_FM_SAMPLE_RATE_PAL, pal_mode);
-	const cc_u32f psg_sample_rate = Mixer_GetCorrectedSampleRate(CLOWNMDEMU_PSG_SAMPLE_RATE_NTSC, CLOWNMDEMU_PSG_SAMPLE_RATE_PAL, pal_mode);
+	const cc_u32f psg_native_sample_rate = Mixer_GetCorrectedSampleRate(CLOWNMDEMU_PSG_SAMPLE_RATE_NTSC, CLOWNMDEMU_PSG_SAMPLE_RATE_PAL, pal_mode);
+	/* The band-limited synthesiser outputs directly at the output rate, so the PSG buffer only needs to be big enough for that. */
+	const cc_u32f psg_sample_rate = psg_band_limited ? output_sample_rate : psg_native_sample_rate;
 	const cc_u32f pcm_sample_rate = Mixer_GetCorrectedSampleRate(CLOWNMDEMU_PCM_SAMPLE_RATE, CLOWNMDEMU_PCM_SAMPLE_RATE, pal_mode);
 	const cc_u32f cdda_sample_rate = Mixer_GetCorrectedSampleRate(CLOWNMDEMU_CDDA_SAMPLE_RATE, CLOWNMDEMU_CDDA_SAMPLE_RATE, pal_mode);
 
-	const cc_bool fm_success = Mixer_Source_Initialise(&state->fm, CLOWNMDEMU_FM_CHANNEL_COUNT, fm_sample_rate);
-	const cc_bool psg_success = Mixer_Source_Initialise(&state->psg, CLOWNMDEMU_PSG_CHANNEL_COUNT, psg_sample_rate);
-	const cc_bool pcm_success = Mixer_Source_Initialise(&state->pcm, CLOWNMDEMU_PCM_CHANNEL_COUNT, pcm_sample_rate);
-	const cc_bool cdda_success = Mixer_Source_Initialise(&state->cdda, CLOWNMDEMU_CDDA_CHANNEL_COUNT, cdda_sample_rate);
+	cc_bool fm_success, psg_success, pcm_success, cdda_success;
+
+	MIXER_ASSERT(output_sample_rate != 0 && output_sample_rate <= MIXER_MAXIMUM_OUTPUT_SAMPLE_RATE);
+
+	ClownResampler_Precompute(&state->resampler_precomputed);
+
+	fm_success = Mixer_Source_Initialise(&state->fm, &state->resampler_precomputed, CLOWNMDEMU_FM_CHANNEL_COUNT, CLOWNMDEMU_FM_VOLUME_DIVISOR, fm_sample_rate, output_sample_rate, cc_true);
+	psg_success = Mixer_Source_Initialise(&state->psg, &state->resampler_precomputed, CLOWNMDEMU_PSG_CHANNEL_COUNT, CLOWNMDEMU_PSG_VOLUME_DIVISOR, psg_sample_rate, output_sample_rate, !psg_band_limited);
+	pcm_success = Mixer_Source_Initialise(&state->pcm, &state->resampler_precomputed, CLOWNMDEMU_PCM_CHANNEL_COUNT, CLOWNMDEMU_PCM_VOLUME_DIVISOR, pcm_sample_rate, output_sample_rate, cc_true);
+	cdda_success = Mixer_Source_Initialise(&state->cdda, &state->resampler_precomputed, CLOWNMDEMU_CDDA_CHANNEL_COUNT, CLOWNMDEMU_CDDA_VOLUME_DIVISOR, cdda_sample_rate, output_sample_rate, cc_true);
+
+	state->pal_mode = pal_mode;
+	state->output_sample_rate = output_sample_rate;
+	state->output_frames_remainder = 0;
+	state->psg_band_limited_enabled = psg_band_limited;
+
+	if (state->psg_band_limited_enabled)
+		PSG_BandLimited_Initialise(&state->psg_band_limited, psg_native_sample_rate, output_sample_rate);
 
 	if (fm_success && psg_success && pcm_success && cdda_success)
 		return cc_true;
@@ -304,6 +554,20 @@ cc_s16l* Mixer_AllocatePSGSamples(Mixer_State* const state, const size_t total_f
 	return Mixer_Source_AllocateFrames(&state->psg, total_frames);
 }
 
+void Mixer_GeneratePSGSamples(Mixer_State* const state, const ClownMDEmu* const clownmdemu, const size_t total_frames, void (* const generate_psg_audio)(const ClownMDEmu *clownmdemu, cc_s16l *sample_buffer, size_t total_frames))
+{
+	if (state->psg_band_limited_enabled)
+	{
+		const size_t output_frames = PSG_BandLimited_GetOutputFrames(&state->psg_band_limited, total_frames);
+
+		ClownMDEmu_GeneratePSGAudioBandLimited(clownmdemu, &state->psg_band_limited, Mixer_Source_AllocateFrames(&state->psg, output_frames), total_frames);
+	}
+	else
+	{
+		generate_psg_audio(clownmdemu, Mixer_Source_AllocateFrames(&state->psg, total_frames), total_frames);
+	}
+}
+
 cc_s16l* Mixer_AllocatePCMSamples(Mixer_State* const state, const size_t total_frames)
 {
 	return Mixer_Source_AllocateFrames(&state->pcm, total_frames);
@@ -314,45 +578,100 @@ cc_s16l* Mixer_AllocateCDDASamples(Mixer_State* const state, const size_t total_
 	return Mixer_Source_AllocateFrames(&state->cdda, total_frames);
 }
 
-void Mixer_End(Mixer_State* const state, const Mixer_Callback callback, const void* const user_data)
+static Mixer_Source* Mixer_GetSource(Mixer_State* const state, const Mixer_SourceID source_id)
 {
-	const size_t available_fm_frames = Mixer_Source_GetTotalAllocatedFrames(&state->fm);
-	const size_t available_psg_frames = Mixer_Source_GetTotalAllocatedFrames(&state->psg);
-	const size_t available_pcm_frames = Mixer_Source_GetTotalAllocatedFrames(&state->pcm);
-	const size_t available_cdda_frames = Mixer_Source_GetTotalAllocatedFrames(&state->cdda);
+	switch (source_id)
+	{
+		case MIXER_SOURCE_FM:
+			return &state->fm;
+
+		case MIXER_SOURCE_PSG:
+			return &state->psg;
 
-	/* By orienting everything around the PSG, we avoid the need to resample the PSG! */
-	const cc_u32f output_length = available_psg_frames;
+		case MIXER_SOURCE_PCM:
+			return &state->pcm;
 
-	const cc_u32f fm_ratio = MIXER_TO_FIXED_POINT_FROM_INTEGER(available_fm_frames) / output_length;
-	const cc_u32f pcm_ratio = MIXER_TO_FIXED_POINT_FROM_INTEGER(available_pcm_frames) / output_length;
-	const cc_u32f cdda_ratio = MIXER_TO_FIXED_POINT_FROM_INTEGER(available_cdda_frames) / output_length;
+		case MIXER_SOURCE_CDDA:
+			return &state->cdda;
 
-	cc_s16l output_buffer[MIXER_MAXIMUM_AUDIO_FRAMES_PER_FRAME * MIXER_CHANNEL_COUNT];
-	cc_s16l *output_buffer_pointer = output_buffer;
-	cc_u32f fm_position, pcm_position, cdda_position;
-	cc_u32f i;
+		case MIXER_SOURCE_TOTAL:
+			break;
+	}
+
+	MIXER_ASSERT(cc_false);
+	return NULL;
+}
 
-	/* Resample, mix, and output the audio for this frame. */
-	for (i = 0, fm_position = 0, pcm_position = 0, cdda_position = 0; i < output_length; ++i, fm_position += fm_ratio, pcm_position += pcm_ratio, cdda_position += cdda_ratio)
+void Mixer_EndSourceFrame(Mixer_State* const state, const Mixer_SourceID source_id)
+{
+	Mixer_Source_EndFrame(Mixer_GetSource(state, source_id));
+}
+
+size_t Mixer_End(Mixer_State* const state, cc_s16l* const output_buffer)
+{
+	Mixer_Source* const sources[MIXER_SOURCE_TOTAL] = {&state->fm, &state->psg, &state->pcm, &state->cdda};
+
+	cc_bool empty = cc_true;
+	cc_u32f output_length;
+	cc_u8f i;
+
+	/* End whichever sources were not ended early. */
+	for (i = 0; i < MIXER_SOURCE_TOTAL; ++i)
 	{
-		cc_s16f fm_frame[CLOWNMDEMU_FM_CHANNEL_COUNT];
-		cc_s16f pcm_frame[CLOWNMDEMU_PCM_CHANNEL_COUNT];
-		cc_s16f cdda_frame[CLOWNMDEMU_CDDA_CHANNEL_COUNT];
-
-		Mixer_Source_GetFrame(&state->fm, fm_frame, fm_position);
-		Mixer_Source_GetFrame(&state->pcm, pcm_frame, pcm_position);
-		Mixer_Source_GetFrame(&state->cdda, cdda_frame, cdda_position);
-
-		/* Mix the FM, PSG, PCM, and CDDA to produce the final audio. */
-		*output_buffer_pointer = fm_frame[0] / CLOWNMDEMU_FM_VOLUME_DIVISOR + state->psg.buffer[i] / CLOWNMDEMU_PSG_VOLUME_DIVISOR + pcm_frame[0] / CLOWNMDEMU_PCM_VOLUME_DIVISOR + cdda_frame[0] / CLOWNMDEMU_CDDA_VOLUME_DIVISOR;
-		++output_buffer_pointer;
-		*output_buffer_pointer = fm_frame[1] / CLOWNMDEMU_FM_VOLUME_DIVISOR + state->psg.buffer[i] / CLOWNMDEMU_PSG_VOLUME_DIVISOR + pcm_frame[1] / CLOWNMDEMU_PCM_VOLUME_DIVISOR + cdda_frame[1] / CLOWNMDEMU_CDDA_VOLUME_DIVISOR;
-		++output_buffer_pointer;
+		if (!sources[i]->frame_ended)
+			Mixer_Source_EndFrame(sources[i]);
+
+		if (sources[i]->frame_end != 0)
+			empty = cc_false;
 	}
 
-	/* Output resampled and mixed samples. */
-	callback((void*)user_data, output_buffer, output_length);
+	/* There is no frame to output until at least one source has produced something for it, */
+	/* which happens when a lagging source has held every other source's first frame over. */
+	if (empty)
+		return 0;
+
+	if (state->psg_band_limited_enabled)
+	{
+		/* The band-limited PSG is already at the output rate, so everything else is orientated around it. */
+		output_length = state->psg.frame_end;
+	}
+	else
+	{
+		/* Produce the output rate's worth of frames for one video frame, carrying the remainder over to the next. */
+		/* The NTSC framerate is 60000/1001. */
+		const cc_u32f numerator = state->output_frames_remainder + state->output_sample_rate * (state->pal_mode ? 1 : 1001);
+		const cc_u32f denominator = state->pal_mode ? 50 : 60000;
+
+		output_length = numerator / denominator;
+		state->output_frames_remainder = numerator % denominator;
+	}
+
+	MIXER_ASSERT(output_length <= MIXER_MAXIMUM_AUDIO_FRAMES_PER_FRAME);
+
+	MIXER_MEMSET(state->mix_buffer, 0, output_length * MIXER_CHANNEL_COUNT * sizeof(*state->mix_buffer));
+
+	/* Resample and mix the FM, PSG, PCM, and CDDA to produce the final audio. */
+	for (i = 0; i < MIXER_SOURCE_TOTAL; ++i)
+	{
+		const size_t total_frames = Mixer_Source_Resample(sources[i], &state->resampler_precomputed, state->resampled_buffer, output_length);
+
+		Mixer_AddToMix(state->mix_buffer, state->resampled_buffer, sources[i]->volumes, total_frames);
+	}
+
+	/* Clamp the mix instead of letting it wrap. */
+	Mixer_Saturate(output_buffer, state->mix_buffer, output_length);
+
+	return output_length;
+}
+
+cc_u32f Mixer_GetOutputSampleRate(const Mixer_State* const state)
+{
+	return state->output_sample_rate;
+}
+
+void Mixer_SetSourceGain(Mixer_State* const state, const Mixer_SourceID source_id, const cc_u32f gain, const cc_s32f pan)
+{
+	Mixer_Source_SetGain(Mixer_GetSource(state, source_id), gain, pan);
 }
 
 #endif /* MIXER_IMPLEMENTATION */
@@ -6,6 +6,13 @@
 #include "core/clownmdemu.h"
 #include "core/io-port.h"
 
+/* With CLOWNMDEMU_CARTRIDGE_ONLY, this is a constant, letting the compiler throw away everything that is done for the Mega CD. */
+#ifdef CLOWNMDEMU_CARTRIDGE_ONLY
+#define MEGA_CD_ATTACHED(clownmdemu) cc_false
+#else
+#define MEGA_CD_ATTACHED(clownmdemu) ((clownmdemu)->mega_cd_state != NULL && !(clownmdemu)->configuration->general.mega_cd_detached)
+#endif
+
 typedef struct SyncState
 {
 	cc_u32f current_cycle;
@@ -17,6 +24,24 @@ typedef struct SyncCPUState
 	cc_u32l *cycle_countdown;
 } SyncCPUState;
 
+/* Used to spot the SUB-CPU spinning in a loop that is waiting for something outside of it to change. */
+typedef struct SubCPUIdleState
+{
+	Clown68000_State registers; /* The SUB-CPU as it was at the top of the loop. */
+	cc_u32f target_cycle;
+	cc_u32f loop_cycles;
+	cc_bool monitoring;
+	cc_bool disturbed; /* Set when the loop has done something that might not turn out the same way next time. */
+} SubCPUIdleState;
+
+/* Used to hand the SUB-CPU over to the frontend's other thread, and to get it back again. */
+typedef struct SubCPUThreadState
+{
+	cc_u32f horizon;         /* The furthest that the other thread has been allowed to run the SUB-CPU. */
+	cc_bool released;        /* Set while the other thread may be running the SUB-CPU. */
+	cc_bool on_other_thread; /* Set while the SUB-CPU is being run by the other thread. */
+} SubCPUThreadState;
+
 typedef struct CPUCallbackUserData
 {
 	const ClownMDEmu *clownmdemu;
@@ -26,11 +51,14 @@ typedef struct CPUCallbackUserData
 		SyncCPUState z80;
 		SyncCPUState mcd_m68k;
 		SyncCPUState mcd_m68k_irq3;
+		SyncCPUState mcd_graphics;
 		SyncState fm;
 		SyncState psg;
 		SyncState pcm;
 		SyncState io_ports[3];
 	} sync;
+	SubCPUIdleState mcd_m68k_idle;
+	SubCPUThreadState mcd_m68k_thread;
 } CPUCallbackUserData;
 
 typedef struct CycleMegaDrive
@@ -65,6 +93,8 @@ cc_u32f SyncCommon(SyncState *sync, cc_u32f target_cycle, cc_u32f clock_divisor)
 void SyncCPUCommon(const ClownMDEmu *clownmdemu, SyncCPUState *sync, cc_u32f target_cycle, cc_bool cpu_not_running, SyncCPUCommonCallback callback, const void *user_data);
 cc_u8f SyncFM(CPUCallbackUserData *other_state, CycleMegaDrive target_cycle);
 void SyncPSG(CPUCallbackUserData *other_state, CycleMegaDrive target_cycle);
+void WritePSG(CPUCallbackUserData *other_state, CycleMegaDrive target_cycle, cc_u8f command);
+void GeneratePSGAudioFromLog(const ClownMDEmu *clownmdemu, const ClownMDEmu_PSGLog *log);
 void SyncPCM(CPUCallbackUserData *other_state, CycleMegaCD target_cycle);
 void SyncCDDA(CPUCallbackUserData *other_state, cc_u32f total_frames);
 
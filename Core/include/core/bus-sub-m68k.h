@@ -5,6 +5,8 @@
 
 /* TODO: Rename these to 'SubM68k'. */
 void SyncMCDM68k(const ClownMDEmu *clownmdemu, CPUCallbackUserData *other_state, CycleMegaCD target_cycle);
+void ReleaseMCDM68k(const ClownMDEmu *clownmdemu, CPUCallbackUserData *other_state, CycleMegaCD ending_cycle);
+void SyncMCDM68kOnOtherThread(CPUCallbackUserData *other_state);
 cc_u16f MCDM68kReadCallbackWithCycle(const void *user_data, cc_u32f address, cc_bool do_high_byte, cc_bool do_low_byte, CycleMegaCD target_cycle);
 cc_u16f MCDM68kReadCallback(const void *user_data, cc_u32f address, cc_bool do_high_byte, cc_bool do_low_byte);
 void MCDM68kWriteCallbackWithCycle(const void *user_data, cc_u32f address, cc_bool do_high_byte, cc_bool do_low_byte, cc_u16f value, CycleMegaCD target_cycle);
@@ -36,6 +36,9 @@ void CDC_Stop(CDC* cdc);
 cc_bool CDC_Stat(CDC* cdc, CDC_SectorReadCallback callback, const void *user_data);
 cc_bool CDC_Read(CDC* cdc, CDC_SectorReadCallback callback, const void *user_data, cc_u32l *header);
 cc_u16f CDC_HostData(CDC* cdc, cc_bool is_sub_cpu);
+/* Hands out all of the remaining host data at once, straight from the sector buffer, with the same effect as
+   calling 'CDC_HostData' until 'CDC_Mode' says that there is no more. Returns the number of words, and sets 'words' to NULL if that is 0. */
+cc_u16f CDC_HostDataSpan(CDC* cdc, cc_bool is_sub_cpu, const cc_u16l **words);
 void CDC_Ack(CDC* cdc);
 void CDC_Seek(CDC* cdc, CDC_SectorReadCallback callback, const void* user_data, cc_u32f sector, cc_u32f total_sectors);
 cc_u16f CDC_Mode(CDC* cdc, cc_bool is_sub_cpu);
@@ -24,10 +24,11 @@ extern "C" {
 
 /* TODO: Documentation. */
 
-#define CLOWNMDEMU_PARAMETERS_INITIALISE(CONFIGURATION, CONSTANT, STATE, CALLBACKS) { \
+#define CLOWNMDEMU_PARAMETERS_INITIALISE(CONFIGURATION, CONSTANT, STATE, MEGA_CD_STATE, CALLBACKS) { \
 		(CONFIGURATION), \
 		(CONSTANT), \
 		(STATE), \
+		(MEGA_CD_STATE), \
 		(CALLBACKS), \
 \
 		&(STATE)->m68k.state, \
@@ -37,7 +38,7 @@ extern "C" {
 			&(STATE)->z80.state \
 		}, \
 \
-		&(STATE)->mega_cd.m68k.state, \
+		&(MEGA_CD_STATE)->m68k.state, \
 \
 		{ \
 			&(CONFIGURATION)->vdp, \
@@ -59,7 +60,7 @@ extern "C" {
 \
 		{ \
 			&(CONFIGURATION)->pcm, \
-			&(STATE)->mega_cd.pcm \
+			&(MEGA_CD_STATE)->pcm \
 		} \
 	}
 
@@ -151,6 +152,11 @@ typedef struct ClownMDEmu_Configuration
 		ClownMDEmu_Region region;
 		ClownMDEmu_TVStandard tv_standard;
 		cc_bool low_pass_filter_disabled;
+		cc_bool sub_cpu_idle_skipping_disabled;
+		/* Leaves the console as a plain Mega Drive, which is faster for cartridge games as the Mega CD does not have to be emulated alongside them. */
+		/* This is implied when there is no 'ClownMDEmu_MegaCDState'. Building the emulator with CLOWNMDEMU_CARTRIDGE_ONLY defined does
+		   this permanently, and compiles the Mega CD's code paths out. */
+		cc_bool mega_cd_detached;
 	} general;
 
 	VDP_Configuration vdp;
@@ -167,108 +173,115 @@ typedef struct ClownMDEmu_Constant
 	PSG_Constant psg;
 } ClownMDEmu_Constant;
 
+/* The state of the Mega Drive itself. The registers that are used the most come first, and the large memories last. */
 typedef struct ClownMDEmu_State
 {
+	cc_u16l current_scanline;
+	cc_bool boot_from_cd; /* Set when the Mega CD's BIOS, rather than the cartridge, is at the start of memory. */
+	cc_u8l cartridge_bankswitch[8];
+
 	struct
 	{
 		Clown68000_State state;
-		cc_u16l ram[0x8000];
 		cc_u32l cycle_countdown;
 		cc_bool h_int_pending, v_int_pending;
+		cc_u16l ram[0x8000];
 	} m68k;
 
 	struct
 	{
 		Z80_State state;
-		cc_u8l ram[0x2000];
 		cc_u32l cycle_countdown;
 		cc_u16l bank;
 		cc_bool bus_requested;
 		cc_bool reset_held;
+		cc_u8l ram[0x2000];
 	} z80;
 
-	VDP_State vdp;
-	FM_State fm;
-	PSG_State psg;
 	IOPort io_ports[3];
 	Controller controllers[2];
+	FM_State fm;
+	PSG_State psg;
+
+	struct
+	{
+		LowPassFilter_FirstOrder_State fm[2];
+		LowPassFilter_FirstOrder_State psg[1];
+		LowPassFilter_SecondOrder_State pcm[2];
+	} low_pass_filters;
+
+	VDP_State vdp;
 
 	struct
 	{
-		cc_u8l buffer[0x10000]; /* 64 KiB is the maximum that I have ever seen used (by homebrew). */
 		cc_u32l size;
 		cc_bool non_volatile;
 		cc_u8l data_size;
 		cc_u8l device_type;
 		cc_bool mapped_in;
+		cc_u32l dirty_start, dirty_end; /* The bytes of 'buffer' that have been written to since 'ClownMDEmu_TakeExternalRAMDirtyRange' was last called. */
+		cc_u8l buffer[0x10000]; /* 64 KiB is the maximum that I have ever seen used (by homebrew). */
 	} external_ram;
+} ClownMDEmu_State;
 
-	cc_u8l cartridge_bankswitch[8];
+/* The state of the Mega CD, which is kept apart from the Mega Drive's, as it is several times larger and cartridge games have no use for it. */
+typedef struct ClownMDEmu_MegaCDState
+{
+	struct
+	{
+		Clown68000_State state;
+		cc_u32l cycle_countdown;
+		cc_bool bus_requested;
+		cc_bool reset_held;
+	} m68k;
 
-	cc_u16l current_scanline;
+	struct
+	{
+		cc_u16l flag;
+		cc_u16l command[8]; /* The MAIN-CPU one. */
+		cc_u16l status[8];  /* The SUB-CPU one. */
+	} communication;
 
 	struct
 	{
-		struct
-		{
-			Clown68000_State state;
-			cc_u32l cycle_countdown;
-			cc_bool bus_requested;
-			cc_bool reset_held;
-		} m68k;
-
-		struct
-		{
-			cc_u16l buffer[0x40000];
-			cc_u8l bank;
-			cc_u8l write_protect;
-		} prg_ram;
-
-		struct
-		{
-			cc_u16l buffer[0x20000];
-			cc_bool in_1m_mode;
-			cc_bool dmna, ret;
-		} word_ram;
-
-		struct
-		{
-			cc_u16l flag;
-			cc_u16l command[8]; /* The MAIN-CPU one. */
-			cc_u16l status[8];  /* The SUB-CPU one. */
-		} communication;
-
-		struct
-		{
-			cc_bool enabled[6];
-			cc_bool irq1_pending;
-			cc_u32l irq3_countdown, irq3_countdown_master;
-		} irq;
-
-		/* TODO: Just convert this to a plain array? Presumably, that's what the original hardware does. */
-		struct
-		{
-			cc_bool large_stamp_map, large_stamp, repeating_stamp_map;
-			cc_u16l stamp_map_address, image_buffer_address, image_buffer_width;
-			cc_u8l image_buffer_height, image_buffer_height_in_tiles, image_buffer_x_offset, image_buffer_y_offset;
-		} rotation;
-
-		CDC cdc;
-		CDDA cdda;
-		PCM_State pcm;
-
-		cc_bool boot_from_cd;
-		cc_u16l hblank_address;
-		cc_u16l delayed_dma_word;
-	} mega_cd;
+		cc_bool enabled[6];
+		cc_u32l irq3_countdown, irq3_countdown_master;
+	} irq;
 
+	/* TODO: Just convert this to a plain array? Presumably, that's what the original hardware does. */
 	struct
 	{
-		LowPassFilter_FirstOrder_State fm[2];
-		LowPassFilter_FirstOrder_State psg[1];
-		LowPassFilter_SecondOrder_State pcm[2];
-	} low_pass_filters;
-} ClownMDEmu_State;
+		cc_bool large_stamp_map, large_stamp, repeating_stamp_map;
+		cc_u16l stamp_map_address, image_buffer_address, image_buffer_width;
+		cc_u8l image_buffer_height, image_buffer_height_in_tiles, image_buffer_x_offset, image_buffer_y_offset;
+
+		/* The graphics operation in progress, which is drawn a line at a time. The countdown is 0 when there is none. */
+		cc_u16l trace_table_address;
+		cc_u8l image_buffer_line;
+		cc_u32l cycle_countdown;
+	} rotation;
+
+	cc_u16l hblank_address;
+	cc_u16l delayed_dma_word;
+
+	PCM_State pcm;
+	CDDA cdda;
+	CDC cdc;
+
+	struct
+	{
+		cc_u8l bank;
+		cc_u8l write_protect;
+		cc_u16l buffer[0x40000];
+	} prg_ram;
+
+	struct
+	{
+		cc_bool in_1m_mode;
+		cc_bool dmna, ret;
+		cc_u16l buffer[0x20000];
+	} word_ram;
+} ClownMDEmu_MegaCDState;
 
 struct ClownMDEmu;
 
@@ -293,20 +306,58 @@ typedef struct ClownMDEmu_Callbacks
 	cc_bool (*cd_track_seeked)(void *user_data, cc_u16f track_index, ClownMDEmu_CDDAMode mode);
 	CDDA_AudioReadCallback cd_audio_read;
 
+	/* Save files are read and written a span of bytes at a time. 'save_file_read' returns how many bytes it read, which is only fewer than 'total_bytes' at the end of the file. */
 	cc_bool (*save_file_opened_for_reading)(void *user_data, const char *filename);
-	cc_s16f (*save_file_read)(void *user_data);
+	size_t (*save_file_read)(void *user_data, cc_u8l *buffer, size_t total_bytes);
 	cc_bool (*save_file_opened_for_writing)(void *user_data, const char *filename);
-	void (*save_file_written)(void *user_data, cc_u8f byte);
+	void (*save_file_written)(void *user_data, const cc_u8l *buffer, size_t total_bytes);
 	void (*save_file_closed)(void *user_data);
 	cc_bool (*save_file_removed)(void *user_data, const char *filename);
 	cc_bool (*save_file_size_obtained)(void *user_data, const char *filename, size_t *size);
 } ClownMDEmu_Callbacks;
 
+/* Comfortably more writes than the 68000 and Z80 can perform in a single PAL frame. */
+#define CLOWNMDEMU_PSG_LOG_MAXIMUM_WRITES 0x8000
+
+typedef struct ClownMDEmu_PSGLog_Write
+{
+	cc_u16l frame; /* The number of PSG frames between the start of the video frame and this write. */
+	cc_u8l command;
+} ClownMDEmu_PSGLog_Write;
+
+/* A video frame's worth of PSG writes, so that its audio can be synthesised later (and on another thread) by 'ClownMDEmu_GeneratePSGAudioFromLog'. */
+typedef struct ClownMDEmu_PSGLog
+{
+	size_t total_writes;
+	size_t total_frames;
+	ClownMDEmu_PSGLog_Write writes[CLOWNMDEMU_PSG_LOG_MAXIMUM_WRITES];
+} ClownMDEmu_PSGLog;
+
+/* A video frame's worth of statistics on the SUB-CPU's idle loops, which 'ClownMDEmu_Iterate' skips over instead of emulating. */
+typedef struct ClownMDEmu_SubCPUIdleStatistics
+{
+	cc_u32l polls;          /* Times that the SUB-CPU came back around a loop that looked like it might be polling. */
+	cc_u32l polls_skipped;  /* Times that the loop was found to be idle, so that the SUB-CPU could be skipped ahead. */
+	cc_u32l cycles_skipped; /* Mega CD master cycles that were skipped rather than emulated. */
+} ClownMDEmu_SubCPUIdleStatistics;
+
+/* Lets the SUB-CPU be run on another thread, alongside the rest of the emulation. */
+/* 'released' is called when there is work for the other thread, which it should do by passing 'job' to 'ClownMDEmu_RunSubCPU'.
+   'reclaimed' is called when the work is needed, and must not return until 'ClownMDEmu_RunSubCPU' has. */
+/* Each 'released' is followed by a 'reclaimed' before the next 'released', and before 'ClownMDEmu_Iterate' returns. */
+typedef struct ClownMDEmu_SubCPUThread
+{
+	const void *user_data;
+	void (*released)(void *user_data, void *job);
+	void (*reclaimed)(void *user_data);
+} ClownMDEmu_SubCPUThread;
+
 typedef struct ClownMDEmu
 {
 	const ClownMDEmu_Configuration *configuration;
 	const ClownMDEmu_Constant *constant;
 	ClownMDEmu_State *state;
+	ClownMDEmu_MegaCDState *mega_cd_state; /* NULL when there is no Mega CD. */
 	const ClownMDEmu_Callbacks *callbacks;
 
 	Clown68000_State *m68k;
@@ -316,16 +367,43 @@ typedef struct ClownMDEmu
 	FM fm;
 	PSG psg;
 	PCM pcm;
+
+	/* When this is not NULL, 'ClownMDEmu_Iterate' records PSG writes here instead of applying them, and does not generate any PSG audio. */
+	/* Unlike the FM and PCM, nothing can be read back from the PSG, so its synthesis is free to lag behind the rest of the emulation. */
+	ClownMDEmu_PSGLog *psg_log;
+
+	/* When this is not NULL, 'ClownMDEmu_Iterate' fills it with statistics on the SUB-CPU's idle loops. */
+	ClownMDEmu_SubCPUIdleStatistics *sub_cpu_idle_statistics;
+
+	/* When this is not NULL, 'ClownMDEmu_Iterate' hands the SUB-CPU to another thread whenever it can. */
+	/* The CD, save file, and PCM audio callbacks may then be called from the other thread instead, but never from both threads at once. */
+	/* The log callback, however, can be called from both threads at the same time, so it must be thread-safe. */
+	const ClownMDEmu_SubCPUThread *sub_cpu_thread;
 } ClownMDEmu;
 
 typedef void (*ClownMDEmu_LogCallback)(void *user_data, const char *format, va_list arg);
 
 void ClownMDEmu_Constant_Initialise(ClownMDEmu_Constant *constant);
 void ClownMDEmu_State_Initialise(ClownMDEmu_State *state);
-void ClownMDEmu_Parameters_Initialise(ClownMDEmu *clownmdemu, const ClownMDEmu_Configuration *configuration, const ClownMDEmu_Constant *constant, ClownMDEmu_State *state, const ClownMDEmu_Callbacks *callbacks);
+void ClownMDEmu_MegaCDState_Initialise(ClownMDEmu_MegaCDState *state);
+/* 'mega_cd_state' can be NULL, leaving the Mega CD detached. Unlike this function, 'CLOWNMDEMU_PARAMETERS_INITIALISE' does not allow that. */
+void ClownMDEmu_Parameters_Initialise(ClownMDEmu *clownmdemu, const ClownMDEmu_Configuration *configuration, const ClownMDEmu_Constant *constant, ClownMDEmu_State *state, ClownMDEmu_MegaCDState *mega_cd_state, const ClownMDEmu_Callbacks *callbacks);
 void ClownMDEmu_Iterate(const ClownMDEmu *clownmdemu);
 void ClownMDEmu_Reset(const ClownMDEmu *clownmdemu, cc_bool cd_boot, cc_u32f cartridge_size);
 void ClownMDEmu_SetLogCallback(const ClownMDEmu_LogCallback log_callback, const void *user_data);
+/* Gives the bytes of 'state->external_ram.buffer' that the game has written to since this was last called, from 'start' up to (but not including) 'end'. */
+/* This lets a frontend save only what has changed, as often as it likes. Returns cc_false if nothing has been written. */
+cc_bool ClownMDEmu_TakeExternalRAMDirtyRange(const ClownMDEmu *clownmdemu, cc_u32f *start, cc_u32f *end);
+
+/* An alternative to the 'generate_psg_audio' function that is passed to the 'psg_audio_to_be_generated' callback. */
+/* Rather than outputting 'total_frames' frames at the PSG's native sample rate, this outputs
+   'PSG_BandLimited_GetOutputFrames(band_limited, total_frames)' frames at the band-limited synthesiser's sample rate. */
+void ClownMDEmu_GeneratePSGAudioBandLimited(const ClownMDEmu *clownmdemu, PSG_BandLimited *band_limited, cc_s16l *sample_buffer, size_t total_frames);
+/* Applies the writes in 'log' to the PSG, producing its audio through the 'psg_audio_to_be_generated' callback exactly as 'ClownMDEmu_Iterate' would have. */
+/* Only the PSG state is touched, so this may run on another thread while the next frame is being emulated, as long as logs are replayed in order. */
+void ClownMDEmu_GeneratePSGAudioFromLog(const ClownMDEmu *clownmdemu, const ClownMDEmu_PSGLog *log);
+/* Does the work that was handed over by the 'released' callback of 'ClownMDEmu_SubCPUThread'. This is meant to be called from another thread. */
+void ClownMDEmu_RunSubCPU(void *job);
 
 #ifdef __cplusplus
 }
@@ -5,6 +5,9 @@
 
 #include "core/clowncommon/clowncommon.h"
 
+/* The most channels that a single call can filter. */
+#define LOW_PASS_FILTER_MAXIMUM_CHANNELS 2
+
 #define LOW_PASS_FILTER_FIXED_BASE (1 << 16)
 #define LOW_PASS_FILTER_FIXED_MULTIPLY(MULTIPLICANT, MULTIPLIER) ((MULTIPLICANT) * (cc_s32f)(MULTIPLIER) / LOW_PASS_FILTER_FIXED_BASE)
 #define LOW_PASS_FILTER_COMPUTE_FIXED(x, OUTPUT_COEFFICIENT) (cc_s32f)CC_DIVIDE_ROUND(x * LOW_PASS_FILTER_FIXED_BASE, OUTPUT_COEFFICIENT)
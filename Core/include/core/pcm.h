@@ -45,6 +45,8 @@ void PCM_WriteRegister(const PCM *pcm, cc_u16f reg, cc_u8f value);
 cc_u8f PCM_ReadRegister(const PCM *pcm, cc_u8f reg);
 cc_u8f PCM_ReadWaveRAM(const PCM* pcm, cc_u16f address);
 void PCM_WriteWaveRAM(const PCM* pcm, cc_u16f address, cc_u8f value);
+/* Writes each word as two bytes, high byte first. The words must not run past the end of the bank. */
+void PCM_WriteWaveRAMWords(const PCM* pcm, cc_u16f address, const cc_u16l *words, cc_u16f total_words);
 void PCM_Update(const PCM *pcm, cc_s16l *sample_buffer, size_t total_frames);
 
 #ifdef __cplusplus
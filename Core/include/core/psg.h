@@ -9,6 +9,13 @@
 extern "C" {
 #endif
 
+/* The resolution of the band-limited step table. */
+#define PSG_BAND_LIMITED_KERNEL_PHASES 32
+#define PSG_BAND_LIMITED_KERNEL_TAPS 16
+#define PSG_BAND_LIMITED_KERNEL_UNITY (1 << 14)
+/* The maximum number of output frames that are produced per internal chunk. */
+#define PSG_BAND_LIMITED_BUFFER_SIZE 0x400
+
 typedef enum PSG_NoiseType
 {
 	PSG_NOISE_TYPE_PERIODIC,
@@ -70,6 +77,7 @@ typedef struct PSG_Configuration
 typedef struct PSG_Constant
 {
 	cc_s16l volumes[0x10][2];
+	cc_s16l band_limited_steps[PSG_BAND_LIMITED_KERNEL_PHASES][PSG_BAND_LIMITED_KERNEL_TAPS];
 } PSG_Constant;
 
 typedef struct PSG_State
@@ -84,6 +92,20 @@ typedef struct PSG_State
 	PSG_LatchedCommand latched_command;
 } PSG_State;
 
+typedef struct PSG_BandLimited
+{
+	cc_u32l input_sample_rate, output_sample_rate;
+	/* The fractional output frame that was left over by the previous update, in units of 1/input_sample_rate. */
+	cc_u32l time_remainder;
+	size_t maximum_input_frames;
+	/* The running total of the band-limited steps. */
+	cc_s32l accumulator;
+	/* The current level of each channel, so that changes in level can be detected. */
+	cc_s16l levels[4];
+	/* The steps themselves, with room for the tails of steps which extend past the end of the chunk. */
+	cc_s32l deltas[PSG_BAND_LIMITED_BUFFER_SIZE + PSG_BAND_LIMITED_KERNEL_TAPS];
+} PSG_BandLimited;
+
 typedef struct PSG
 {
 	const PSG_Configuration *configuration;
@@ -105,6 +127,18 @@ void PSG_DoCommand(const PSG *psg, cc_u8f command);
 /* The samples are mono and in signed 16-bit PCM format. */
 void PSG_Update(const PSG *psg, cc_s16l *sample_buffer, size_t total_frames);
 
+/* Initialises a band-limited synthesiser, which converts the PSG's output to a lower sample rate without aliasing. */
+/* 'input_sample_rate' is the PSG's native sample rate, and 'output_sample_rate' is the rate that samples will be output at. */
+void PSG_BandLimited_Initialise(PSG_BandLimited *band_limited, cc_u32f input_sample_rate, cc_u32f output_sample_rate);
+
+/* Returns how many frames the next call to 'PSG_UpdateBandLimited' will output for the given number of native frames. */
+size_t PSG_BandLimited_GetOutputFrames(const PSG_BandLimited *band_limited, size_t total_input_frames);
+
+/* Like 'PSG_Update', but 'total_frames' native frames are converted to the band-limited synthesiser's output sample rate. */
+/* The number of frames that are output is given by 'PSG_BandLimited_GetOutputFrames'. */
+/* This is cheaper than 'PSG_Update' and avoids aliasing, but it is not sample-accurate. */
+void PSG_UpdateBandLimited(const PSG *psg, PSG_BandLimited *band_limited, cc_s16l *sample_buffer, size_t total_frames);
+
 #ifdef __cplusplus
 }
 #endif
@@ -27,6 +27,10 @@ NS_ASSUME_NONNULL_BEGIN
 -(BOOL) isPaused;
 -(void) stop;
 
+-(NSDictionary<NSString *, NSNumber *> *) sectorCacheStatistics;
+-(NSDictionary<NSString *, NSNumber *> *) cdAudioStatistics;
+-(NSDictionary<NSString *, NSNumber *> *) subCPUIdleStatistics;
+
 -(void) updateSettings;
 
 -(void) input:(NSInteger)slot button:(uint32_t)button pressed:(BOOL)pressed;
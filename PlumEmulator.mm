@@ -23,6 +23,9 @@
 #include <thread>
 #include <vector>
 
+#include "CDAudioStream.h"
+#include "CDSectorCache.h"
+#include "WorkerThread.h"
 #include "common/cd-reader.h"
 #define MIXER_IMPLEMENTATION
 #include "common/mixer.h"
@@ -39,9 +42,12 @@ struct Object {
     
     ClownMDEmu emu;
     ClownMDEmu_State emu_state;
+    std::unique_ptr<ClownMDEmu_MegaCDState> mega_cd_state;
     
     ClownCD_FileCallbacks reader_callbacks;
     CDReader_State reader_state;
+    CDSectorCache sector_cache;
+    CDAudioStream audio_stream;
     
     AudioOutput output;
     
@@ -54,9 +60,21 @@ struct Object {
     
     std::jthread thread;
     std::atomic<bool> paused;
+    std::atomic<bool> band_limited_psg;
+    std::atomic<bool> deferred_psg;
     std::mutex mutex;
     std::condition_variable_any cv;
     
+    // Filled in by the core every frame, and copied out for the UI once the frame is done.
+    ClownMDEmu_SubCPUIdleStatistics sub_cpu_idle_statistics;
+    ClownMDEmu_SubCPUIdleStatistics last_sub_cpu_idle_statistics;
+    std::mutex statistics_mutex;
+    
+    // When enabled, the SUB-CPU is run on a thread of its own, alongside everything else.
+    std::atomic<bool> threaded_sub_cpu;
+    ClownMDEmu_SubCPUThread sub_cpu_thread_callbacks;
+    WorkerThread sub_cpu_thread;
+    
     std::array<std::map<SGButton, bool>, 2> buttons;
 } object;
 
@@ -85,7 +103,25 @@ struct Object {
 }
 
 -(NSArray<NSString *> *) insertCartridge:(NSURL *)url {
-    ClownMDEmu_Parameters_Initialise(&object.emu, &object.configuration, &object.constant, &object.emu_state, &object.callbacks);
+    NSString *extension = [url.pathExtension lowercaseString];
+    const bool is_disc = [extension isEqualToString:@"cue"];
+    
+    // A cartridge can never be played alongside a disc, so the Mega CD's state is only allocated for discs.
+    if (!is_disc)
+        object.mega_cd_state.reset();
+    else if (object.mega_cd_state == nullptr)
+        object.mega_cd_state = std::make_unique<ClownMDEmu_MegaCDState>();
+    
+    ClownMDEmu_Parameters_Initialise(&object.emu, &object.configuration, &object.constant, &object.emu_state, object.mega_cd_state.get(), &object.callbacks);
+    object.emu.sub_cpu_idle_statistics = &object.sub_cpu_idle_statistics;
+    
+    object.sub_cpu_thread_callbacks.user_data = &object;
+    object.sub_cpu_thread_callbacks.released = [](void* user_data, void* job) {
+        ((Object*)user_data)->sub_cpu_thread.Run([job]() { ClownMDEmu_RunSubCPU(job); });
+    };
+    object.sub_cpu_thread_callbacks.reclaimed = [](void* user_data) {
+        ((Object*)user_data)->sub_cpu_thread.Wait();
+    };
     
     object.callbacks.cartridge_read = [](void* user_data, cc_u32f address) -> cc_u8f {
         Object* object = (Object*)user_data;
@@ -133,7 +169,7 @@ struct Object {
                                                     void (*generate_psg_audio)(const struct ClownMDEmu* clownmdemu,
                                                                                cc_s16l* sample_buffer, size_t total_frames)) {
         Object* object = (Object*)user_data;
-        generate_psg_audio(clownmdemu, object->output.MixerAllocatePSGSamples(total_frames), total_frames);
+        object->output.MixerGeneratePSGSamples(clownmdemu, total_frames, generate_psg_audio);
     };
     
     object.callbacks.pcm_audio_to_be_generated = [](void* user_data, const struct ClownMDEmu* clownmdemu, size_t total_frames,
@@ -154,8 +190,7 @@ struct Object {
         
     }, NULL);
     
-    NSString *extension = [url.pathExtension lowercaseString];
-    if ([extension isEqualToString:@"cue"])
+    if (is_disc)
         return [self insertMegaDrive:url];
     else
         return [self insertGenesis:url];
@@ -200,12 +235,18 @@ struct Object {
     
     object.callbacks.cd_seeked = [](void* user_data, cc_u32f sector_index) {
         Object* object = (Object*)user_data;
-        CDReader_SeekToSector(&object->reader_state, sector_index);
+        if (object->sector_cache.IsOpen())
+            object->sector_cache.Seek(sector_index);
+        else
+            CDReader_SeekToSector(&object->reader_state, sector_index);
     };
     
     object.callbacks.cd_sector_read = [](void* user_data, cc_u16l *buffer) {
         Object* object = (Object*)user_data;
-        CDReader_ReadSector(&object->reader_state, buffer);
+        if (object->sector_cache.IsOpen())
+            object->sector_cache.Read(buffer);
+        else
+            CDReader_ReadSector(&object->reader_state, buffer);
     };
     
     object.callbacks.cd_track_seeked = [](void* user_data, cc_u16f track_index, ClownMDEmu_CDDAMode mode) -> cc_bool {
@@ -224,11 +265,16 @@ struct Object {
             case CLOWNMDEMU_CDDA_PLAY_REPEAT:
                 playback_setting = CDReader_PlaybackSetting::CDREADER_PLAYBACK_REPEAT;
                 break;
-        } return CDReader_PlayAudio(&object->reader_state, track_index, playback_setting);
+        }
+        if (object->audio_stream.IsOpen())
+            return object->audio_stream.Play(track_index, playback_setting);
+        return CDReader_PlayAudio(&object->reader_state, track_index, playback_setting);
     };
     
     object.callbacks.cd_audio_read = [](void* user_data, cc_s16l* sample_buffer, size_t total_frames) -> size_t {
         Object* object = (Object*)user_data;
+        if (object->audio_stream.IsOpen())
+            return object->audio_stream.Read(sample_buffer, total_frames);
         return CDReader_ReadAudio(&object->reader_state, sample_buffer, total_frames);
     };
     
@@ -286,17 +332,37 @@ struct Object {
         return SDL_WriteIO(static_cast<SDL_IOStream*>(stream), buffer, size * count) / size;
     };
     
+    const auto open_reader = [&](CDReader_State *reader_state) {
+        // Memory-mapping lets sector reads bypass SDL's stream callbacks entirely.
+        if ([[NSUserDefaults standardUserDefaults] boolForKey:@"plum.v1.38.mappedDiscIO"])
+            CDReader_Open(reader_state, NULL, [url.path UTF8String], ClownCD_GetMappedFileCallbacks());
+        else
+            CDReader_Open(reader_state, SDL_IOFromFile([url.path UTF8String], "rb"), [url.path UTF8String], &object.reader_callbacks);
+    };
+    
     CDReader_Initialise(&object.reader_state);
-    CDReader_Open(&object.reader_state, SDL_IOFromFile([url.path UTF8String], "rb"), [url.path UTF8String], &object.reader_callbacks);
+    open_reader(&object.reader_state);
+    
+    // Data sectors are read ahead on a thread of their own, leaving 'reader_state' to CD-DA playback.
+    object.sector_cache.Close();
+    if ([[NSUserDefaults standardUserDefaults] boolForKey:@"plum.v1.38.sectorReadAhead"])
+        object.sector_cache.Open(open_reader);
+    
+    // Likewise for CD-DA, which is decoded ahead of the play position.
+    object.audio_stream.Close();
+    if ([[NSUserDefaults standardUserDefaults] boolForKey:@"plum.v1.38.cddaDecodeAhead"])
+        object.audio_stream.Open(open_reader);
     
     auto region = static_cast<char>(object.rom.at(0x200));
     
     object.configuration.general.region = [@[@"E", @"U"] containsObject:@(region)] ? CLOWNMDEMU_REGION_OVERSEAS : CLOWNMDEMU_REGION_DOMESTIC;
     object.configuration.general.tv_standard = [@[@"J", @"U"] containsObject:@(region)] ? CLOWNMDEMU_TV_STANDARD_NTSC : CLOWNMDEMU_TV_STANDARD_PAL;
     object.output.SetPALMode(object.configuration.general.tv_standard == CLOWNMDEMU_TV_STANDARD_PAL);
+    object.configuration.general.mega_cd_detached = cc_false;
     
     ClownMDEmu_Constant_Initialise(&object.constant);
     ClownMDEmu_State_Initialise(&object.emu_state);
+    ClownMDEmu_MegaCDState_Initialise(object.mega_cd_state.get());
     ClownMDEmu_Reset(&object.emu, cc_true, [[NSNumber numberWithUnsignedInteger:object.rom_size] unsignedLongValue]);
     
     std::string io(reinterpret_cast<const char*>(&object.rom.at(0x1A0)), reinterpret_cast<const char*>(&object.rom.at(0x1A0 + 16)));
@@ -332,10 +398,24 @@ struct Object {
             
             auto frameStart = steady_clock::now();
             
+            // The mixer can only be reconfigured between frames.
+            if (object.output.GetBandLimitedPSG() != object.band_limited_psg.load())
+                object.output.SetBandLimitedPSG(object.band_limited_psg.load());
+            if (object.output.GetDeferredPSG() != object.deferred_psg.load())
+                object.output.SetDeferredPSG(&object.emu, object.deferred_psg.load());
+            
+            // Likewise, the SUB-CPU can only change threads between frames.
+            object.emu.sub_cpu_thread = object.threaded_sub_cpu.load() ? &object.sub_cpu_thread_callbacks : nullptr;
+            
             object.output.MixerBegin();
             ClownMDEmu_Iterate(&object.emu);
             object.output.MixerEnd();
             
+            {
+                std::lock_guard lock(object.statistics_mutex);
+                object.last_sub_cpu_idle_statistics = object.sub_cpu_idle_statistics;
+            }
+            
             if (auto buffer = [[PlumEmulator sharedInstance] framebuffer])
                 dispatch_async(dispatch_get_main_queue(), ^{
                     buffer(object.framebuffer.data(), object.width, object.height);
@@ -370,11 +450,44 @@ struct Object {
     object.paused.store(false);
 }
 
+-(NSDictionary<NSString *, NSNumber *> *) sectorCacheStatistics {
+    const auto statistics = object.sector_cache.GetStatistics();
+    return @{
+        @"hits" : @(statistics.hits),
+        @"misses" : @(statistics.misses),
+        @"stalls" : @(statistics.stalls)
+    };
+}
+
+-(NSDictionary<NSString *, NSNumber *> *) cdAudioStatistics {
+    const auto statistics = object.audio_stream.GetStatistics();
+    return @{
+        @"stalls" : @(statistics.stalls),
+        @"speculativeHits" : @(statistics.speculative_hits)
+    };
+}
+
+-(NSDictionary<NSString *, NSNumber *> *) subCPUIdleStatistics {
+    ClownMDEmu_SubCPUIdleStatistics statistics;
+    {
+        std::lock_guard lock(object.statistics_mutex);
+        statistics = object.last_sub_cpu_idle_statistics;
+    }
+    return @{
+        @"polls" : @(statistics.polls),
+        @"pollsSkipped" : @(statistics.polls_skipped),
+        @"cyclesSkipped" : @(statistics.cycles_skipped)
+    };
+}
+
 -(void) updateSettings {
     NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
     
     object.configuration.general.region = [userDefaults integerForKey:@"plum.v1.38.region"] == 0 ? CLOWNMDEMU_REGION_DOMESTIC : CLOWNMDEMU_REGION_OVERSEAS ;
     object.configuration.general.tv_standard = [userDefaults integerForKey:@"plum.v1.38.tvStandard"] == 0 ? CLOWNMDEMU_TV_STANDARD_NTSC : CLOWNMDEMU_TV_STANDARD_PAL;
+    object.band_limited_psg.store([userDefaults boolForKey:@"plum.v1.38.bandLimitedPSG"]);
+    object.deferred_psg.store([userDefaults boolForKey:@"plum.v1.38.deferredPSG"]);
+    object.threaded_sub_cpu.store([userDefaults boolForKey:@"plum.v1.38.threadedSubCPU"]);
 }
 
 -(void) input:(NSInteger)slot button:(uint32_t)button pressed:(BOOL)pressed {
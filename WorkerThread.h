@@ -0,0 +1,80 @@
+//
+//  WorkerThread.h
+//  Plum
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// A long-lived thread that runs one job at a time on behalf of the emulation thread.
+// The emulation thread hands a job over with 'Run', carries on with its own work, and collects the result with 'Wait'.
+class WorkerThread
+{
+private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::function<void()> job;
+    bool busy = false;
+    bool quitting = false;
+    std::thread thread;
+
+    void Loop()
+    {
+        std::unique_lock lock(mutex);
+
+        for (;;)
+        {
+            condition.wait(lock, [this]() { return busy || quitting; });
+
+            if (!busy)
+                return;
+
+            lock.unlock();
+            job();
+            lock.lock();
+
+            busy = false;
+            condition.notify_all();
+        }
+    }
+
+public:
+    WorkerThread()
+        : thread([this]() { Loop(); })
+    {}
+    WorkerThread(const WorkerThread&) = delete;
+    WorkerThread& operator=(const WorkerThread&) = delete;
+
+    ~WorkerThread()
+    {
+        {
+            std::lock_guard lock(mutex);
+            quitting = true;
+        }
+
+        // Any job that is still running is allowed to finish first.
+        condition.notify_all();
+        thread.join();
+    }
+
+    // Waits for the previous job, if there is one, before starting this one.
+    void Run(std::function<void()> new_job)
+    {
+        std::unique_lock lock(mutex);
+        condition.wait(lock, [this]() { return !busy; });
+
+        job = std::move(new_job);
+        busy = true;
+        condition.notify_all();
+    }
+
+    void Wait()
+    {
+        std::unique_lock lock(mutex);
+        condition.wait(lock, [this]() { return !busy; });
+    }
+};